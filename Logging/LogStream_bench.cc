@@ -55,6 +55,99 @@ void benchLogStream()
   printf("benchLogStream %f\n", timeDifference(end, start));
 }
 
+// 整数值的double对格式化来说太简单，这里用带小数的"延迟/指标"风格数据
+inline double latency(size_t i)
+{
+  return static_cast<double>(i % 100000) * 0.001 + 0.000123;
+}
+
+void benchPrintfDouble(const char* fmt)
+{
+  char buf[32];
+  Timestamp start(Timestamp::now());
+  for (size_t i = 0; i < N; ++i)
+    snprintf(buf, sizeof buf, fmt, latency(i));
+  Timestamp end(Timestamp::now());
+
+  printf("benchPrintf %f\n", timeDifference(end, start));
+}
+
+void benchStringStreamDouble()
+{
+  Timestamp start(Timestamp::now());
+  std::ostringstream os;
+  os.precision(17);
+
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << latency(i);
+    os.seekp(0, std::ios_base::beg);
+  }
+  Timestamp end(Timestamp::now());
+
+  printf("benchStringStream %f\n", timeDifference(end, start));
+}
+
+template<typename T>
+void benchLogStreamDouble()
+{
+  Timestamp start(Timestamp::now());
+  LogStream os;
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << static_cast<T>(latency(i));
+    os.resetBuffer();
+  }
+  Timestamp end(Timestamp::now());
+
+  printf("benchLogStream %f\n", timeDifference(end, start));
+}
+
+void benchStringStreamFixed()
+{
+  Timestamp start(Timestamp::now());
+  std::ostringstream os;
+  os.setf(std::ios_base::fixed);
+  os.precision(3);
+
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << latency(i);
+    os.seekp(0, std::ios_base::beg);
+  }
+  Timestamp end(Timestamp::now());
+
+  printf("benchStringStream %f\n", timeDifference(end, start));
+}
+
+void benchFmtFixed()
+{
+  Timestamp start(Timestamp::now());
+  LogStream os;
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << Fmt::fixed(latency(i), 3);
+    os.resetBuffer();
+  }
+  Timestamp end(Timestamp::now());
+
+  printf("benchFmtFixed %f\n", timeDifference(end, start));
+}
+
+void benchFmtPrintf()
+{
+  Timestamp start(Timestamp::now());
+  LogStream os;
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << Fmt("%.3f", latency(i));
+    os.resetBuffer();
+  }
+  Timestamp end(Timestamp::now());
+
+  printf("benchFmtPrintf %f\n", timeDifference(end, start));
+}
+
 int main()
 {
   benchPrintf<int>("%d");
@@ -69,6 +162,22 @@ int main()
   benchStringStream<double>();
   benchLogStream<double>();
 
+  // %.17g才能保证round-trip，与LogStream的最短表示对比
+  puts("double (fractional, round-trip)");
+  benchPrintfDouble("%.17g");
+  benchStringStreamDouble();
+  benchLogStreamDouble<double>();
+
+  puts("float (fractional, round-trip)");
+  benchPrintfDouble("%.9g");
+  benchLogStreamDouble<float>();
+
+  puts("double %.3f");
+  benchPrintfDouble("%.3f");
+  benchStringStreamFixed();
+  benchFmtPrintf();
+  benchFmtFixed();
+
   puts("int64_t");
   benchPrintf<int64_t>("%" PRId64);
   benchStringStream<int64_t>();
@@ -2,6 +2,7 @@
 
 #include <limits>
 #include <stdint.h>
+#include <stdlib.h>
 
 //#define BOOST_TEST_MODULE LogStreamTest
 #define BOOST_TEST_MAIN
@@ -150,8 +151,9 @@ BOOST_AUTO_TEST_CASE(testLogStreamFloats)
   BOOST_CHECK_EQUAL(buf.asString(), string("0.15"));
   os.resetBuffer();
 
+  // 最短往返表示，能区分a+b和c
   os << a+b;
-  BOOST_CHECK_EQUAL(buf.asString(), string("0.15"));
+  BOOST_CHECK_EQUAL(buf.asString(), string("0.15000000000000002"));
   os.resetBuffer();
 
   BOOST_CHECK(a+b != c);
@@ -167,6 +169,42 @@ BOOST_AUTO_TEST_CASE(testLogStreamFloats)
   os << -123.456;
   BOOST_CHECK_EQUAL(buf.asString(), string("-123.456"));
   os.resetBuffer();
+
+  os << 1e21;
+  BOOST_CHECK_EQUAL(buf.asString(), string("1e+21"));
+  os.resetBuffer();
+
+  os << 1e-5;
+  BOOST_CHECK_EQUAL(buf.asString(), string("1e-05"));
+  os.resetBuffer();
+
+  os << -0.0;
+  BOOST_CHECK_EQUAL(buf.asString(), string("-0"));
+  os.resetBuffer();
+
+  os << std::numeric_limits<double>::infinity();
+  BOOST_CHECK_EQUAL(buf.asString(), string("inf"));
+  os.resetBuffer();
+
+  os << 0.1f;
+  BOOST_CHECK_EQUAL(buf.asString(), string("0.1"));
+  os.resetBuffer();
+
+  os << 1.0f/3;
+  BOOST_CHECK_EQUAL(buf.asString(), string("0.33333334"));
+  os.resetBuffer();
+}
+
+BOOST_AUTO_TEST_CASE(testLogStreamFloatsRoundTrip)
+{
+  const double values[] = { 0.1, 1.0/3, 2.0/3, 1e100, 1e-100, 5e-324,
+                            1.7976931348623157e308, 123456.789, 3.14159 };
+  for (size_t i = 0; i < sizeof values / sizeof values[0]; ++i)
+  {
+    muduo::LogStream os;
+    os << values[i];
+    BOOST_CHECK_EQUAL(strtod(os.buffer().asString().c_str(), NULL), values[i]);
+  }
 }
 
 BOOST_AUTO_TEST_CASE(testLogStreamVoid)
@@ -212,6 +250,18 @@ BOOST_AUTO_TEST_CASE(testLogStreamFmts)
   os << muduo::Fmt("%4.2f", 1.2) << muduo::Fmt("%4d", 43);
   BOOST_CHECK_EQUAL(buf.asString(), string("1.20  43"));
   os.resetBuffer();
+
+  os << muduo::Fmt::fixed(1.2, 2);
+  BOOST_CHECK_EQUAL(buf.asString(), string("1.20"));
+  os.resetBuffer();
+
+  os << muduo::Fmt::fixed(-0.0005, 3) << ' ' << muduo::Fmt::fixed(2.5, 0);
+  BOOST_CHECK_EQUAL(buf.asString(), string("-0.001 2"));
+  os.resetBuffer();
+
+  os << muduo::Fmt::fixed(1.005, 2);
+  BOOST_CHECK_EQUAL(buf.asString(), string("1.00"));
+  os.resetBuffer();
 }
 
 BOOST_AUTO_TEST_CASE(testLogStreamLong)
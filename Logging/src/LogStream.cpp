@@ -4,7 +4,9 @@
 #include <assert.h>
 #include <boost/static_assert.hpp>
 #include <boost/type_traits/is_arithmetic.hpp>
+#include <float.h>
 #include <limits>
+#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -63,6 +65,337 @@ size_t convertHex(char buf[], uintptr_t value) {
   return p - buf;
 }
 
+
+// Grisu2, by Florian Loitsch.
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010.
+// 生成的数字串总能精确地转换回原值（round-trip），绝大多数情况下也是最短的。
+struct DiyFp {
+  DiyFp() : f(0), e(0) {}
+  DiyFp(uint64_t fp, int exp) : f(fp), e(exp) {}
+
+  DiyFp operator-(const DiyFp &rhs) const { return DiyFp(f - rhs.f, e); }
+
+  DiyFp operator*(const DiyFp &rhs) const {
+    unsigned __int128 p = static_cast<unsigned __int128>(f) * rhs.f;
+    uint64_t h = static_cast<uint64_t>(p >> 64);
+    uint64_t l = static_cast<uint64_t>(p);
+    if (l & (UINT64_C(1) << 63)) { // rounding
+      ++h;
+    }
+    return DiyFp(h, e + rhs.e + 64);
+  }
+
+  DiyFp normalize() const {
+    int s = __builtin_clzll(f);
+    return DiyFp(f << s, e - s);
+  }
+
+  uint64_t f;
+  int e;
+};
+
+// 10^k的64位规格化近似值，k = -348, -340, ..., 340
+const uint64_t kCachedPowersF[] = {
+    UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76), UINT64_C(0x8b16fb203055ac76),
+    UINT64_C(0xcf42894a5dce35ea), UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+    UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f), UINT64_C(0xbe5691ef416bd60c),
+    UINT64_C(0x8dd01fad907ffc3c), UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+    UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d), UINT64_C(0x823c12795db6ce57),
+    UINT64_C(0xc21094364dfb5637), UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+    UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5), UINT64_C(0xb23867fb2a35b28e),
+    UINT64_C(0x84c8d4dfd2c63f3b), UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+    UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6), UINT64_C(0xf3e2f893dec3f126),
+    UINT64_C(0xb5b5ada8aaff80b8), UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+    UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd), UINT64_C(0xa6dfbd9fb8e5b88f),
+    UINT64_C(0xf8a95fcf88747d94), UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+    UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac), UINT64_C(0xe45c10c42a2b3b06),
+    UINT64_C(0xaa242499697392d3), UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+    UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c), UINT64_C(0x9c40000000000000),
+    UINT64_C(0xe8d4a51000000000), UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+    UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70), UINT64_C(0xd5d238a4abe98068),
+    UINT64_C(0x9f4f2726179a2245), UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+    UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a), UINT64_C(0x924d692ca61be758),
+    UINT64_C(0xda01ee641a708dea), UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+    UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2), UINT64_C(0xc83553c5c8965d3d),
+    UINT64_C(0x952ab45cfa97a0b3), UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+    UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece), UINT64_C(0x88fcf317f22241e2),
+    UINT64_C(0xcc20ce9bd35c78a5), UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+    UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c), UINT64_C(0xbb764c4ca7a44410),
+    UINT64_C(0x8bab8eefb6409c1a), UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+    UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429), UINT64_C(0x80444b5e7aa7cf85),
+    UINT64_C(0xbf21e44003acdd2d), UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+    UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9), UINT64_C(0xaf87023b9bf0ee6b),
+};
+
+const int16_t kCachedPowersE[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+const uint64_t kPow10[] = {
+    UINT64_C(1),
+    UINT64_C(10),
+    UINT64_C(100),
+    UINT64_C(1000),
+    UINT64_C(10000),
+    UINT64_C(100000),
+    UINT64_C(1000000),
+    UINT64_C(10000000),
+    UINT64_C(100000000),
+    UINT64_C(1000000000),
+    UINT64_C(10000000000),
+    UINT64_C(100000000000),
+    UINT64_C(1000000000000),
+    UINT64_C(10000000000000),
+    UINT64_C(100000000000000),
+    UINT64_C(1000000000000000),
+    UINT64_C(10000000000000000),
+    UINT64_C(100000000000000000),
+    UINT64_C(1000000000000000000),
+    UINT64_C(10000000000000000000),
+};
+BOOST_STATIC_ASSERT(sizeof kCachedPowersF / sizeof kCachedPowersF[0] == 87);
+BOOST_STATIC_ASSERT(sizeof kCachedPowersE / sizeof kCachedPowersE[0] == 87);
+
+DiyFp cachedPower(int e, int *K) {
+  // dk = ceil((-61 - e) * log10(2)) + 347
+  double dk = (-61 - e) * 0.30102999566398114 + 347;
+  int k = static_cast<int>(dk);
+  if (dk - k > 0.0) {
+    ++k;
+  }
+  unsigned index = static_cast<unsigned>((k >> 3) + 1);
+  *K = -(-348 + static_cast<int>(index << 3));
+  return DiyFp(kCachedPowersF[index], kCachedPowersE[index]);
+}
+
+int countDecimalDigit32(uint32_t n) {
+  int count = 1;
+  while (n >= 10) {
+    n /= 10;
+    ++count;
+  }
+  return count;
+}
+
+void grisuRound(char *buffer, int len, uint64_t delta, uint64_t rest,
+                uint64_t tenKappa, uint64_t wpw) {
+  while (rest < wpw && delta - rest >= tenKappa &&
+         (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw)) {
+    buffer[len - 1]--;
+    rest += tenKappa;
+  }
+}
+
+void digitGen(const DiyFp &W, const DiyFp &Mp, uint64_t delta, char *buffer,
+              int *len, int *K) {
+  const DiyFp one(UINT64_C(1) << -Mp.e, Mp.e);
+  const DiyFp wpw = Mp - W;
+  uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+  uint64_t p2 = Mp.f & (one.f - 1);
+  int kappa = countDecimalDigit32(p1);
+  *len = 0;
+
+  while (kappa > 0) {
+    uint32_t d = static_cast<uint32_t>(p1 / kPow10[kappa - 1]);
+    p1 = static_cast<uint32_t>(p1 % kPow10[kappa - 1]);
+    if (d || *len) {
+      buffer[(*len)++] = static_cast<char>('0' + d);
+    }
+    --kappa;
+    uint64_t tmp = (static_cast<uint64_t>(p1) << -one.e) + p2;
+    if (tmp <= delta) {
+      *K += kappa;
+      grisuRound(buffer, *len, delta, tmp, kPow10[kappa] << -one.e, wpw.f);
+      return;
+    }
+  }
+
+  for (;;) {
+    p2 *= 10;
+    delta *= 10;
+    char d = static_cast<char>(p2 >> -one.e);
+    if (d || *len) {
+      buffer[(*len)++] = static_cast<char>('0' + d);
+    }
+    p2 &= one.f - 1;
+    --kappa;
+    if (p2 < delta) {
+      *K += kappa;
+      int index = -kappa;
+      grisuRound(buffer, *len, delta, p2, one.f,
+                 wpw.f * (index < 20 ? kPow10[index] : 0));
+      return;
+    }
+  }
+}
+
+// 值为 f * 2^e；lowerCloser表示下一个更小的浮点数离得更近（f是2的幂）
+void grisu2(uint64_t f, int e, bool lowerCloser, char *digits, int *len,
+            int *K) {
+  const DiyFp v(f, e);
+  DiyFp plus = DiyFp((f << 1) + 1, e - 1).normalize();
+  DiyFp minus = lowerCloser ? DiyFp((f << 2) - 1, e - 2)
+                            : DiyFp((f << 1) - 1, e - 1);
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+
+  const DiyFp c = cachedPower(plus.e, K);
+  const DiyFp W = v.normalize() * c;
+  DiyFp Wp = plus * c;
+  DiyFp Wm = minus * c;
+  ++Wm.f;
+  --Wp.f;
+  digitGen(W, Wp, Wp.f - Wm.f, digits, len, K);
+}
+
+// 把 0.d1d2...dn * 10^(len+K) 排成与"%.17g"相同的形式：
+// 1e-4 <= |v| < 1e17 用定点表示，否则用d.ddde+XX
+size_t prettify(char *buf, const char *digits, int len, int K) {
+  const int kk = len + K; // 小数点位置
+  char *p = buf;
+
+  if (kk > 0 && kk <= 17) {
+    if (len <= kk) {
+      // 1234e3 -> 1234000
+      memcpy(p, digits, len);
+      p += len;
+      memset(p, '0', kk - len);
+      p += kk - len;
+    } else {
+      // 1234e-2 -> 12.34
+      memcpy(p, digits, kk);
+      p += kk;
+      *p++ = '.';
+      memcpy(p, digits + kk, len - kk);
+      p += len - kk;
+    }
+  } else if (kk > -4 && kk <= 0) {
+    // 1234e-6 -> 0.001234
+    *p++ = '0';
+    *p++ = '.';
+    memset(p, '0', -kk);
+    p += -kk;
+    memcpy(p, digits, len);
+    p += len;
+  } else {
+    // 1234e30 -> 1.234e+33
+    *p++ = digits[0];
+    if (len > 1) {
+      *p++ = '.';
+      memcpy(p, digits + 1, len - 1);
+      p += len - 1;
+    }
+    int exp10 = kk - 1;
+    *p++ = 'e';
+    if (exp10 < 0) {
+      *p++ = '-';
+      exp10 = -exp10;
+    } else {
+      *p++ = '+';
+    }
+    if (exp10 < 10) {
+      *p++ = '0';
+    }
+    p += convert(p, exp10);
+  }
+  *p = '\0';
+  return p - buf;
+}
+
+// 符号、零、无穷和NaN与printf的输出一致
+template <typename UInt, int kSignificandBits, int kExponentBias>
+size_t formatFloatingPoint(char buf[], UInt bits) {
+  const int kTotalBits = static_cast<int>(sizeof(UInt) * 8);
+  const UInt kSignificandMask = (UInt(1) << kSignificandBits) - 1;
+  const int kExponentMask = (1 << (kTotalBits - 1 - kSignificandBits)) - 1;
+
+  char *p = buf;
+  if (bits >> (kTotalBits - 1)) {
+    *p++ = '-';
+  }
+  UInt significand = bits & kSignificandMask;
+  int biased = static_cast<int>(bits >> kSignificandBits) & kExponentMask;
+  if (biased == kExponentMask) {
+    const char *s = significand ? "nan" : "inf";
+    memcpy(p, s, 4);
+    return p + 3 - buf;
+  }
+  if (biased == 0 && significand == 0) {
+    *p++ = '0';
+    *p = '\0';
+    return p - buf;
+  }
+
+  uint64_t f = significand;
+  int e = 1 - kExponentBias; // denormal
+  if (biased != 0) {
+    f += UInt(1) << kSignificandBits;
+    e = biased - kExponentBias;
+  }
+  char digits[32];
+  int len = 0;
+  int K = 0;
+  grisu2(f, e, significand == 0 && biased > 1, digits, &len, &K);
+  return p - buf + prettify(p, digits, len, K);
+}
+
+size_t formatDouble(char buf[], double v) {
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof bits);
+  return formatFloatingPoint<uint64_t, 52, 1075>(buf, bits);
+}
+
+size_t formatFloat(char buf[], float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, sizeof bits);
+  return formatFloatingPoint<uint32_t, 23, 150>(buf, bits);
+}
+
+// 快速路径最长输出：符号 + 17位数字 + 小数点 + '\0'
+const size_t kMaxFixedSize = 24;
+
+// 等价于snprintf("%.*f")。|v| * 10^precision 在2^53以内时直接做整数运算，
+// 只有舍入结果可能因乘法误差而不确定（恰好在.5附近）时才退回snprintf。
+size_t formatFixed(char buf[], size_t size, double v, int precision) {
+  if (precision >= 0 && precision <= 9 && size >= kMaxFixedSize) {
+    double scaled = fabs(v) * static_cast<double>(kPow10[precision]);
+    if (scaled < 9007199254740992.0) { // 2^53, 同时排除了inf和nan
+      double r = floor(scaled);
+      double frac = scaled - r;
+      if (fabs(frac - 0.5) > scaled * DBL_EPSILON) {
+        uint64_t n = static_cast<uint64_t>(r) + (frac > 0.5 ? 1 : 0);
+        uint64_t intPart = n / kPow10[precision];
+        uint64_t fracPart = n % kPow10[precision];
+        char *p = buf;
+        if (signbit(v)) {
+          *p++ = '-';
+        }
+        p += convert(p, intPart);
+        if (precision > 0) {
+          *p++ = '.';
+          char *end = p + precision;
+          for (char *q = end - 1; q >= p; --q) {
+            *q = static_cast<char>('0' + fracPart % 10);
+            fracPart /= 10;
+          }
+          p = end;
+        }
+        *p = '\0';
+        return p - buf;
+      }
+    }
+  }
+  return snprintf(buf, size, "%.*f", precision, v);
+}
+
 } // namespace detail
 } // namespace muduo
 
@@ -148,10 +481,19 @@ LogStream &LogStream::operator<<(const void *p) {
   return *this;
 }
 
-// FIXME: replace this with Grisu3 by Florian Loitsch.
+// 最短往返表示，例如0.1输出0.1，0.1+0.2输出0.30000000000000004
 LogStream &LogStream::operator<<(double v) {
   if (buffer_.avail() >= kMaxNumericSize) {
-    int len = snprintf(buffer_.current(), kMaxNumericSize, "%.12g", v);
+    size_t len = formatDouble(buffer_.current(), v);
+    buffer_.add(len);
+  }
+  return *this;
+}
+
+// 按float的精度取最短表示，0.1f输出0.1而不是0.100000001490116
+LogStream &LogStream::operator<<(float v) {
+  if (buffer_.avail() >= kMaxNumericSize) {
+    size_t len = formatFloat(buffer_.current(), v);
     buffer_.add(len);
   }
   return *this;
@@ -165,6 +507,14 @@ template <typename T> Fmt::Fmt(const char *fmt, T val) {
   assert(static_cast<size_t>(length_) < sizeof buf_);
 }
 
+Fmt Fmt::fixed(double v, int precision) {
+  Fmt fmt;
+  fmt.length_ = static_cast<int>(
+      formatFixed(fmt.buf_, sizeof fmt.buf_, v, precision));
+  assert(static_cast<size_t>(fmt.length_) < sizeof fmt.buf_);
+  return fmt;
+}
+
 // Explicit instantiations
 
 template Fmt::Fmt(const char *fmt, char);
@@ -0,0 +1,212 @@
+#include "BlockingQueue.h"
+#include "BoundedBlockingQueue.h"
+#include "BoundedMpmcQueue.h"
+#include "Thread.h"
+#include "Timestamp.h"
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <algorithm>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+using namespace muduo;
+
+// 生产者/消费者之间传递kItems个int，比较逐个put()/take()与
+// putAll()/drainTo()批量传递的吞吐量
+const int kItems = 2 * 1000 * 1000;
+const int kQueueSize = 4096;
+const int kStop = -1;
+
+template<typename Queue>
+void produceOne(Queue* queue, int items, int)
+{
+  for (int i = 0; i < items; ++i)
+    queue->put(i);
+}
+
+template<typename Queue>
+void produceBatch(Queue* queue, int items, int batch)
+{
+  std::vector<int> buf;
+  buf.reserve(batch);
+  for (int i = 0; i < items; ++i)
+  {
+    buf.push_back(i);
+    if (static_cast<int>(buf.size()) == batch)
+    {
+      queue->putAll(buf);
+      buf.clear();
+    }
+  }
+  queue->putAll(buf);
+}
+
+template<typename Queue>
+void consumeOne(Queue* queue, int)
+{
+  while (queue->take() != kStop)
+    ;
+}
+
+template<typename Queue>
+void consumeBatch(Queue* queue, int batch)
+{
+  std::vector<int> buf;
+  buf.reserve(batch);
+  for (;;)
+  {
+    buf.clear();
+    queue->drainTo(&buf, batch);
+    for (size_t i = 0; i < buf.size(); ++i)
+    {
+      if (buf[i] == kStop)
+      {
+        // 同一批里可能还有给其他消费者的结束标记，放回去
+        std::vector<int> rest(buf.begin() + i + 1, buf.end());
+        queue->putAll(rest);
+        return;
+      }
+    }
+  }
+}
+
+template<typename Queue>
+double run(Queue* queue, int producers, int consumers, int batch,
+           void (*produce)(Queue*, int, int), void (*consume)(Queue*, int))
+{
+  boost::ptr_vector<Thread> threads;
+  for (int i = 0; i < consumers; ++i)
+    threads.push_back(new Thread(boost::bind(consume, queue, batch)));
+  for (int i = 0; i < producers; ++i)
+    threads.push_back(new Thread(boost::bind(produce, queue,
+                                             kItems / producers, batch)));
+
+  Timestamp start(Timestamp::now());
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].start();
+  for (int i = 0; i < producers; ++i)
+    threads[consumers + i].join();
+  for (int i = 0; i < consumers; ++i)
+    queue->put(kStop);
+  for (int i = 0; i < consumers; ++i)
+    threads[i].join();
+  Timestamp end(Timestamp::now());
+
+  return kItems / timeDifference(end, start);
+}
+
+template<typename Queue>
+double benchOne(Queue* queue, int producers, int consumers)
+{
+  return run(queue, producers, consumers, 1,
+             &produceOne<Queue>, &consumeOne<Queue>);
+}
+
+template<typename Queue>
+double bench(Queue* queue, int producers, int consumers, int batch)
+{
+  if (batch <= 1)
+    return benchOne(queue, producers, consumers);
+  return run(queue, producers, consumers, batch,
+             &produceBatch<Queue>, &consumeBatch<Queue>);
+}
+
+int64_t nowNanos()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+// 单个元素从put()到take()返回的延迟。生产者每隔kIntervalNanos才放一个，
+// 测的是交接本身（含唤醒），而不是排队
+const int kLatencyItems = 100 * 1000;
+const int64_t kIntervalNanos = 20 * 1000;
+
+template<typename Queue>
+void consumeLatency(Queue* queue, std::vector<int64_t>* latencies)
+{
+  for (int i = 0; i < kLatencyItems; ++i)
+  {
+    int64_t sent = queue->take();
+    latencies->push_back(nowNanos() - sent);
+  }
+}
+
+template<typename Queue>
+void benchLatency(const char* name)
+{
+  Queue queue(kQueueSize);
+  std::vector<int64_t> latencies;
+  latencies.reserve(kLatencyItems);
+  Thread consumer(boost::bind(&consumeLatency<Queue>, &queue, &latencies));
+  consumer.start();
+  for (int i = 0; i < kLatencyItems; ++i)
+  {
+    int64_t next = nowNanos() + kIntervalNanos;
+    queue.put(nowNanos());
+    while (nowNanos() < next)
+      ;
+  }
+  consumer.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  printf("%-22s p50 %8.2fus p99 %8.2fus p999 %8.2fus\n", name,
+         latencies[latencies.size() / 2] / 1000.0,
+         latencies[latencies.size() * 99 / 100] / 1000.0,
+         latencies[latencies.size() * 999 / 1000] / 1000.0);
+}
+
+int main()
+{
+  const int kConfigs[][2] = { { 1, 1 }, { 1, 4 }, { 4, 1 }, { 4, 4 } };
+  const int kBatches[] = { 1, 16, 64, 256 };
+
+  printf("items per second\n");
+  printf("%10s %6s %14s %14s\n", "prod/cons", "batch", "unbounded", "bounded");
+  for (size_t c = 0; c < sizeof kConfigs / sizeof kConfigs[0]; ++c)
+  {
+    for (size_t b = 0; b < sizeof kBatches / sizeof kBatches[0]; ++b)
+    {
+      int producers = kConfigs[c][0];
+      int consumers = kConfigs[c][1];
+      BlockingQueue<int> unbounded;
+      BoundedBlockingQueue<int> bounded(kQueueSize);
+      double u = bench(&unbounded, producers, consumers, kBatches[b]);
+      double d = bench(&bounded, producers, consumers, kBatches[b]);
+      printf("%6d/%-3d %6d %14.0f %14.0f\n",
+             producers, consumers, kBatches[b], u, d);
+    }
+  }
+
+  // 逐个put()/take()：mutex + Condition与无锁MPMC队列
+  printf("\nitem-at-a-time, items per second\n");
+  printf("%10s %14s %14s\n", "prod/cons", "bounded", "mpmc");
+  for (size_t c = 0; c < sizeof kConfigs / sizeof kConfigs[0]; ++c)
+  {
+    int producers = kConfigs[c][0];
+    int consumers = kConfigs[c][1];
+    BoundedBlockingQueue<int> bounded(kQueueSize);
+    BoundedMpmcQueue<int> mpmc(kQueueSize);
+    double d = benchOne(&bounded, producers, consumers);
+    double m = benchOne(&mpmc, producers, consumers);
+    printf("%6d/%-3d %14.0f %14.0f\n", producers, consumers, d, m);
+  }
+
+  printf("\nhandoff latency\n");
+  benchLatency<BoundedBlockingQueue<int64_t> >("BoundedBlockingQueue");
+  benchLatency<BoundedMpmcQueue<int64_t> >("BoundedMpmcQueue");
+
+  // 超时接口的简单检查
+  BlockingQueue<int> queue;
+  int x = 0;
+  Timestamp start(Timestamp::now());
+  bool got = queue.take(&x, 0.05);
+  printf("take(50ms) on empty queue: %s after %.3fs\n",
+         got ? "got" : "timeout", timeDifference(Timestamp::now(), start));
+  queue.put(42);
+  printf("poll: %d\n", queue.poll(&x) ? x : -1);
+}
@@ -0,0 +1,112 @@
+#include "BoundedMpmcQueue.h"
+#include "CountDownLatch.h"
+#include "Thread.h"
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <assert.h>
+#include <atomic>
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace muduo;
+
+// 容量很小，生产者和消费者轮流快慢，让两边都经常在futex上睡眠。
+// 漏掉唤醒时会有线程一直睡着，alarm()到时间就失败
+const int kProducers = 4;
+const int kConsumers = 4;
+const int kItemsPerThread = 20000;
+const int kRounds = 5;
+const int kTimeoutSeconds = 120;
+
+std::atomic<int64_t> g_sum;
+std::atomic<int> g_taken;
+
+// 第round轮里前半程慢、后半程快，另一边正好相反
+void pause(int i, int round, bool producer) {
+  bool slowFirst = (round % 2 == 0) == producer;
+  bool firstHalf = i < kItemsPerThread / 2;
+  if (slowFirst == firstHalf && i % 1000 == 0) {
+    ::usleep(1000);
+  }
+}
+
+void produce(BoundedMpmcQueue<int> *queue, int id, int round,
+             CountDownLatch *latch) {
+  latch->countDown();
+  latch->wait();
+  for (int i = 0; i < kItemsPerThread; ++i) {
+    pause(i, round, true);
+    queue->put(id * kItemsPerThread + i);
+  }
+}
+
+void consume(BoundedMpmcQueue<int> *queue, int round, CountDownLatch *latch) {
+  latch->countDown();
+  latch->wait();
+  for (int i = 0; i < kItemsPerThread; ++i) {
+    pause(i, round, false);
+    int x = queue->take();
+    g_sum += x;
+    ++g_taken;
+  }
+}
+
+void runRound(int round) {
+  BoundedMpmcQueue<int> queue(2);
+  CountDownLatch latch(kProducers + kConsumers);
+  g_sum = 0;
+  g_taken = 0;
+  boost::ptr_vector<Thread> threads;
+  for (int i = 0; i < kProducers; ++i) {
+    threads.push_back(
+        new Thread(boost::bind(&produce, &queue, i, round, &latch)));
+  }
+  for (int i = 0; i < kConsumers; ++i) {
+    threads.push_back(new Thread(boost::bind(&consume, &queue, round, &latch)));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].start();
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  const int64_t n = static_cast<int64_t>(kProducers) * kItemsPerThread;
+  assert(g_taken == n);
+  assert(g_sum == n * (n - 1) / 2);
+  assert(queue.size() == 0);
+  printf("round %d: %lld items\n", round, static_cast<long long>(n));
+}
+
+// 只剩一个元素时，一个消费者重试成功、另一个正在睡眠：
+// 成功的那个不能注销别人的登记
+void testParkedConsumers() {
+  for (int iter = 0; iter < 2000; ++iter) {
+    BoundedMpmcQueue<int> queue(4);
+    Thread c1(boost::bind(&BoundedMpmcQueue<int>::take, &queue));
+    Thread c2(boost::bind(&BoundedMpmcQueue<int>::take, &queue));
+    c1.start();
+    c2.start();
+    queue.put(1);
+    if (iter % 2 == 0) {
+      ::usleep(10);
+    }
+    queue.put(2);
+    c1.join();
+    c2.join();
+    assert(queue.size() == 0);
+  }
+  printf("parked consumers: ok\n");
+}
+
+int main() {
+  ::alarm(kTimeoutSeconds);
+  testParkedConsumers();
+  for (int round = 0; round < kRounds; ++round) {
+    runRound(round);
+  }
+  printf("done\n");
+}
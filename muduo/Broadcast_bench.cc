@@ -0,0 +1,112 @@
+#include "Buffer.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "LengthHeaderCodec.h"
+#include "Logging.h"
+#include "SharedPayload.h"
+#include "TcpConnection.h"
+#include "Timestamp.h"
+
+#include <boost/bind.hpp>
+
+#include <malloc.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// 向kConnections个连接广播kMessages条16KB的消息，对端都不读，
+// 几乎全部留在各连接的输出队列里。比较每个连接各编码（复制）一次
+// 和只编码一次的SharedPayload：发送用时和堆内存增长
+const int kConnections = 1000;
+const int kMessages = 8;
+const size_t kMessageSize = 16 * 1024;
+const int kSocketBuffer = 4 * 1024;
+
+void onMessage(const TcpConnectionPtr &, Buffer *buf, Timestamp) {
+  buf->retrieveAll();
+}
+
+void noop(const StringPiece &) {}
+
+struct Fixture {
+  explicit Fixture(EventLoop *loop) {
+    for (int i = 0; i < kConnections; ++i) {
+      int fds[2];
+      if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+                       fds) < 0) {
+        LOG_SYSFATAL << "socketpair";
+      }
+      ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &kSocketBuffer,
+                   sizeof kSocketBuffer);
+      ::setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &kSocketBuffer,
+                   sizeof kSocketBuffer);
+      char name[32];
+      snprintf(name, sizeof name, "conn#%d", i);
+      InetAddress addr(InetAddress::unixDomain("@muduo_Broadcast_bench"));
+      TcpConnectionPtr conn(new TcpConnection(loop, name, fds[0], addr, addr));
+      conn->setConnectionCallback(defaultConnectionCallback);
+      conn->setMessageCallback(onMessage);
+      conn->connectEstablished();
+      conns.push_back(conn);
+      peers.push_back(fds[1]);
+    }
+  }
+
+  ~Fixture() {
+    for (size_t i = 0; i < conns.size(); ++i) {
+      conns[i]->connectDestroyed();
+      ::close(peers[i]);
+    }
+  }
+
+  std::vector<TcpConnectionPtr> conns;
+  std::vector<int> peers;
+};
+
+// 大块内存由mmap()分配，不算在uordblks里
+size_t heapInUse() {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+void report(const char *name, bool shared) {
+  EventLoop loop;
+  Fixture fixture(&loop);
+  LengthHeaderCodec codec(boost::bind(&noop, _2)); // 只用来编码
+  string message(kMessageSize, 'b');
+
+  size_t before = heapInUse();
+  Timestamp start(Timestamp::now());
+  for (int m = 0; m < kMessages; ++m) {
+    if (shared) {
+      SharedPayload frame(codec.encodeShared(message));
+      for (size_t i = 0; i < fixture.conns.size(); ++i) {
+        fixture.conns[i]->send(frame);
+      }
+    } else {
+      for (size_t i = 0; i < fixture.conns.size(); ++i) {
+        codec.send(fixture.conns[i], message);
+      }
+    }
+  }
+  double seconds = timeDifference(Timestamp::now(), start);
+  size_t after = heapInUse();
+  double queued = static_cast<double>(kConnections) * kMessages *
+                  static_cast<double>(kMessageSize);
+  printf("%-28s %10.2f %14.1f %14.1f\n", name, seconds * 1000,
+         static_cast<double>(after - before) / (1024 * 1024),
+         queued / (1024 * 1024));
+}
+
+int main() {
+  Logger::setLogLevel(Logger::WARN);
+  printf("%d connections, %d x %zu-byte messages\n", kConnections, kMessages,
+         kMessageSize);
+  printf("%-28s %10s %14s %14s\n", "", "ms", "heap MiB", "payload MiB");
+  report("per-connection encode", false);
+  report("SharedPayload", true);
+}
@@ -0,0 +1,146 @@
+#include "Buffer.h"
+#include "CharSearch.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// 1. 在充满文本行的缓冲区里逐行找CRLF，比较原来的std::search与
+//    标量/SSE2/AVX2实现
+// 2. 一行数据分多次到达时，每次从头扫描与接着上次扫描的差别
+const size_t kTotalBytes = 4 * 1024 * 1024;
+const int kRounds = 20;
+
+string makeLines(size_t lineLength) {
+  string s;
+  s.reserve(kTotalBytes + lineLength);
+  unsigned r = 1;
+  while (s.size() < kTotalBytes) {
+    for (size_t i = 0; i + 2 < lineLength; ++i) {
+      r = r * 1103515245 + 12345;
+      // 偶尔出现单独的'\r'，标量实现要多做一次判断
+      char c = (r >> 16) % 97 == 0 ? '\r'
+                                   : static_cast<char>(' ' + (r >> 16) % 95);
+      s += c;
+    }
+    s += "\r\n";
+  }
+  return s;
+}
+
+const char *searchCRLF(const char *begin, const char *end) {
+  static const char kCRLF[] = "\r\n";
+  const char *crlf = std::search(begin, end, kCRLF, kCRLF + 2);
+  return crlf == end ? NULL : crlf;
+}
+
+template <typename Find>
+double bench(const string &data, Find find, int *lines) {
+  const char *end = data.data() + data.size();
+  Timestamp start(Timestamp::now());
+  for (int round = 0; round < kRounds; ++round) {
+    int n = 0;
+    const char *p = data.data();
+    const char *crlf;
+    while ((crlf = find(p, end)) != NULL) {
+      ++n;
+      p = crlf + 2;
+    }
+    *lines = n;
+  }
+  double seconds = timeDifference(Timestamp::now(), start);
+  return static_cast<double>(data.size()) * kRounds / seconds / 1e6;
+}
+
+double benchLevel(const string &data, detail::SimdLevel level, int *lines) {
+  if (detail::setSimdLevel(level) != level) {
+    return 0;
+  }
+  return bench(data, &detail::findCRLF, lines);
+}
+
+// 一行lineLength字节的数据按chunk字节分批到达，每批之后找一次CRLF
+double benchArrival(size_t lineLength, size_t chunk, bool resume) {
+  string line(lineLength - 2, 'x');
+  line += "\r\n";
+  const int kLines = 2000;
+  Timestamp start(Timestamp::now());
+  Buffer buf;
+  for (int i = 0; i < kLines; ++i) {
+    size_t scanned = 0;
+    const char *crlf = NULL;
+    for (size_t off = 0; crlf == NULL; off += chunk) {
+      buf.append(line.data() + off, std::min(chunk, line.size() - off));
+      crlf = resume ? buf.findCRLF(&scanned) : buf.findCRLF();
+    }
+    assert(crlf + 2 == buf.peek() + buf.readableBytes());
+    buf.retrieveUntil(crlf + 2);
+  }
+  return kLines / timeDifference(Timestamp::now(), start);
+}
+
+void verify() {
+  // 所有实现在各种边界上结果相同，包括'\r'和'\n'跨越16/32字节的块
+  string s(200, 'a');
+  for (size_t i = 0; i + 1 < s.size(); ++i) {
+    for (size_t j = i + 1; j < s.size(); ++j) {
+      string t = s;
+      t[i] = '\r';
+      t[j] = '\n';
+      const char *expect = searchCRLF(t.data(), t.data() + t.size());
+      for (int level = detail::kScalar; level <= detail::kAvx2; ++level) {
+        detail::setSimdLevel(static_cast<detail::SimdLevel>(level));
+        assert(detail::findCRLF(t.data(), t.data() + t.size()) == expect);
+        assert(detail::findAnyOf(t.data(), t.data() + t.size(), "\n\r", 2) ==
+               t.data() + i);
+      }
+    }
+  }
+
+  Buffer buf;
+  size_t scanned = 0;
+  buf.append("abc\r");
+  assert(buf.findCRLF(&scanned) == NULL && scanned == 4);
+  buf.append("\ndef");
+  assert(buf.findCRLF(&scanned) == buf.peek() + 3);
+  (void)scanned;
+}
+
+int main() {
+  verify();
+  detail::SimdLevel detected = detail::simdLevel();
+
+  const size_t kLineLengths[] = {16, 80, 256, 1024, 4096};
+  printf("find CRLF in %zu MB of lines, MB/s\n", kTotalBytes >> 20);
+  printf("%6s %12s %12s %12s %12s\n", "line", "std::search", "scalar", "sse2",
+         "avx2");
+  for (size_t i = 0; i < sizeof kLineLengths / sizeof kLineLengths[0]; ++i) {
+    string data = makeLines(kLineLengths[i]);
+    int expected = 0;
+    int lines = 0;
+    double base = bench(data, &searchCRLF, &expected);
+    double scalar = benchLevel(data, detail::kScalar, &lines);
+    assert(lines == expected);
+    double sse2 = benchLevel(data, detail::kSse2, &lines);
+    assert(sse2 == 0 || lines == expected);
+    double avx2 = benchLevel(data, detail::kAvx2, &lines);
+    assert(avx2 == 0 || lines == expected);
+    printf("%6zu %12.0f %12.0f %12.0f %12.0f\n", kLineLengths[i], base, scalar,
+           sse2, avx2);
+    detail::setSimdLevel(detected);
+  }
+
+  printf("\none line arriving in 1460-byte reads, lines/s\n");
+  printf("%6s %12s %12s\n", "line", "rescan", "resume");
+  const size_t kLongLines[] = {1024, 8192, 65536};
+  for (size_t i = 0; i < sizeof kLongLines / sizeof kLongLines[0]; ++i) {
+    printf("%6zu %12.0f %12.0f\n", kLongLines[i],
+           benchArrival(kLongLines[i], 1460, false),
+           benchArrival(kLongLines[i], 1460, true));
+  }
+}
@@ -0,0 +1,172 @@
+#include "AtomicSharedPtr.h"
+#include "CowSnapshot.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logging.h"
+#include "Mutex.h"
+#include "RWLock.h"
+#include "Thread.h"
+#include "Timestamp.h"
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <map>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// kReaders个线程查一张小表（路由表、连接表之类），一个写者每毫秒改一项。
+// 比较：互斥锁保护shared_ptr（examples/asio/chat原来的写法）、读写锁、
+// AtomicSharedPtr和CowSnapshot，看读者每秒能查多少次
+const int kReaders = 8;
+const int kReadsPerThread = 1000 * 1000;
+const int kKeys = 1024;
+const int kWriteIntervalUs = 1000;
+
+typedef std::map<int, int64_t> Table;
+typedef boost::shared_ptr<Table> TablePtr;
+
+Table makeTable() {
+  Table table;
+  for (int i = 0; i < kKeys; ++i) {
+    table[i] = i;
+  }
+  return table;
+}
+
+void bump(int key, Table *table) { (*table)[key] += 1; }
+
+int64_t lookup(const Table &table, int key) {
+  Table::const_iterator it = table.find(key);
+  return it != table.end() ? it->second : 0;
+}
+
+// 读者拿到shared_ptr之后放锁，写者在有人引用时复制一份再改
+struct MutexPolicy {
+  MutexPolicy() : table(new Table(makeTable())) {}
+
+  int64_t read(int key) {
+    TablePtr snapshot;
+    {
+      MutexLockGuard lock(mutex);
+      snapshot = table;
+    }
+    return lookup(*snapshot, key);
+  }
+
+  void write(int key) {
+    MutexLockGuard lock(mutex);
+    if (!table.unique()) {
+      table.reset(new Table(*table));
+    }
+    bump(key, table.get());
+  }
+
+  MutexLock mutex;
+  TablePtr table;
+};
+
+struct RWLockPolicy {
+  RWLockPolicy() : table(makeTable()) {}
+
+  int64_t read(int key) {
+    ReadLockGuard lock(rwlock);
+    return lookup(table, key);
+  }
+
+  void write(int key) {
+    WriteLockGuard lock(rwlock);
+    bump(key, &table);
+  }
+
+  RWLock rwlock;
+  Table table;
+};
+
+struct AtomicSharedPtrPolicy {
+  AtomicSharedPtrPolicy() : table(TablePtr(new Table(makeTable()))) {}
+
+  int64_t read(int key) { return lookup(*table.load(), key); }
+  void write(int key) { table.update(boost::bind(&bump, key, _1)); }
+
+  AtomicSharedPtr<Table> table;
+};
+
+// 旧快照交给单独的EventLoop回收
+struct CowSnapshotPolicy {
+  CowSnapshotPolicy() : table(makeTable()) {
+    table.setReclaimExecutor(
+        boost::bind(&EventLoop::queueInLoop, reclaimThread.startLoop(), _1));
+  }
+
+  int64_t read(int key) {
+    CowSnapshot<Table>::ReadGuard guard(table);
+    return lookup(*guard, key);
+  }
+
+  void write(int key) { table.update(boost::bind(&bump, key, _1)); }
+
+  EventLoopThread reclaimThread;
+  CowSnapshot<Table> table;
+};
+
+std::atomic<int> g_runningReaders;
+
+template <typename Policy> void reader(Policy *policy, int seed) {
+  unsigned r = seed;
+  int64_t sum = 0;
+  for (int i = 0; i < kReadsPerThread; ++i) {
+    r = r * 1103515245 + 12345;
+    sum += policy->read((r >> 8) % kKeys);
+  }
+  volatile int64_t sink = sum;
+  (void)sink;
+  --g_runningReaders;
+}
+
+template <typename Policy> void writer(Policy *policy, int *writes) {
+  int key = 0;
+  while (g_runningReaders.load() > 0) {
+    policy->write(key);
+    key = (key + 1) % kKeys;
+    ++*writes;
+    ::usleep(kWriteIntervalUs);
+  }
+}
+
+template <typename Policy> void bench(const char *name) {
+  Policy policy;
+  int writes = 0;
+  g_runningReaders = kReaders;
+  boost::ptr_vector<Thread> threads;
+  for (int i = 0; i < kReaders; ++i) {
+    threads.push_back(new Thread(boost::bind(&reader<Policy>, &policy, i)));
+  }
+  threads.push_back(
+      new Thread(boost::bind(&writer<Policy>, &policy, &writes)));
+  Timestamp start(Timestamp::now());
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].start();
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  double seconds = timeDifference(Timestamp::now(), start);
+  printf("%-20s %14.0f %8d\n", name, kReaders * kReadsPerThread / seconds,
+         writes);
+}
+
+int main() {
+  Logger::setLogLevel(Logger::WARN);
+  printf("%d readers, 1 writer every %d us\n", kReaders, kWriteIntervalUs);
+  printf("%-20s %14s %8s\n", "", "reads/s", "writes");
+  bench<MutexPolicy>("MutexLock+shared_ptr");
+  bench<RWLockPolicy>("RWLock");
+  bench<AtomicSharedPtrPolicy>("AtomicSharedPtr");
+  bench<CowSnapshotPolicy>("CowSnapshot");
+}
@@ -0,0 +1,139 @@
+#include "Buffer.h"
+#include "EventLoop.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "HttpServer.h"
+#include "InetAddress.h"
+#include "Logging.h"
+#include "Thread.h"
+#include "Timestamp.h"
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// 类似wrk：每个客户端线程一条keep-alive连接，每轮发出depth个请求，
+// 收齐depth个响应后再发下一轮。depth为1时相当于没有流水线
+const uint16_t kPort = 18080;
+const int kClients = 4;
+const int kRequestsPerClient = 100 * 1000;
+
+const char kRequest[] = "GET /hello HTTP/1.1\r\n"
+                        "Host: localhost\r\n"
+                        "User-Agent: HttpServer_bench\r\n"
+                        "Accept: */*\r\n\r\n";
+
+void onRequest(const HttpRequest &req, HttpResponse *resp) {
+  if (req.path() == "/hello") {
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setStatusMessage("OK");
+    resp->setContentType("text/plain");
+    resp->setBody(StringPiece("hello, world!\n"));
+  } else {
+    resp->setStatusCode(HttpResponse::k404NotFound);
+    resp->setStatusMessage("Not Found");
+    resp->setCloseConnection(true);
+  }
+}
+
+size_t responseSize() {
+  HttpResponse resp(false);
+  resp.setStatusCode(HttpResponse::k200Ok);
+  resp.setStatusMessage("OK");
+  resp.setContentType("text/plain");
+  resp.setBody(StringPiece("hello, world!\n"));
+  Buffer buf;
+  resp.appendToBuffer(&buf);
+  return buf.readableBytes();
+}
+
+void client(int depth, size_t responseBytes) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof addr);
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(kPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof addr) <
+      0) {
+    perror("connect");
+    return;
+  }
+  int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+  string batch;
+  for (int i = 0; i < depth; ++i) {
+    batch.append(kRequest, sizeof kRequest - 1);
+  }
+  char buf[64 * 1024];
+  for (int sent = 0; sent < kRequestsPerClient; sent += depth) {
+    if (::write(fd, batch.data(), batch.size()) !=
+        static_cast<ssize_t>(batch.size())) {
+      perror("write");
+      break;
+    }
+    size_t expected = responseBytes * depth;
+    while (expected > 0) {
+      ssize_t n = ::read(fd, buf, sizeof buf);
+      if (n <= 0) {
+        perror("read");
+        ::close(fd);
+        return;
+      }
+      expected -= n;
+    }
+  }
+  ::close(fd);
+}
+
+double bench(int depth, size_t responseBytes) {
+  boost::ptr_vector<Thread> threads;
+  for (int i = 0; i < kClients; ++i) {
+    threads.push_back(
+        new Thread(boost::bind(&client, depth, responseBytes)));
+  }
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kClients; ++i) {
+    threads[i].start();
+  }
+  for (int i = 0; i < kClients; ++i) {
+    threads[i].join();
+  }
+  return kClients * kRequestsPerClient /
+         timeDifference(Timestamp::now(), start);
+}
+
+void runBenches(EventLoop *loop) {
+  size_t responseBytes = responseSize();
+  const int kDepths[] = {1, 16};
+  printf("%d connections, %zu-byte responses\n", kClients, responseBytes);
+  printf("%8s %14s\n", "pipeline", "requests/s");
+  for (size_t i = 0; i < sizeof kDepths / sizeof kDepths[0]; ++i) {
+    printf("%8d %14.0f\n", kDepths[i], bench(kDepths[i], responseBytes));
+  }
+  loop->quit();
+}
+
+int main() {
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  HttpServer server(&loop, InetAddress(kPort), "HttpServer_bench");
+  server.setHttpCallback(onRequest);
+  server.start();
+
+  Thread driver(boost::bind(&runBenches, &loop));
+  driver.start();
+  loop.loop();
+  driver.join();
+}
@@ -0,0 +1,135 @@
+#include "Buffer.h"
+#include "LengthHeaderCodec.h"
+#include "TcpConnection.h"
+#include "Timestamp.h"
+
+#include <boost/bind.hpp>
+
+#include <assert.h>
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// 小消息的编解码吞吐量：原来chat例子里的做法（每条消息一个string、
+// 一个临时Buffer）与LengthHeaderCodec
+const int kMessages = 1000 * 1000;
+const int kBatch = 1000; // 一次onMessage()里的消息数
+const size_t kHeaderLen = sizeof(int32_t);
+
+int64_t g_bytes = 0;
+
+void onString(const string &message) { g_bytes += message.size(); }
+
+void onStringPiece(const TcpConnectionPtr &, const StringPiece &message,
+                   Timestamp) {
+  g_bytes += message.size();
+}
+
+// examples/asio/chat/codec.h里的解码，换成了对齐安全的peekInt32()
+void oldDecode(Buffer *buf) {
+  while (buf->readableBytes() >= kHeaderLen) {
+    const int32_t len = buf->peekInt32();
+    if (buf->readableBytes() >= len + kHeaderLen) {
+      buf->retrieve(kHeaderLen);
+      string message(buf->peek(), len);
+      onString(message);
+      buf->retrieve(len);
+    } else {
+      break;
+    }
+  }
+}
+
+// 同上，send()里每条消息一个临时Buffer，再复制到输出缓冲区
+void oldEncode(Buffer *output, const StringPiece &message) {
+  Buffer buf;
+  buf.append(message.data(), message.size());
+  int32_t len = static_cast<int32_t>(message.size());
+  buf.prependInt32(len);
+  output->append(buf.peek(), buf.readableBytes());
+}
+
+void fill(Buffer *buf, const LengthHeaderCodec &codec, size_t size) {
+  string message(size, 'x');
+  for (int i = 0; i < kBatch; ++i) {
+    codec.encode(buf, message);
+  }
+}
+
+double benchDecode(size_t size, bool useCodec) {
+  LengthHeaderCodec codec(&onStringPiece);
+  Buffer frames;
+  fill(&frames, codec, size);
+  g_bytes = 0;
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kMessages / kBatch; ++i) {
+    Buffer buf(frames);
+    if (useCodec) {
+      codec.onMessage(TcpConnectionPtr(), &buf, start);
+    } else {
+      oldDecode(&buf);
+    }
+    assert(buf.readableBytes() == 0);
+  }
+  double seconds = timeDifference(Timestamp::now(), start);
+  assert(g_bytes == static_cast<int64_t>(kMessages * size));
+  return kMessages / seconds;
+}
+
+double benchEncode(size_t size, bool useCodec) {
+  LengthHeaderCodec codec(&onStringPiece);
+  string message(size, 'x');
+  Buffer output;
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kMessages / kBatch; ++i) {
+    for (int j = 0; j < kBatch; ++j) {
+      if (useCodec) {
+        codec.encode(&output, message);
+      } else {
+        oldEncode(&output, message);
+      }
+    }
+    output.retrieveAll();
+  }
+  return kMessages / timeDifference(Timestamp::now(), start);
+}
+
+// 不同头部宽度、跨越多次读取的消息
+void verify() {
+  const int kHeaderLens[] = {1, 2, 4};
+  for (size_t h = 0; h < sizeof kHeaderLens / sizeof kHeaderLens[0]; ++h) {
+    LengthHeaderCodec codec(&onStringPiece, kHeaderLens[h]);
+    Buffer frames;
+    for (int i = 0; i < 200; ++i) {
+      codec.encode(&frames, string(i, 'y'));
+    }
+    Buffer input;
+    g_bytes = 0;
+    const char *p = frames.peek();
+    while (p < frames.peek() + frames.readableBytes()) {
+      input.append(p, 1);
+      ++p;
+      codec.onMessage(TcpConnectionPtr(), &input, Timestamp());
+    }
+    assert(g_bytes == 199 * 200 / 2);
+    assert(input.readableBytes() == 0);
+  }
+  LengthHeaderCodec small(&onStringPiece, 2, 100);
+  assert(small.maxMessageSize() == 100);
+  LengthHeaderCodec narrow(&onStringPiece, 1);
+  assert(narrow.maxMessageSize() == 255);
+}
+
+int main() {
+  verify();
+  const size_t kSizes[] = {16, 64, 256, 1024};
+  printf("messages per second\n");
+  printf("%6s %14s %14s %14s %14s\n", "size", "old decode", "codec decode",
+         "old encode", "codec encode");
+  for (size_t i = 0; i < sizeof kSizes / sizeof kSizes[0]; ++i) {
+    printf("%6zu %14.0f %14.0f %14.0f %14.0f\n", kSizes[i],
+           benchDecode(kSizes[i], false), benchDecode(kSizes[i], true),
+           benchEncode(kSizes[i], false), benchEncode(kSizes[i], true));
+  }
+}
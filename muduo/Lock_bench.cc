@@ -0,0 +1,204 @@
+#include "AdaptiveMutex.h"
+#include "Mutex.h"
+#include "RWLock.h"
+#include "SeqLock.h"
+#include "Thread.h"
+#include "Timestamp.h"
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <map>
+#include <stdio.h>
+
+using namespace muduo;
+
+// 多个线程对一张小表做查询/更新，writePermille是千分之几的操作为写
+const int kThreads = 4;
+const int kOpsPerThread = 1000 * 1000;
+const int kKeys = 1024;
+
+typedef std::map<int, int64_t> Table;
+
+// 把不同的锁适配成同一个接口
+struct MutexPolicy
+{
+  MutexLock mutex;
+  void readLock() { mutex.lock(); }
+  void writeLock() { mutex.lock(); }
+  void unlock() { mutex.unlock(); }
+};
+
+struct AdaptivePolicy
+{
+  AdaptiveMutex mutex;
+  void readLock() { mutex.lock(); }
+  void writeLock() { mutex.lock(); }
+  void unlock() { mutex.unlock(); }
+};
+
+struct RWPolicy
+{
+  RWLock lock;
+  void readLock() { lock.readLock(); }
+  void writeLock() { lock.writeLock(); }
+  void unlock() { lock.unlock(); }
+};
+
+template<typename Lock>
+void tableWorker(Lock* lock, Table* table, int writePermille, int seed)
+{
+  unsigned r = seed;
+  int64_t sum = 0;
+  for (int i = 0; i < kOpsPerThread; ++i)
+  {
+    r = r * 1103515245 + 12345;
+    int key = (r >> 8) % kKeys;
+    if (static_cast<int>((r >> 20) % 1000) < writePermille)
+    {
+      lock->writeLock();
+      (*table)[key] += 1;
+      lock->unlock();
+    }
+    else
+    {
+      lock->readLock();
+      Table::const_iterator it = table->find(key);
+      if (it != table->end())
+        sum += it->second;
+      lock->unlock();
+    }
+  }
+  volatile int64_t sink = sum;
+  (void)sink;
+}
+
+template<typename Lock>
+double benchTable(int writePermille)
+{
+  Lock lock;
+  Table table;
+  for (int i = 0; i < kKeys; ++i)
+    table[i] = i;
+
+  boost::ptr_vector<Thread> threads;
+  for (int i = 0; i < kThreads; ++i)
+    threads.push_back(new Thread(boost::bind(&tableWorker<Lock>, &lock, &table,
+                                             writePermille, i)));
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kThreads; ++i)
+    threads[i].start();
+  for (int i = 0; i < kThreads; ++i)
+    threads[i].join();
+  return kThreads * kOpsPerThread / timeDifference(Timestamp::now(), start);
+}
+
+// 小POD快照：MutexLock与SeqLock
+struct Snapshot
+{
+  int64_t connections;
+  int64_t bytesIn;
+  int64_t bytesOut;
+  int64_t messages;
+};
+
+struct MutexSnapshot
+{
+  MutexSnapshot() : data() {}
+
+  MutexLock mutex;
+  Snapshot data;
+
+  Snapshot read()
+  {
+    MutexLockGuard lock(mutex);
+    return data;
+  }
+
+  void update(int64_t n)
+  {
+    MutexLockGuard lock(mutex);
+    data.bytesIn += n;
+    data.messages += 1;
+  }
+};
+
+struct SeqLockSnapshot
+{
+  SeqLock<Snapshot> seqlock;
+
+  Snapshot read() { return seqlock.read(); }
+
+  void update(int64_t n)
+  {
+    SeqLockWriteGuard<Snapshot> guard(seqlock);
+    guard.value().bytesIn += n;
+    guard.value().messages += 1;
+  }
+};
+
+template<typename Holder>
+void snapshotWorker(Holder* holder, int writePermille, int seed)
+{
+  unsigned r = seed;
+  int64_t sum = 0;
+  for (int i = 0; i < kOpsPerThread; ++i)
+  {
+    r = r * 1103515245 + 12345;
+    if (static_cast<int>((r >> 20) % 1000) < writePermille)
+    {
+      holder->update(r & 0xff);
+    }
+    else
+    {
+      Snapshot s = holder->read();
+      sum += s.bytesIn;
+    }
+  }
+  volatile int64_t sink = sum;
+  (void)sink;
+}
+
+template<typename Holder>
+double benchSnapshot(int writePermille)
+{
+  Holder holder;
+  boost::ptr_vector<Thread> threads;
+  for (int i = 0; i < kThreads; ++i)
+    threads.push_back(new Thread(boost::bind(&snapshotWorker<Holder>, &holder,
+                                             writePermille, i)));
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kThreads; ++i)
+    threads[i].start();
+  for (int i = 0; i < kThreads; ++i)
+    threads[i].join();
+  return kThreads * kOpsPerThread / timeDifference(Timestamp::now(), start);
+}
+
+int main()
+{
+  const int kWritePermille[] = { 0, 10, 100, 500 };
+  const int kRatios = sizeof kWritePermille / sizeof kWritePermille[0];
+
+  printf("std::map lookup/update, %d threads, ops per second\n", kThreads);
+  printf("%8s %14s %14s %14s\n", "write%", "MutexLock", "AdaptiveMutex", "RWLock");
+  for (int i = 0; i < kRatios; ++i)
+  {
+    int w = kWritePermille[i];
+    printf("%8.1f %14.0f %14.0f %14.0f\n", w / 10.0,
+           benchTable<MutexPolicy>(w),
+           benchTable<AdaptivePolicy>(w),
+           benchTable<RWPolicy>(w));
+  }
+
+  printf("\n%d-byte snapshot read/update, %d threads, ops per second\n",
+         static_cast<int>(sizeof(Snapshot)), kThreads);
+  printf("%8s %14s %14s\n", "write%", "MutexLock", "SeqLock");
+  for (int i = 0; i < kRatios; ++i)
+  {
+    int w = kWritePermille[i];
+    printf("%8.1f %14.0f %14.0f\n", w / 10.0,
+           benchSnapshot<MutexSnapshot>(w),
+           benchSnapshot<SeqLockSnapshot>(w));
+  }
+}
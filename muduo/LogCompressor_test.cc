@@ -0,0 +1,188 @@
+#include "LogCompressor.h"
+#include "LogFile.h"
+#include "Thread.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <assert.h>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+using namespace muduo;
+
+// 在临时目录里用LogFile滚动出kFiles个文件，交给LogCompressor压缩，
+// 检查.gz能用zlib还原成写入的内容，以及manifest里raw/gz/failed各行
+const int kFiles = 3;
+const size_t kRollSize = 64 * 1024;
+const int kTimeoutSeconds = 60;
+const char kManifest[] = "manifest";
+
+struct Record {
+  string state;
+  long long rawBytes;
+  long long gzBytes;
+  string filename;
+};
+
+std::vector<Record> readManifest() {
+  std::vector<Record> records;
+  FILE *fp = ::fopen(kManifest, "r");
+  assert(fp);
+  char state[16];
+  char filename[256];
+  Record r;
+  while (::fscanf(fp, "%15s %lld %lld %255s", state, &r.rawBytes,
+                  &r.gzBytes, filename) == 4) {
+    r.state = state;
+    r.filename = filename;
+    records.push_back(r);
+  }
+  ::fclose(fp);
+  return records;
+}
+
+string gunzip(const string &filename) {
+  gzFile in = ::gzopen(filename.c_str(), "rb");
+  assert(in);
+  string content;
+  char buf[8192];
+  int n = 0;
+  while ((n = ::gzread(in, buf, sizeof buf)) > 0) {
+    content.append(buf, n);
+  }
+  assert(n == 0);
+  ::gzclose(in);
+  return content;
+}
+
+bool exists(const string &filename) {
+  struct stat st;
+  return ::stat(filename.c_str(), &st) == 0;
+}
+
+long long fileSize(const string &filename) {
+  struct stat st;
+  if (::stat(filename.c_str(), &st) < 0) {
+    return -1;
+  }
+  return st.st_size;
+}
+
+// 滚动出kFiles个文件，返回写入的全部内容
+string writeLogs(const string &basename, LogCompressor *compressor) {
+  LogFile logFile(basename, kRollSize, false, 3, compressor);
+  string written;
+  int lineNo = 0;
+  for (int i = 0; i < kFiles; ++i) {
+    // 同一秒里只能滚动一次，写够之后等到下一秒
+    if (i > 0) {
+      CurrentThread::sleepUsec(1100 * 1000);
+    }
+    size_t start = written.size();
+    while (written.size() - start <= kRollSize) {
+      char line[64];
+      int len = snprintf(line, sizeof line, "%s line %d\n", basename.c_str(),
+                         lineNo++);
+      logFile.append(line, len);
+      written.append(line, len);
+    }
+  }
+  return written; // 析构时最后一个文件也交给compressor
+}
+
+void waitForCompressed(const LogCompressor &compressor, int n) {
+  for (int i = 0; i < 1000 && compressor.compressedFiles() < n; ++i) {
+    CurrentThread::sleepUsec(10 * 1000);
+  }
+  assert(compressor.compressedFiles() == n);
+}
+
+int main(int, char *argv[]) {
+  ::alarm(kTimeoutSeconds);
+  char dir[] = "/tmp/LogCompressor_testXXXXXX";
+  if (::mkdtemp(dir) == NULL || ::chdir(dir) < 0) {
+    perror(dir);
+    return 1;
+  }
+
+  char basename[256];
+  snprintf(basename, sizeof basename, "%s", ::basename(argv[0]));
+  // 能打开但读不出内容的输入
+  int ret = ::mkdir("unreadable.log", 0755);
+  assert(ret == 0);
+
+  LogCompressor compressor(kManifest);
+  compressor.start(1);
+  // 只有一个后台线程，按顺序处理：滚动的文件都压缩完时这两个也已经失败。
+  // stop()不等待还在排队的文件
+  bool queued = compressor.compress("unreadable.log");
+  queued = compressor.compress("missing.log") && queued;
+  assert(queued);
+  string written = writeLogs(basename, &compressor);
+  waitForCompressed(compressor, kFiles);
+  compressor.stop();
+
+  // 停止之后交来的文件不压缩，只记为raw
+  FILE *fp = ::fopen("late.log", "w");
+  assert(fp);
+  ::fclose(fp);
+  queued = compressor.compress("late.log");
+  assert(!queued);
+  assert(compressor.skippedFiles() == 1);
+
+  std::vector<Record> records = readManifest();
+  std::map<string, size_t> rawAt; // 文件名 -> raw行号
+  std::vector<string> gzFiles;
+  std::map<string, long long> failed;
+  for (size_t i = 0; i < records.size(); ++i) {
+    const Record &r = records[i];
+    if (r.state == "raw") {
+      assert(r.rawBytes == -1 && r.gzBytes == -1);
+      rawAt[r.filename] = i;
+    } else if (r.state == "gz") {
+      // 先有raw再有gz，字节数与文件一致
+      assert(r.filename.size() > 3 &&
+             r.filename.compare(r.filename.size() - 3, 3, ".gz") == 0);
+      string raw = r.filename.substr(0, r.filename.size() - 3);
+      assert(rawAt.count(raw) == 1 && rawAt[raw] < i);
+      assert(!exists(raw));
+      assert(r.gzBytes == fileSize(r.filename));
+      assert(r.rawBytes == static_cast<long long>(gunzip(r.filename).size()));
+      gzFiles.push_back(r.filename);
+    } else {
+      assert(r.state == "failed");
+      assert(rawAt.count(r.filename) == 1 && r.gzBytes == -1);
+      failed[r.filename] = r.rawBytes;
+    }
+  }
+  assert(records.size() == static_cast<size_t>(2 * kFiles + 2 * 2 + 1));
+  assert(gzFiles.size() == static_cast<size_t>(kFiles));
+  assert(failed.size() == 2);
+  assert(failed["unreadable.log"] == 0 && failed["missing.log"] == 0);
+  assert(exists("unreadable.log") && !exists("unreadable.log.gz"));
+  assert(rawAt.count("late.log") == 1 && exists("late.log"));
+
+  // 文件名里有时间，按名字排序就是滚动的顺序，依次解压拼起来就是写入的内容
+  std::sort(gzFiles.begin(), gzFiles.end());
+  string restored;
+  for (size_t i = 0; i < gzFiles.size(); ++i) {
+    restored += gunzip(gzFiles[i]);
+    ::unlink(gzFiles[i].c_str());
+  }
+  assert(restored == written);
+
+  ::unlink(kManifest);
+  ::unlink("late.log");
+  ::rmdir("unreadable.log");
+  if (::chdir("/") == 0) {
+    ::rmdir(dir);
+  }
+  printf("%d files, %zu bytes: ok\n", kFiles, written.size());
+}
@@ -0,0 +1,40 @@
+#include "Logging.h"
+#include "MmapLogFile.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+boost::scoped_ptr<muduo::MmapLogFile> g_logFile;
+
+void outputFunc(const char* msg, int len)
+{
+  g_logFile->append(msg, len);
+}
+
+void flushFunc()
+{
+  g_logFile->flush();
+}
+
+int main(int, char* argv[])
+{
+  char name[256];
+  snprintf(name, sizeof name, "%s", ::basename(argv[0]));
+  // 小窗口、小文件，以便频繁地滑动窗口和滚动文件
+  g_logFile.reset(new muduo::MmapLogFile(name, 200*1000, 3, 64*1024));
+  muduo::Logger::setOutput(outputFunc);
+  muduo::Logger::setFlush(flushFunc);
+
+  muduo::string line = "1234567890 abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ ";
+
+  for (int i = 0; i < 10000; ++i)
+  {
+    LOG_INFO << line << i;
+
+    usleep(1000);
+  }
+  printf("inline maps: %lld\n", static_cast<long long>(g_logFile->inlineMaps()));
+}
@@ -0,0 +1,138 @@
+#include "Buffer.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Logging.h"
+#include "TcpConnection.h"
+
+#include <boost/bind.hpp>
+
+#include <malloc.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// 生产者 -> A=中继=B -> 消费者。生产者尽快发送kTotal字节，消费者每10ms
+// 只读64KB。比较中继两侧不背压和coupleReadBackpressure()：
+// 运行kSeconds秒之后的堆内存增长、B积压的数据、消费者收到的数据
+const size_t kTotal = 256 * 1024 * 1024;
+const size_t kChunk = 64 * 1024;
+const double kSeconds = 1.0;
+const double kConsumeInterval = 0.01;
+const size_t kHighMark = 1024 * 1024;
+const size_t kLowMark = 256 * 1024;
+
+TcpConnectionPtr makeConnection(EventLoop *loop, const char *name, int fd) {
+  InetAddress addr(InetAddress::unixDomain("@muduo_Relay_bench"));
+  TcpConnectionPtr conn(new TcpConnection(loop, name, fd, addr, addr));
+  conn->setConnectionCallback(defaultConnectionCallback);
+  conn->setMessageCallback(defaultMessageCallback);
+  return conn;
+}
+
+void socketPair(int fds[2]) {
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+                   fds) < 0) {
+    LOG_SYSFATAL << "socketpair";
+  }
+}
+
+// 转发到另一个连接，不复制
+void relay(const TcpConnectionPtr &to, const TcpConnectionPtr &,
+           Buffer *buf, Timestamp) {
+  to->send(buf);
+}
+
+struct Producer {
+  explicit Producer(const TcpConnectionPtr &c)
+      : conn(c), chunk(kChunk, 'r'), sent(0) {
+    conn->setWriteCompleteCallback(boost::bind(&Producer::produce, this));
+  }
+
+  void produce() {
+    if (sent < kTotal) {
+      sent += chunk.size();
+      conn->send(chunk);
+    }
+  }
+
+  TcpConnectionPtr conn;
+  string chunk;
+  size_t sent;
+};
+
+struct Consumer {
+  explicit Consumer(int f) : fd(f), received(0) {}
+
+  void consume() {
+    char buf[kChunk];
+    ssize_t n = ::read(fd, buf, sizeof buf);
+    if (n > 0) {
+      received += static_cast<size_t>(n);
+    }
+  }
+
+  int fd;
+  size_t received;
+};
+
+// 大块内存由mmap()分配，不算在uordblks里
+size_t heapInUse() {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+double mib(size_t bytes) {
+  return static_cast<double>(bytes) / (1024 * 1024);
+}
+
+void report(const char *name, bool backpressure) {
+  EventLoop loop;
+  int in[2], out[2];
+  socketPair(in);
+  socketPair(out);
+  TcpConnectionPtr producerConn(makeConnection(&loop, "producer", in[0]));
+  TcpConnectionPtr a(makeConnection(&loop, "A", in[1]));
+  TcpConnectionPtr b(makeConnection(&loop, "B", out[0]));
+  a->setMessageCallback(boost::bind(&relay, b, _1, _2, _3));
+  b->setMessageCallback(boost::bind(&relay, a, _1, _2, _3));
+  Producer producer(producerConn);
+  Consumer consumer(out[1]);
+  producerConn->connectEstablished();
+  a->connectEstablished();
+  b->connectEstablished();
+  if (backpressure) {
+    TcpConnection::coupleReadBackpressure(a, b, kHighMark, kLowMark);
+  }
+
+  size_t before = heapInUse();
+  producer.produce();
+  loop.runEvery(kConsumeInterval, boost::bind(&Consumer::consume, &consumer));
+  loop.runAfter(kSeconds, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  size_t after = heapInUse();
+  printf("%-24s %12.1f %12.1f %12.1f %12.1f\n", name, mib(after - before),
+         mib(b->outputBuffer()->readableBytes()), mib(producer.sent),
+         mib(consumer.received));
+
+  // 不再保持对方存活
+  a->setMessageCallback(defaultMessageCallback);
+  b->setMessageCallback(defaultMessageCallback);
+  producerConn->connectDestroyed();
+  a->connectDestroyed();
+  b->connectDestroyed();
+  ::close(out[1]);
+}
+
+int main() {
+  Logger::setLogLevel(Logger::WARN);
+  printf("producer up to %zu MiB, consumer %zu KiB every %.0f ms, %.1f s\n",
+         kTotal / (1024 * 1024), kChunk / 1024, kConsumeInterval * 1000,
+         kSeconds);
+  printf("%-24s %12s %12s %12s %12s\n", "", "heap MiB", "queued MiB",
+         "sent MiB", "received MiB");
+  report("no backpressure", false);
+  report("coupled backpressure", true);
+}
@@ -0,0 +1,182 @@
+#include "CountDownLatch.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Logging.h"
+#include "RpcClient.h"
+#include "RpcServer.h"
+#include "Thread.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// 回环上的RPC：服务端在另一个线程里，客户端一条连接上保持depth个
+// 未完成的调用，每完成一个就发出下一个，统计吞吐量和延迟
+const uint16_t kPort = 18081;
+const int kCalls = 200 * 1000;
+const double kTimeout = 5.0;
+
+bool echo(const StringPiece &request, string *response) {
+  response->assign(request.data(), request.size());
+  return true;
+}
+
+bool slow(const StringPiece &, string *) {
+  ::usleep(200 * 1000);
+  return true;
+}
+
+bool fail(const StringPiece &, string *response) {
+  *response = "failed";
+  return false;
+}
+
+void serverThread(CountDownLatch *ready, EventLoop **serverLoop) {
+  EventLoop loop;
+  RpcServer server(&loop, InetAddress(kPort), "RpcBench");
+  server.registerMethod("echo", echo);
+  server.registerMethod("echoPool", echo, RpcServer::kInPool);
+  server.registerMethod("slow", slow, RpcServer::kInPool);
+  server.registerMethod("fail", fail);
+  server.setWorkerThreadNum(2);
+  server.start();
+  *serverLoop = &loop;
+  ready->countDown();
+  loop.loop();
+}
+
+class Driver : boost::noncopyable {
+public:
+  Driver(EventLoop *loop, const string &method, int depth)
+      : loop_(loop), client_(loop, InetAddress("127.0.0.1", kPort), "Driver"),
+        method_(method), payload_(32, 'x'), depth_(depth), sent_(0),
+        done_(0) {
+    latencies_.reserve(kCalls);
+    client_.setConnectionCallback(boost::bind(&Driver::onConnection, this, _1));
+  }
+
+  void run() {
+    client_.connect();
+    loop_->loop();
+  }
+
+  double callsPerSecond() const {
+    return kCalls / timeDifference(end_, start_);
+  }
+
+  double percentile(double p) {
+    std::sort(latencies_.begin(), latencies_.end());
+    size_t i = static_cast<size_t>(static_cast<double>(latencies_.size()) * p);
+    return static_cast<double>(latencies_[i]);
+  }
+
+private:
+  void onConnection(const TcpConnectionPtr &conn) {
+    if (conn->connected()) {
+      start_ = Timestamp::now();
+      for (int i = 0; i < depth_; ++i) {
+        issue();
+      }
+    }
+  }
+
+  void issue() {
+    ++sent_;
+    client_.call(method_, payload_,
+                 boost::bind(&Driver::onDone, this,
+                             Timestamp::now().microSecondsSinceEpoch(), _1, _2),
+                 kTimeout);
+  }
+
+  void onDone(int64_t sentAt, RpcStatus status, const StringPiece &response) {
+    assert(status == kRpcOk && response == payload_);
+    (void)status;
+    (void)response;
+    latencies_.push_back(Timestamp::now().microSecondsSinceEpoch() - sentAt);
+    if (++done_ == kCalls) {
+      end_ = Timestamp::now();
+      client_.disconnect();
+      loop_->quit();
+    } else if (sent_ < kCalls) {
+      issue();
+    }
+  }
+
+  EventLoop *loop_;
+  RpcClient client_;
+  string method_;
+  string payload_;
+  int depth_;
+  int sent_;
+  int done_;
+  Timestamp start_;
+  Timestamp end_;
+  std::vector<int64_t> latencies_;
+};
+
+// 超时、没有这个方法、方法失败
+void checkOne(RpcStatus expected, RpcStatus status, const StringPiece &) {
+  printf("  %-14s -> %s\n", rpcStatusName(expected), rpcStatusName(status));
+  assert(status == expected);
+  (void)expected;
+}
+
+void onVerifyConnection(RpcClient *client, EventLoop *loop,
+                        const TcpConnectionPtr &conn) {
+  if (conn->connected()) {
+    client->call("slow", "", boost::bind(&checkOne, kRpcTimeout, _1, _2), 0.05);
+    client->call("nosuch", "",
+                 boost::bind(&checkOne, kRpcNoSuchMethod, _1, _2));
+    client->call("fail", "", boost::bind(&checkOne, kRpcMethodFailed, _1, _2));
+    loop->runAfter(0.3, boost::bind(&EventLoop::quit, loop));
+  }
+}
+
+void verify() {
+  EventLoop loop;
+  RpcClient client(&loop, InetAddress("127.0.0.1", kPort), "Verify");
+  client.setConnectionCallback(
+      boost::bind(&onVerifyConnection, &client, &loop, _1));
+  client.connect();
+  loop.loop();
+  // 慢调用的响应在超时之后才到，应当被丢弃
+  assert(client.pendingCalls() == 0);
+}
+
+int main() {
+  Logger::setLogLevel(Logger::WARN);
+  CountDownLatch ready(1);
+  EventLoop *serverLoop = NULL;
+  Thread server(boost::bind(&serverThread, &ready, &serverLoop));
+  server.start();
+  ready.wait();
+
+  printf("status checks\n");
+  verify();
+
+  const int kDepths[] = {1, 16, 128};
+  printf("\n%d calls, 32-byte payload\n", kCalls);
+  printf("%-9s %6s %12s %10s %10s\n", "dispatch", "depth", "calls/s",
+         "p50 us", "p99 us");
+  const char *kMethods[] = {"echo", "echoPool"};
+  for (size_t m = 0; m < 2; ++m) {
+    for (size_t d = 0; d < sizeof kDepths / sizeof kDepths[0]; ++d) {
+      EventLoop loop;
+      Driver driver(&loop, kMethods[m], kDepths[d]);
+      driver.run();
+      printf("%-9s %6d %12.0f %10.0f %10.0f\n", m == 0 ? "inline" : "pool",
+             kDepths[d], driver.callsPerSecond(), driver.percentile(0.5),
+             driver.percentile(0.99));
+    }
+  }
+
+  serverLoop->quit();
+  server.join();
+}
@@ -0,0 +1,226 @@
+#include "Atomic.h"
+#include "CountDownLatch.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "InetAddress.h"
+#include "Logging.h"
+#include "TcpClientPool.h"
+#include "TcpServer.h"
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <assert.h>
+#include <map>
+#include <set>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// kBackends个本机Unix域后端，每个kConnsPerBackend条连接，
+// 分散在kThreads个IO线程上。依次检查轮转、最少未完成请求、一致性哈希，
+// 每个池都在连接还活着的时候析构
+const int kBackends = 3;
+const int kConnsPerBackend = 2;
+const int kThreads = 2;
+const int kSlots = kBackends * kConnsPerBackend;
+const int kTimeoutSeconds = 60;
+
+EventLoop *g_serverLoop;
+boost::ptr_vector<TcpServer> g_servers;
+AtomicInt32 g_serverConnections;
+
+void onServerConnection(const TcpConnectionPtr &conn) {
+  if (conn->connected()) {
+    g_serverConnections.increment();
+  } else {
+    g_serverConnections.decrement();
+  }
+}
+
+// TcpServer只能在自己的loop里创建和析构
+void startServers(const std::vector<InetAddress> *addrs,
+                  CountDownLatch *latch) {
+  for (size_t i = 0; i < addrs->size(); ++i) {
+    char name[32];
+    snprintf(name, sizeof name, "backend%zu", i);
+    g_servers.push_back(new TcpServer(g_serverLoop, (*addrs)[i], name));
+    g_servers.back().setConnectionCallback(onServerConnection);
+    g_servers.back().start();
+  }
+  latch->countDown();
+}
+
+void stopServer(size_t i, CountDownLatch *latch) {
+  g_servers.release(g_servers.begin() + i); // 析构，关闭监听和已有连接
+  latch->countDown();
+}
+
+void runInServerLoop(const boost::function<void(CountDownLatch *)> &f) {
+  CountDownLatch latch(1);
+  g_serverLoop->runInLoop(boost::bind(f, &latch));
+  latch.wait();
+}
+
+template <typename Pred> void waitFor(Pred pred, const char *what) {
+  for (int i = 0; i < 500 && !pred(); ++i) {
+    ::usleep(10 * 1000);
+  }
+  if (!pred()) {
+    fprintf(stderr, "timeout waiting for %s\n", what);
+    abort();
+  }
+}
+
+bool connected(const TcpClientPool *pool, int n) {
+  return pool->connectedCount() == n;
+}
+
+bool serverConnections(int n) { return g_serverConnections.get() == n; }
+
+void startPool(TcpClientPool *pool, TcpClientPool::Policy policy) {
+  pool->setThreadNum(kThreads);
+  pool->setConnectionsPerBackend(kConnsPerBackend);
+  pool->setPolicy(policy);
+  pool->start();
+  waitFor(boost::bind(&connected, pool, kSlots), "pool connections");
+}
+
+// 在连接所在的IO线程里acquire()，应当拿到同一个loop上的连接
+void acquireInLoop(TcpClientPool *pool, EventLoop *loop, bool *sameLoop,
+                   CountDownLatch *latch) {
+  int slot = -1;
+  TcpConnectionPtr conn = pool->acquire(&slot);
+  *sameLoop = conn && conn->getLoop() == loop;
+  pool->release(slot);
+  latch->countDown();
+}
+
+void testRoundRobin(EventLoop *base, const std::vector<InetAddress> &addrs) {
+  TcpClientPool pool(base, addrs, "rr");
+  startPool(&pool, TcpClientPool::kRoundRobin);
+
+  std::map<int, int> hits;
+  for (int i = 0; i < kSlots * 10; ++i) {
+    int slot = -1;
+    TcpConnectionPtr conn = pool.acquire(&slot);
+    assert(conn && slot >= 0);
+    ++hits[slot];
+    pool.release(slot);
+  }
+  assert(hits.size() == static_cast<size_t>(kSlots));
+  for (std::map<int, int>::iterator it = hits.begin(); it != hits.end();
+       ++it) {
+    assert(it->second == 10);
+  }
+
+  for (int i = 0; i < kThreads; ++i) {
+    EventLoop *loop = pool.acquire()->getLoop();
+    for (int j = 0; j < 2; ++j) { // 第二次走线程局部缓存
+      bool sameLoop = false;
+      CountDownLatch latch(1);
+      loop->runInLoop(
+          boost::bind(&acquireInLoop, &pool, loop, &sameLoop, &latch));
+      latch.wait();
+      assert(sameLoop);
+    }
+  }
+  printf("round robin: ok\n");
+}
+
+void testLeastOutstanding(EventLoop *base,
+                          const std::vector<InetAddress> &addrs) {
+  TcpClientPool pool(base, addrs, "lo");
+  startPool(&pool, TcpClientPool::kLeastOutstanding);
+
+  std::vector<int> slots;
+  std::set<int> distinct;
+  for (int i = 0; i < kSlots; ++i) {
+    int slot = -1;
+    assert(pool.acquire(&slot));
+    slots.push_back(slot);
+    distinct.insert(slot);
+  }
+  assert(distinct.size() == static_cast<size_t>(kSlots));
+
+  // 只有刚释放的槽位未完成数最少
+  pool.release(slots[2]);
+  int slot = -1;
+  pool.acquire(&slot);
+  assert(slot == slots[2]);
+  printf("least outstanding: ok\n");
+}
+
+void testHash(EventLoop *base, const std::vector<InetAddress> &addrs) {
+  TcpClientPool pool(base, addrs, "hash");
+  startPool(&pool, TcpClientPool::kRoundRobin);
+
+  const int kKeys = 100;
+  std::vector<string> backendOf(kKeys);
+  std::set<string> used;
+  for (int i = 0; i < kKeys; ++i) {
+    char key[32];
+    snprintf(key, sizeof key, "user%d", i);
+    int slot = -1;
+    TcpConnectionPtr conn = pool.acquire(key, &slot);
+    assert(conn && slot >= 0);
+    pool.release(slot);
+    backendOf[i] = conn->peerAddress().toIpPort();
+    used.insert(backendOf[i]);
+    assert(pool.acquire(key)->peerAddress().toIpPort() == backendOf[i]);
+  }
+  assert(used.size() == static_cast<size_t>(kBackends));
+
+  // 一个后端下线，原来落在它上面的key改去环上的下一个后端，其余不变
+  string down = addrs[0].toIpPort();
+  runInServerLoop(boost::bind(&stopServer, 0, _1));
+  waitFor(boost::bind(&connected, &pool, kSlots - kConnsPerBackend),
+          "backend down");
+  int moved = 0;
+  for (int i = 0; i < kKeys; ++i) {
+    char key[32];
+    snprintf(key, sizeof key, "user%d", i);
+    TcpConnectionPtr conn = pool.acquire(key);
+    assert(conn);
+    string backend = conn->peerAddress().toIpPort();
+    assert(backend != down);
+    if (backendOf[i] == down) {
+      ++moved;
+    } else {
+      assert(backend == backendOf[i]);
+    }
+  }
+  assert(moved > 0);
+  printf("consistent hash: ok, %d of %d keys moved\n", moved, kKeys);
+  // 析构时下线的后端还在重连中
+}
+
+int main() {
+  ::alarm(kTimeoutSeconds);
+  Logger::setLogLevel(Logger::WARN);
+  EventLoopThread serverThread;
+  g_serverLoop = serverThread.startLoop();
+
+  std::vector<InetAddress> addrs;
+  for (int i = 0; i < kBackends; ++i) {
+    char path[64];
+    snprintf(path, sizeof path, "@muduo_TcpClientPool_test_%d_%d", ::getpid(),
+             i);
+    addrs.push_back(InetAddress::unixDomain(path));
+  }
+  runInServerLoop(boost::bind(&startServers, &addrs, _1));
+
+  EventLoop base; // 只用来start()，不需要loop()
+  testRoundRobin(&base, addrs);
+  waitFor(boost::bind(&serverConnections, 0), "rr pool closed");
+  testLeastOutstanding(&base, addrs);
+  waitFor(boost::bind(&serverConnections, 0), "lo pool closed");
+  testHash(&base, addrs);
+  waitFor(boost::bind(&serverConnections, 0), "hash pool closed");
+
+  runInServerLoop(boost::bind(&stopServer, 0, _1));
+  runInServerLoop(boost::bind(&stopServer, 0, _1));
+  printf("done\n");
+}
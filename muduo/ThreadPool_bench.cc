@@ -0,0 +1,90 @@
+#include "CountDownLatch.h"
+#include "ThreadPool.h"
+#include "Timestamp.h"
+#include "WorkStealingThreadPool.h"
+
+#include <boost/bind.hpp>
+
+#include <atomic>
+#include <stdio.h>
+
+using namespace muduo;
+
+// 每个任务只做很少的计算，测的是线程池本身的调度开销
+const int kTasks = 1000 * 1000;
+const int kChildren = 100;
+
+std::atomic<int> g_remaining;
+CountDownLatch *g_latch = NULL;
+
+void work()
+{
+  volatile int x = 0;
+  for (int i = 0; i < 100; ++i)
+    x += i;
+  if (g_remaining.fetch_sub(1) == 1)
+    g_latch->countDown();
+}
+
+// 从线程池内部再提交子任务（fork-join式负载）
+template<typename Pool>
+void spawn(Pool* pool)
+{
+  for (int i = 0; i < kChildren; ++i)
+    pool->run(work);
+  work();
+}
+
+template<typename Pool>
+double benchExternal(int numThreads)
+{
+  Pool pool("bench");
+  pool.start(numThreads);
+  CountDownLatch latch(1);
+  g_latch = &latch;
+  g_remaining = kTasks;
+
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kTasks; ++i)
+    pool.run(work);
+  latch.wait();
+  Timestamp end(Timestamp::now());
+  pool.stop();
+
+  return kTasks / timeDifference(end, start);
+}
+
+template<typename Pool>
+double benchFork(int numThreads)
+{
+  Pool pool("bench");
+  pool.start(numThreads);
+  CountDownLatch latch(1);
+  g_latch = &latch;
+  const int roots = kTasks / (kChildren + 1);
+  g_remaining = roots * (kChildren + 1);
+
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < roots; ++i)
+    pool.run(boost::bind(&spawn<Pool>, &pool));
+  latch.wait();
+  Timestamp end(Timestamp::now());
+  pool.stop();
+
+  return roots * (kChildren + 1) / timeDifference(end, start);
+}
+
+int main()
+{
+  printf("tasks per second\n");
+  printf("%8s %16s %16s %16s %16s\n", "threads",
+         "external/TP", "external/WS", "fork/TP", "fork/WS");
+  for (int n = 1; n <= 64; n *= 2)
+  {
+    printf("%8d %16.0f %16.0f %16.0f %16.0f\n", n,
+           benchExternal<ThreadPool>(n),
+           benchExternal<WorkStealingThreadPool>(n),
+           benchFork<ThreadPool>(n),
+           benchFork<WorkStealingThreadPool>(n));
+  }
+}
@@ -0,0 +1,230 @@
+#include "CountDownLatch.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logging.h"
+#include "Thread.h"
+#include "ThreadPool.h"
+
+#include <boost/bind.hpp>
+
+#include <assert.h>
+#include <atomic>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// submit()/submitBatch()/whenAll()/thenInLoop()，以及被丢弃、
+// 线程池停止时future的取消
+const int kTasks = 100;
+const int kTimeoutSeconds = 60;
+
+std::atomic<int> g_count;
+
+int square(int x) { return x * x; }
+
+bool isOdd(int x) { return x % 2 == 1; }
+
+void increment() { ++g_count; }
+
+// 占住工作线程，直到gate打开
+void block(CountDownLatch *started, CountDownLatch *gate) {
+  started->countDown();
+  gate->wait();
+}
+
+void occupy(ThreadPool *pool, CountDownLatch *gate) {
+  CountDownLatch started(1);
+  pool->run(boost::bind(&block, &started, gate));
+  started.wait();
+}
+
+void checkInLoop(EventLoop *loop, bool *inLoop, int *value,
+                 CountDownLatch *latch, int result) {
+  *inLoop = loop->isInLoopThread();
+  *value = result;
+  latch->countDown();
+}
+
+void testThenInLoop() {
+  EventLoopThread loopThread;
+  EventLoop *loop = loopThread.startLoop();
+  ThreadPool pool("then");
+  pool.start(2);
+
+  for (int i = 0; i < 10; ++i) {
+    bool inLoop = false;
+    int value = 0;
+    CountDownLatch latch(1);
+    Future<int> f = pool.submit(boost::bind(&square, i));
+    f.thenInLoop(loop,
+                 boost::bind(&checkInLoop, loop, &inLoop, &value, &latch, _1));
+    latch.wait();
+    assert(inLoop);
+    assert(value == square(i));
+  }
+  pool.stop();
+  printf("thenInLoop: ok\n");
+}
+
+void testWhenAll() {
+  ThreadPool pool("whenAll");
+  pool.start(4);
+
+  std::vector<Future<int> > squares;
+  std::vector<Future<bool> > odds; // std::vector<bool>按位存放
+  for (int i = 0; i < kTasks; ++i) {
+    squares.push_back(pool.submit(boost::bind(&square, i)));
+    odds.push_back(pool.submit(boost::bind(&isOdd, i)));
+  }
+  Future<std::vector<int> > allSquares = whenAll(squares);
+  Future<std::vector<bool> > allOdds = whenAll(odds);
+  const std::vector<int> &s = allSquares.get();
+  const std::vector<bool> &o = allOdds.get();
+  assert(!allSquares.cancelled() && !allOdds.cancelled());
+  assert(s.size() == static_cast<size_t>(kTasks));
+  assert(o.size() == static_cast<size_t>(kTasks));
+  for (int i = 0; i < kTasks; ++i) {
+    assert(s[i] == square(i));
+    assert(o[i] == isOdd(i));
+  }
+
+  g_count = 0;
+  std::vector<Future<void> > voids;
+  for (int i = 0; i < kTasks; ++i) {
+    voids.push_back(pool.submit(&increment));
+  }
+  Future<void> allVoids = whenAll(voids);
+  allVoids.get();
+  assert(!allVoids.cancelled());
+  assert(g_count == kTasks);
+
+  // 空的输入立即就绪
+  assert(whenAll(std::vector<Future<int> >()).ready());
+  assert(whenAll(std::vector<Future<void> >()).ready());
+  pool.stop();
+  printf("whenAll: ok\n");
+}
+
+void setFlag(bool *flag) { *flag = true; }
+
+void testCancelOnDrop() {
+  ThreadPool pool("drop");
+  pool.setMaxQueueSize(1);
+  pool.setRejectPolicy(ThreadPool::kDropOldest);
+  pool.start(1);
+
+  CountDownLatch gate(1);
+  occupy(&pool, &gate);
+  Future<int> dropped = pool.submit(boost::bind(&square, 2));
+  bool thenCalled = false;
+  bool cancelCalled = false;
+  dropped.then(boost::bind(&setFlag, &thenCalled));
+  dropped.onCancel(boost::bind(&setFlag, &cancelCalled));
+  Future<int> kept = pool.submit(boost::bind(&square, 3));
+
+  // 排在队列里的dropped被kept挤掉
+  assert(dropped.ready() && dropped.cancelled());
+  assert(cancelCalled && !thenCalled);
+  assert(dropped.get() == 0);
+  assert(pool.stats().dropped == 1);
+
+  gate.countDown();
+  assert(kept.get() == 9 && !kept.cancelled());
+
+  // 有一个输入被取消，whenAll()也被取消
+  CountDownLatch gate2(1);
+  occupy(&pool, &gate2);
+  std::vector<Future<int> > both;
+  both.push_back(kept);
+  both.push_back(pool.submit(boost::bind(&square, 4)));
+  Future<std::vector<int> > all = whenAll(both);
+  assert(!all.ready());
+  Future<int> last = pool.submit(boost::bind(&square, 5));
+  assert(all.ready() && all.cancelled());
+  gate2.countDown();
+  assert(last.get() == 25);
+  pool.stop();
+  printf("cancel on kDropOldest: ok\n");
+}
+
+void stopPool(ThreadPool *pool) { pool->stop(); }
+
+void noop() {}
+
+void testCancelOnStop() {
+  ThreadPool pool("stop");
+  pool.start(1);
+
+  CountDownLatch gate(1);
+  occupy(&pool, &gate);
+  Future<int> queued = pool.submit(boost::bind(&square, 4));
+  std::vector<ThreadPool::Task> tasks(kTasks, &increment);
+  g_count = 0;
+  Future<void> batch = pool.submitBatch(tasks);
+
+  // stop()等工作线程退出；tryRun()开始失败说明running_已经是false，
+  // 这时再放开工作线程，它不会再取队列里的任务
+  Thread stopper(boost::bind(&stopPool, &pool));
+  stopper.start();
+  while (pool.tryRun(&noop)) {
+    ::usleep(1000);
+  }
+  gate.countDown();
+  stopper.join();
+
+  assert(queued.ready() && queued.cancelled());
+  assert(queued.get() == 0);
+  batch.get();
+  assert(batch.cancelled());
+  assert(g_count == 0);
+
+  // 停止之后提交的任务立即被取消
+  Future<int> late = pool.submit(boost::bind(&square, 5));
+  assert(late.ready() && late.cancelled());
+  Future<void> lateBatch = pool.submitBatch(tasks);
+  assert(lateBatch.ready() && lateBatch.cancelled());
+  assert(g_count == 0);
+  printf("cancel on stop: ok\n");
+}
+
+void runBatch(ThreadPool::RejectPolicy policy, int maxQueueSize) {
+  ThreadPool pool("batch");
+  pool.setMaxQueueSize(maxQueueSize);
+  pool.setRejectPolicy(policy);
+  pool.start(2);
+
+  std::vector<ThreadPool::Task> tasks(kTasks * 10, &increment);
+  g_count = 0;
+  Future<void> f = pool.submitBatch(tasks);
+  f.get();
+  assert(!f.cancelled());
+  assert(g_count == kTasks * 10);
+  pool.stop();
+}
+
+void testSubmitBatch() {
+  runBatch(ThreadPool::kBlock, 0);
+  runBatch(ThreadPool::kBlock, 4); // 队列满时等待空位
+  runBatch(ThreadPool::kCallerRuns, 4);
+
+  ThreadPool direct; // 没有工作线程，在调用者线程里执行
+  g_count = 0;
+  Future<void> f =
+      direct.submitBatch(std::vector<ThreadPool::Task>(kTasks, &increment));
+  assert(f.ready() && !f.cancelled());
+  assert(g_count == kTasks);
+  printf("submitBatch: ok\n");
+}
+
+int main() {
+  ::alarm(kTimeoutSeconds);
+  Logger::setLogLevel(Logger::WARN);
+  testThenInLoop();
+  testWhenAll();
+  testCancelOnDrop();
+  testCancelOnStop();
+  testSubmitBatch();
+  printf("done\n");
+}
@@ -0,0 +1,208 @@
+#include "CountDownLatch.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Logging.h"
+#include "Thread.h"
+#include "Timestamp.h"
+#include "UdpServer.h"
+#include "UdpSocket.h"
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// 64字节的数据报，本机回环。
+// 发送：没有人读的接收端，只看发送方每秒能交给内核多少个数据报；
+// 接收：kSenders个线程用sendmmsg()尽量快地发，看接收方每秒收到多少个
+const uint16_t kSinkPort = 18090;
+const uint16_t kServerPort = 18091;
+const size_t kPacketSize = 64;
+const int kPackets = 2 * 1000 * 1000;
+const int kSenders = 4;
+const double kSeconds = 1.0;
+
+int rawSocket() { return ::socket(AF_INET, SOCK_DGRAM, 0); }
+
+double benchSendto(const InetAddress &sink) {
+  int fd = rawSocket();
+  char payload[kPacketSize] = {0};
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kPackets; ++i) {
+    ::sendto(fd, payload, sizeof payload, 0, sink.getSockAddr(),
+             sink.sockAddrLen());
+  }
+  double seconds = timeDifference(Timestamp::now(), start);
+  ::close(fd);
+  return kPackets / seconds;
+}
+
+struct Burst {
+  Burst(EventLoop *l, const UdpSocketPtr &s, const InetAddress &p)
+      : loop(l), socket(s), peer(p), payload(kPacketSize, 'u'), sent(0) {}
+
+  // 每次排队kBatchSize个，由UdpSocket在本轮结束时一次发出
+  void run() {
+    if (sent == 0) {
+      start = Timestamp::now();
+    }
+    for (int i = 0; i < UdpSocket::kBatchSize && sent < kPackets;
+         ++i, ++sent) {
+      socket->send(peer, payload);
+    }
+    if (sent < kPackets) {
+      loop->queueInLoop(boost::bind(&Burst::run, this));
+    } else {
+      loop->queueInLoop(boost::bind(&EventLoop::quit, loop));
+    }
+  }
+
+  EventLoop *loop;
+  UdpSocketPtr socket;
+  InetAddress peer;
+  string payload;
+  int sent;
+  Timestamp start;
+};
+
+double benchUdpSocket(const InetAddress &sink, bool gso) {
+  EventLoop loop;
+  UdpSocketPtr socket(new UdpSocket(&loop));
+  socket->setGso(gso);
+  Burst burst(&loop, socket, sink);
+  // 在loop()之外排队的函数要等第一次poll返回，所以用定时器开始
+  loop.runAfter(0.0, boost::bind(&Burst::run, &burst));
+  loop.loop();
+  double seconds = timeDifference(Timestamp::now(), burst.start);
+  if (socket->packetsSent() + socket->packetsDropped() != kPackets) {
+    printf("sent %lld dropped %lld\n",
+           static_cast<long long>(socket->packetsSent()),
+           static_cast<long long>(socket->packetsDropped()));
+  }
+  return kPackets / seconds;
+}
+
+std::atomic<bool> g_sending;
+std::atomic<bool> g_receiving;
+std::atomic<int64_t> g_received;
+
+void sender(const InetAddress &server) {
+  int fd = rawSocket();
+  char payload[kPacketSize] = {0};
+  struct iovec iov[UdpSocket::kBatchSize];
+  struct mmsghdr msgs[UdpSocket::kBatchSize];
+  memset(msgs, 0, sizeof msgs);
+  for (int i = 0; i < UdpSocket::kBatchSize; ++i) {
+    iov[i].iov_base = payload;
+    iov[i].iov_len = sizeof payload;
+    msgs[i].msg_hdr.msg_name =
+        const_cast<struct sockaddr *>(server.getSockAddr());
+    msgs[i].msg_hdr.msg_namelen = server.sockAddrLen();
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  while (g_sending.load(std::memory_order_relaxed)) {
+    ::sendmmsg(fd, msgs, UdpSocket::kBatchSize, 0);
+  }
+  ::close(fd);
+}
+
+// 逐个recvfrom()
+void recvfromReceiver(int fd) {
+  char buf[2048];
+  while (g_receiving.load(std::memory_order_relaxed)) {
+    if (::recvfrom(fd, buf, sizeof buf, 0, NULL, NULL) > 0) {
+      g_received.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void onPackets(const UdpSocketPtr &, const UdpPacket *, int count, Timestamp) {
+  g_received.fetch_add(count, std::memory_order_relaxed);
+}
+
+void serverThread(int numThreads, EventLoop **loop, CountDownLatch *latch) {
+  EventLoop serverLoop;
+  UdpServer server(&serverLoop, InetAddress(kServerPort), "Udp_bench");
+  server.setThreadNum(numThreads);
+  server.setMessageCallback(onPackets);
+  server.start();
+  *loop = &serverLoop;
+  latch->countDown();
+  serverLoop.loop();
+}
+
+double runSenders() {
+  g_received = 0;
+  g_sending = true;
+  boost::ptr_vector<Thread> senders;
+  InetAddress server("127.0.0.1", kServerPort);
+  for (int i = 0; i < kSenders; ++i) {
+    senders.push_back(new Thread(boost::bind(&sender, server)));
+    senders.back().start();
+  }
+  usleep(static_cast<useconds_t>(kSeconds * 1000 * 1000));
+  int64_t received = g_received.load();
+  g_sending = false;
+  for (int i = 0; i < kSenders; ++i) {
+    senders[i].join();
+  }
+  return static_cast<double>(received) / kSeconds;
+}
+
+double benchRecvfrom() {
+  int fd = rawSocket();
+  InetAddress addr(kServerPort);
+  ::bind(fd, addr.getSockAddr(), addr.sockAddrLen());
+  struct timeval timeout = {0, 100 * 1000};
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+  g_receiving = true;
+  Thread receiver(boost::bind(&recvfromReceiver, fd));
+  receiver.start();
+  double pps = runSenders();
+  g_receiving = false;
+  receiver.join();
+  ::close(fd);
+  return pps;
+}
+
+double benchUdpServer(int numThreads) {
+  EventLoop *loop = NULL;
+  CountDownLatch latch(1);
+  Thread thread(boost::bind(&serverThread, numThreads, &loop, &latch));
+  thread.start();
+  latch.wait();
+  double pps = runSenders();
+  loop->quit();
+  thread.join();
+  return pps;
+}
+
+int main() {
+  Logger::setLogLevel(Logger::WARN);
+  // 接收端只绑定不读，缓冲区满了内核直接丢弃
+  int sinkFd = rawSocket();
+  InetAddress sink("127.0.0.1", kSinkPort);
+  ::bind(sinkFd, sink.getSockAddr(), sink.sockAddrLen());
+
+  printf("send, %zu-byte datagrams, packets per second\n", kPacketSize);
+  printf("%-28s %12.0f\n", "sendto() per packet", benchSendto(sink));
+  printf("%-28s %12.0f\n", "UdpSocket sendmmsg()",
+         benchUdpSocket(sink, false));
+  printf("%-28s %12.0f\n", "UdpSocket sendmmsg() + GSO",
+         benchUdpSocket(sink, true));
+  ::close(sinkFd);
+
+  printf("\nreceive, %d senders, packets per second\n", kSenders);
+  printf("%-28s %12.0f\n", "recvfrom() per packet", benchRecvfrom());
+  printf("%-28s %12.0f\n", "UdpServer, 1 socket", benchUdpServer(0));
+  printf("%-28s %12.0f\n", "UdpServer, 4 reuseport", benchUdpServer(4));
+}
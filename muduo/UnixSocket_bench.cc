@@ -0,0 +1,103 @@
+#include "Buffer.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Logging.h"
+#include "TcpClient.h"
+#include "TcpConnection.h"
+#include "TcpServer.h"
+#include "Thread.h"
+#include "Timestamp.h"
+
+#include <boost/bind.hpp>
+
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// 同一台机器上的ping-pong：客户端发一块数据，服务器原样返回，客户端收到
+// 多少就再发回多少，任何时刻只有一块数据在路上。小块看往返延迟，大块看吞吐量。
+// 比较127.0.0.1上的TCP、文件系统路径和抽象名字空间的Unix域套接字
+const uint16_t kPort = 18082;
+const char kUnixPath[] = "/tmp/muduo_UnixSocket_bench.sock";
+const char kAbstractName[] = "@muduo_UnixSocket_bench";
+const double kSeconds = 1.0;
+
+void onServerMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+  conn->send(buf);
+}
+
+struct PingPong {
+  explicit PingPong(size_t blockSize) : block(blockSize, 'p'), bytes(0) {}
+
+  void onConnection(const TcpConnectionPtr &conn) {
+    if (conn->connected()) {
+      conn->setTcpNoDelay(true);
+      conn->send(block);
+    }
+  }
+
+  void onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+    bytes += static_cast<int64_t>(buf->readableBytes());
+    conn->send(buf);
+  }
+
+  string block;
+  int64_t bytes;
+};
+
+// 返回每秒收到的字节数
+double bench(const InetAddress &serverAddr, size_t blockSize) {
+  EventLoop loop;
+  PingPong pingpong(blockSize);
+  TcpClient client(&loop, serverAddr, "PingPong");
+  client.setConnectionCallback(
+      boost::bind(&PingPong::onConnection, &pingpong, _1));
+  client.setMessageCallback(
+      boost::bind(&PingPong::onMessage, &pingpong, _1, _2, _3));
+  client.connect();
+
+  loop.runAfter(kSeconds, boost::bind(&TcpClient::disconnect, &client));
+  loop.runAfter(kSeconds + 0.1, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  return static_cast<double>(pingpong.bytes) / kSeconds;
+}
+
+void runBenches(EventLoop *serverLoop) {
+  const InetAddress addrs[] = {InetAddress("127.0.0.1", kPort),
+                               InetAddress::unixDomain(kUnixPath),
+                               InetAddress::unixDomain(kAbstractName)};
+  const size_t kSizes[] = {64, 1024, 16 * 1024, 256 * 1024};
+  printf("%-40s %8s %14s %10s %10s\n", "address", "block", "round trips/s",
+         "avg us", "MiB/s");
+  for (size_t s = 0; s < sizeof kSizes / sizeof kSizes[0]; ++s) {
+    for (size_t a = 0; a < sizeof addrs / sizeof addrs[0]; ++a) {
+      double bytesPerSecond = bench(addrs[a], kSizes[s]);
+      double roundTrips = bytesPerSecond / static_cast<double>(kSizes[s]);
+      printf("%-40s %8zu %14.0f %10.2f %10.1f\n", addrs[a].toIpPort().c_str(),
+             kSizes[s], roundTrips, roundTrips > 0 ? 1e6 / roundTrips : 0.0,
+             bytesPerSecond / (1024 * 1024));
+    }
+  }
+  serverLoop->quit();
+}
+
+int main() {
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  TcpServer tcpServer(&loop, InetAddress(kPort), "tcp");
+  TcpServer unixServer(&loop, InetAddress::unixDomain(kUnixPath), "unix");
+  TcpServer abstractServer(&loop, InetAddress::unixDomain(kAbstractName),
+                           "abstract");
+  tcpServer.setMessageCallback(onServerMessage);
+  unixServer.setMessageCallback(onServerMessage);
+  abstractServer.setMessageCallback(onServerMessage);
+  tcpServer.start();
+  unixServer.start();
+  abstractServer.start();
+
+  Thread driver(boost::bind(&runBenches, &loop));
+  driver.start();
+  loop.loop();
+  driver.join();
+}
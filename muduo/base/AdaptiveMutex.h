@@ -0,0 +1,96 @@
+#ifndef MUDUO_BASE_ADAPTIVEMUTEX_H
+#define MUDUO_BASE_ADAPTIVEMUTEX_H
+
+#include "Futex.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+namespace muduo {
+
+///
+/// 先自旋后睡眠的互斥锁，适合临界区很短的场合。
+///
+/// 状态0为未加锁，1为已加锁，2为已加锁且可能有线程在futex上睡眠
+/// （Drepper, "Futexes Are Tricky"）。无竞争时lock()/unlock()各一次原子操作。
+/// 有竞争时先自旋，自旋次数按最近成功取得锁所用的次数自适应调整，
+/// 持有时间长的锁很快就退化为直接睡眠。
+///
+/// 不能与Condition一起使用。
+///
+class AdaptiveMutex : boost::noncopyable {
+public:
+  AdaptiveMutex()
+      : state_(0), spins_(0),
+        maxSpins_(detail::spinWorthwhile() ? kMaxSpins : 0) {}
+
+  void lock() {
+    int c = 0;
+    if (!state_.compare_exchange_strong(c, 1, std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+      lockSlow();
+    }
+  }
+
+  bool tryLock() {
+    int c = 0;
+    return state_.compare_exchange_strong(c, 1, std::memory_order_acquire,
+                                          std::memory_order_relaxed);
+  }
+
+  void unlock() {
+    if (state_.exchange(0, std::memory_order_release) == 2) {
+      detail::futexWake(&state_, 1);
+    }
+  }
+
+private:
+  static const int kMaxSpins = 100;
+
+  void lockSlow() {
+    // 与glibc的PTHREAD_MUTEX_ADAPTIVE_NP相同：上限是平均值的两倍加10
+    int spins = spins_.load(std::memory_order_relaxed);
+    int limit = std::min(maxSpins_, spins * 2 + 10);
+    int cnt = 0;
+    for (; cnt < limit; ++cnt) {
+      detail::cpuRelax();
+      if (state_.load(std::memory_order_relaxed) == 0 && tryLock()) {
+        spins_.store(spins + (cnt - spins) / 8, std::memory_order_relaxed);
+        return;
+      }
+    }
+    spins_.store(spins + (cnt - spins) / 8, std::memory_order_relaxed);
+
+    int c = state_.exchange(2, std::memory_order_acquire);
+    while (c != 0) {
+      detail::futexWait(&state_, 2);
+      c = state_.exchange(2, std::memory_order_acquire);
+    }
+  }
+
+  std::atomic<int> state_;
+  std::atomic<int> spins_; // 最近取得锁所需自旋次数的滑动平均
+  const int maxSpins_;
+};
+
+class AdaptiveMutexGuard : boost::noncopyable {
+public:
+  explicit AdaptiveMutexGuard(AdaptiveMutex &mutex) : mutex_(mutex) {
+    mutex_.lock();
+  }
+
+  ~AdaptiveMutexGuard() { mutex_.unlock(); }
+
+private:
+  AdaptiveMutex &mutex_;
+};
+
+} // namespace muduo
+
+// Prevent misuse like:
+// AdaptiveMutexGuard(mutex_);
+#define AdaptiveMutexGuard(x) error "Missing guard object name"
+
+#endif // MUDUO_BASE_ADAPTIVEMUTEX_H
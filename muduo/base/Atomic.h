@@ -6,11 +6,25 @@
 #define MUDUO_BASE_ATOMIC_H
 
 #include <boost/noncopyable.hpp>
+
+#include <atomic>
 #include <stdint.h>
 
 namespace muduo {
 
+// 容易被多个线程同时修改的变量应当独占一个cache line
+const int kCacheLineSize = 64;
+
 namespace detail {
+///
+/// std::atomic<T>的薄封装，接口与原来基于__sync内建函数的版本相同。
+///
+/// 默认内存序：
+/// - get()是relaxed load，只读一个值不需要加锁前缀的RMW；
+/// - add()/increment()/decrement()不返回值，多用于统计，是relaxed；
+/// - 返回新/旧值的操作调用者可能据此做决定，是acq_rel。
+/// 需要更强的顺序时显式传入memory_order。
+///
 template <typename T> class AtomicIntegerT : boost::noncopyable {
 public:
   AtomicIntegerT() : value_(0) {}
@@ -27,33 +41,68 @@ public:
   //   return *this;
   // }
 
-  T get() { return __sync_val_compare_and_swap(&value_, 0, 0); }
+  T get(std::memory_order order = std::memory_order_relaxed) const {
+    return value_.load(order);
+  }
+
+  void set(T newValue, std::memory_order order = std::memory_order_release) {
+    value_.store(newValue, order);
+  }
+
+  T getAndAdd(T x, std::memory_order order = std::memory_order_acq_rel) {
+    return value_.fetch_add(x, order);
+  }
 
-  T getAndAdd(T x) { return __sync_fetch_and_add(&value_, x); }
+  T addAndGet(T x, std::memory_order order = std::memory_order_acq_rel) {
+    return getAndAdd(x, order) + x;
+  }
 
-  T addAndGet(T x) { return getAndAdd(x) + x; }
+  T incrementAndGet(std::memory_order order = std::memory_order_acq_rel) {
+    return addAndGet(1, order);
+  }
 
-  T incrementAndGet() { return addAndGet(1); }
+  T decrementAndGet(std::memory_order order = std::memory_order_acq_rel) {
+    return addAndGet(-1, order);
+  }
 
-  T decrementAndGet() { return addAndGet(-1); }
+  void add(T x, std::memory_order order = std::memory_order_relaxed) {
+    value_.fetch_add(x, order);
+  }
 
-  void add(T x) { getAndAdd(x); }
+  void increment(std::memory_order order = std::memory_order_relaxed) {
+    add(1, order);
+  }
 
-  void increment() { incrementAndGet(); }
+  void decrement(std::memory_order order = std::memory_order_relaxed) {
+    add(-1, order);
+  }
 
-  void decrement() { decrementAndGet(); }
+  T getAndSet(T newValue,
+              std::memory_order order = std::memory_order_acq_rel) {
+    return value_.exchange(newValue, order);
+  }
 
-  T getAndSet(T newValue) {
-    return __sync_lock_test_and_set(&value_, newValue);
+  bool compareAndSet(T expected, T newValue,
+                     std::memory_order order = std::memory_order_acq_rel) {
+    return value_.compare_exchange_strong(expected, newValue, order);
   }
 
 private:
-  volatile T value_;
+  std::atomic<T> value_;
 };
 } // namespace detail
 
 typedef detail::AtomicIntegerT<int32_t> AtomicInt32;
 typedef detail::AtomicIntegerT<int64_t> AtomicInt64;
+
+///
+/// 独占整个cache line的T。alignas只对齐起始地址，同一行的其余部分
+/// 还可能放别的全局变量；对齐到kCacheLineSize的结构体大小也是它的整数倍，
+/// 后面的空间由编译器补齐。
+///
+template <typename T> struct alignas(kCacheLineSize) CacheLinePadded {
+  T value;
+};
 } // namespace muduo
 
 #endif // MUDUO_BASE_ATOMIC_H
@@ -0,0 +1,54 @@
+#ifndef MUDUO_BASE_ATOMICSHAREDPTR_H
+#define MUDUO_BASE_ATOMICSHAREDPTR_H
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace muduo {
+
+///
+/// 可以被多个线程同时读写的boost::shared_ptr<T>。
+///
+/// load()得到一个shared_ptr快照，持有多久都可以，最后一个引用释放时
+/// 旧对象自动删除，不需要另外回收。代价是每次load()都要修改引用计数，
+/// 并经过boost的spinlock池，读者多时这两处都有争用；只需要在一段
+/// 作用域内读的场合用CowSnapshot。
+///
+template <typename T> class AtomicSharedPtr : boost::noncopyable {
+public:
+  typedef boost::shared_ptr<T> Ptr;
+  typedef boost::function<void(T *)> Mutator;
+
+  AtomicSharedPtr() {}
+  explicit AtomicSharedPtr(const Ptr &p) : ptr_(p) {}
+
+  Ptr load() const { return boost::atomic_load(&ptr_); }
+  void store(const Ptr &p) { boost::atomic_store(&ptr_, p); }
+  Ptr exchange(const Ptr &p) { return boost::atomic_exchange(&ptr_, p); }
+
+  // 当前值等于*expected时换成desired，否则把当前值存入*expected
+  bool compareExchange(Ptr *expected, const Ptr &desired) {
+    return boost::atomic_compare_exchange(&ptr_, expected, desired);
+  }
+
+  /// 复制当前值、修改、再换上去。有别的写者抢先时重试，
+  /// 所以mutator可能被调用多次，不能有副作用。
+  void update(const Mutator &mutator) {
+    Ptr current = load();
+    for (;;) {
+      Ptr next(current ? new T(*current) : new T);
+      mutator(next.get());
+      if (compareExchange(&current, next)) {
+        break;
+      }
+    }
+  }
+
+private:
+  Ptr ptr_;
+};
+
+} // namespace muduo
+
+#endif // MUDUO_BASE_ATOMICSHAREDPTR_H
@@ -8,21 +8,50 @@
 
 #include "Condition.h"
 #include "Mutex.h"
+#include "Timestamp.h"
 
 #include <assert.h>
 #include <boost/noncopyable.hpp>
 #include <deque>
+#include <stdint.h>
 
 namespace muduo {
 
+///
+/// 无界阻塞队列。
+///
+/// 除了逐个put()/take()，还可以用putAll()/drainTo()一次加锁搬运一批元素，
+/// 减少加锁和唤醒的次数。所有notify都在临界区之外进行，
+/// 被唤醒的线程不必马上再阻塞在mutex_上。
+///
 template <typename T> class BlockingQueue : boost::noncopyable {
 public:
   BlockingQueue() : mutex_(), notEmpty_(mutex_), queue_() {}
 
   void put(const T &x) {
-    MutexLockGuard lock(mutex_);
-    queue_.push_back(x);
-    notEmpty_.notify(); // TODO: move outside of lock
+    {
+      MutexLockGuard lock(mutex_);
+      queue_.push_back(x);
+    }
+    notEmpty_.notify();
+  }
+
+  // 一次加锁放入items中的全部元素，Container需要支持begin()/end()
+  template <typename Container> void putAll(const Container &items) {
+    size_t n = 0;
+    {
+      MutexLockGuard lock(mutex_);
+      for (typename Container::const_iterator it = items.begin();
+           it != items.end(); ++it) {
+        queue_.push_back(*it);
+        ++n;
+      }
+    }
+    if (n == 1) {
+      notEmpty_.notify();
+    } else if (n > 1) {
+      notEmpty_.notifyAll();
+    }
   }
 
   T take() {
@@ -37,12 +66,72 @@ public:
     return front;
   }
 
+  // 最多等待seconds秒，超时返回false
+  bool take(T *x, double seconds) {
+    MutexLockGuard lock(mutex_);
+    if (!waitNotEmpty(seconds)) {
+      return false;
+    }
+    *x = queue_.front();
+    queue_.pop_front();
+    return true;
+  }
+
+  // 不等待，队列为空时返回false
+  bool poll(T *x) { return take(x, 0); }
+
+  // 阻塞直到队列非空，然后一次取出最多maxItems个元素追加到*c，返回取出的个数
+  template <typename Container>
+  size_t drainTo(Container *c, size_t maxItems = SIZE_MAX) {
+    MutexLockGuard lock(mutex_);
+    while (queue_.empty()) {
+      notEmpty_.wait();
+    }
+    return drainLocked(c, maxItems);
+  }
+
+  // 与drainTo()相同，但最多等待seconds秒，超时返回0
+  template <typename Container>
+  size_t drainTo(Container *c, size_t maxItems, double seconds) {
+    MutexLockGuard lock(mutex_);
+    if (!waitNotEmpty(seconds)) {
+      return 0;
+    }
+    return drainLocked(c, maxItems);
+  }
+
   size_t size() const {
     MutexLockGuard lock(mutex_);
     return queue_.size();
   }
 
 private:
+  // 以下调用时必须持有mutex_
+  bool waitNotEmpty(double seconds) {
+    if (queue_.empty() && seconds > 0) {
+      Timestamp deadline(addTime(Timestamp::now(), seconds));
+      while (queue_.empty()) {
+        double remaining = timeDifference(deadline, Timestamp::now());
+        if (remaining <= 0) {
+          break;
+        }
+        notEmpty_.waitForSeconds(remaining);
+      }
+    }
+    return !queue_.empty();
+  }
+
+  template <typename Container>
+  size_t drainLocked(Container *c, size_t maxItems) {
+    size_t n = 0;
+    while (n < maxItems && !queue_.empty()) {
+      c->push_back(queue_.front());
+      queue_.pop_front();
+      ++n;
+    }
+    return n;
+  }
+
   mutable MutexLock mutex_;
   Condition notEmpty_;
   std::deque<T> queue_;
@@ -8,29 +8,59 @@
 
 #include "Condition.h"
 #include "Mutex.h"
+#include "Timestamp.h"
 
 #include <assert.h>
 #include <boost/circular_buffer.hpp>
 #include <boost/noncopyable.hpp>
+#include <stdint.h>
 
 namespace muduo {
 
+///
+/// 有界阻塞队列，批量接口与BlockingQueue相同。
+/// putAll()在队列满时分段放入，每腾出一段空间就放入尽可能多的元素。
+///
 template <typename T> class BoundedBlockingQueue : boost::noncopyable {
 public:
   explicit BoundedBlockingQueue(int maxSize)
       : mutex_(), notEmpty_(mutex_), notFull_(mutex_), queue_(maxSize) {}
 
   void put(const T &x) {
-    MutexLockGuard lock(mutex_);
-    while (queue_.full()) {
-      notFull_.wait();
+    {
+      MutexLockGuard lock(mutex_);
+      while (queue_.full()) {
+        notFull_.wait();
+      }
+      assert(!queue_.full());
+      queue_.push_back(x);
+    }
+    notEmpty_.notify();
+  }
+
+  // 阻塞直到items中的全部元素都放入队列
+  template <typename Container> void putAll(const Container &items) {
+    typename Container::const_iterator it = items.begin();
+    while (it != items.end()) {
+      size_t n = 0;
+      {
+        MutexLockGuard lock(mutex_);
+        while (queue_.full()) {
+          notFull_.wait();
+        }
+        while (it != items.end() && !queue_.full()) {
+          queue_.push_back(*it);
+          ++it;
+          ++n;
+        }
+      }
+      notifyTakers(n);
     }
-    assert(!queue_.full());
-    queue_.push_back(x);
-    notEmpty_.notify(); // TODO: move outside of lock
   }
 
   T take() {
+    // 先于lock构造，解锁之后才析构，在锁外唤醒；T只需要能复制构造
+    NotifyOnExit notify(notFull_);
     MutexLockGuard lock(mutex_);
     while (queue_.empty()) {
       notEmpty_.wait();
@@ -38,10 +68,56 @@ public:
     assert(!queue_.empty());
     T front(queue_.front());
     queue_.pop_front();
-    notFull_.notify(); // TODO: move outside of lock
     return front;
   }
 
+  // 最多等待seconds秒，超时返回false
+  bool take(T *x, double seconds) {
+    {
+      MutexLockGuard lock(mutex_);
+      if (!waitNotEmpty(seconds)) {
+        return false;
+      }
+      *x = queue_.front();
+      queue_.pop_front();
+    }
+    notFull_.notify();
+    return true;
+  }
+
+  // 不等待，队列为空时返回false
+  bool poll(T *x) { return take(x, 0); }
+
+  // 阻塞直到队列非空，然后一次取出最多maxItems个元素追加到*c，返回取出的个数
+  template <typename Container>
+  size_t drainTo(Container *c, size_t maxItems = SIZE_MAX) {
+    size_t n = 0;
+    {
+      MutexLockGuard lock(mutex_);
+      while (queue_.empty()) {
+        notEmpty_.wait();
+      }
+      n = drainLocked(c, maxItems);
+    }
+    notifyPutters(n);
+    return n;
+  }
+
+  // 与drainTo()相同，但最多等待seconds秒，超时返回0
+  template <typename Container>
+  size_t drainTo(Container *c, size_t maxItems, double seconds) {
+    size_t n = 0;
+    {
+      MutexLockGuard lock(mutex_);
+      if (!waitNotEmpty(seconds)) {
+        return 0;
+      }
+      n = drainLocked(c, maxItems);
+    }
+    notifyPutters(n);
+    return n;
+  }
+
   bool empty() const {
     MutexLockGuard lock(mutex_);
     return queue_.empty();
@@ -63,6 +139,60 @@ public:
   }
 
 private:
+  // 析构时唤醒一个等待者
+  class NotifyOnExit : boost::noncopyable {
+  public:
+    explicit NotifyOnExit(Condition &cond) : cond_(cond) {}
+    ~NotifyOnExit() { cond_.notify(); }
+
+  private:
+    Condition &cond_;
+  };
+
+  // 调用时必须持有mutex_
+  bool waitNotEmpty(double seconds) {
+    if (queue_.empty() && seconds > 0) {
+      Timestamp deadline(addTime(Timestamp::now(), seconds));
+      while (queue_.empty()) {
+        double remaining = timeDifference(deadline, Timestamp::now());
+        if (remaining <= 0) {
+          break;
+        }
+        notEmpty_.waitForSeconds(remaining);
+      }
+    }
+    return !queue_.empty();
+  }
+
+  // 调用时必须持有mutex_
+  template <typename Container>
+  size_t drainLocked(Container *c, size_t maxItems) {
+    size_t n = 0;
+    while (n < maxItems && !queue_.empty()) {
+      c->push_back(queue_.front());
+      queue_.pop_front();
+      ++n;
+    }
+    return n;
+  }
+
+  // 放入/取出了n个元素，唤醒相应的等待者
+  void notifyTakers(size_t n) {
+    if (n == 1) {
+      notEmpty_.notify();
+    } else if (n > 1) {
+      notEmpty_.notifyAll();
+    }
+  }
+
+  void notifyPutters(size_t n) {
+    if (n == 1) {
+      notFull_.notify();
+    } else if (n > 1) {
+      notFull_.notifyAll();
+    }
+  }
+
   mutable MutexLock mutex_;
   Condition notEmpty_;
   Condition notFull_;
@@ -0,0 +1,215 @@
+#ifndef MUDUO_BASE_BOUNDEDMPMCQUEUE_H
+#define MUDUO_BASE_BOUNDEDMPMCQUEUE_H
+
+#include "Futex.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <assert.h>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+namespace muduo {
+
+///
+/// 无锁有界MPMC队列，put()/take()语义与BoundedBlockingQueue相同。
+///
+/// 算法取自Dmitry Vyukov的bounded MPMC queue：每个槽位带一个序号，
+/// 生产者和消费者各自用CAS推进位置，槽位序号表示该槽位可写还是可读，
+/// 不需要锁。
+///
+/// 队列满（put）或空（take）时先短暂自旋，仍然不行才在futex上睡眠。
+/// 睡眠者计数与数据之间用seq_cst fence配对，没有睡眠者时put()/take()
+/// 不做任何系统调用。
+///
+/// T必须可以默认构造和赋值。capacity向上取整为2的幂。
+///
+template <typename T> class BoundedMpmcQueue : boost::noncopyable {
+public:
+  explicit BoundedMpmcQueue(size_t capacity)
+      : mask_(roundUp(capacity) - 1), buffer_(new Cell[mask_ + 1]),
+        putPos_(0), takePos_(0), notEmptySeq_(0), notFullSeq_(0),
+        takeWaiters_(0), putWaiters_(0),
+        spinCount_(detail::spinWorthwhile() ? kSpinCount : 1) {
+    assert(capacity > 0);
+    for (size_t i = 0; i <= mask_; ++i) {
+      buffer_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~BoundedMpmcQueue() { delete[] buffer_; }
+
+  // 队列满时返回false
+  bool tryPut(const T &x) {
+    if (!enqueue(x)) {
+      return false;
+    }
+    wake(&takeWaiters_, &notEmptySeq_);
+    return true;
+  }
+
+  // 队列空时返回false
+  bool tryTake(T *x) {
+    if (!dequeue(x)) {
+      return false;
+    }
+    wake(&putWaiters_, &notFullSeq_);
+    return true;
+  }
+
+  void put(const T &x) {
+    for (;;) {
+      for (int spin = 0; spin < spinCount_; ++spin) {
+        if (tryPut(x)) {
+          return;
+        }
+        detail::cpuRelax();
+      }
+
+      int seq = notFullSeq_.load(std::memory_order_acquire);
+      putWaiters_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (enqueue(x)) {
+        putWaiters_.fetch_sub(1, std::memory_order_relaxed);
+        wake(&takeWaiters_, &notEmptySeq_);
+        return;
+      }
+      detail::futexWait(&notFullSeq_, seq);
+      putWaiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  T take() {
+    T x;
+    for (;;) {
+      for (int spin = 0; spin < spinCount_; ++spin) {
+        if (tryTake(&x)) {
+          return x;
+        }
+        detail::cpuRelax();
+      }
+
+      int seq = notEmptySeq_.load(std::memory_order_acquire);
+      takeWaiters_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (dequeue(&x)) {
+        takeWaiters_.fetch_sub(1, std::memory_order_relaxed);
+        wake(&putWaiters_, &notFullSeq_);
+        return x;
+      }
+      detail::futexWait(&notEmptySeq_, seq);
+      takeWaiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  // 近似值
+  size_t size() const {
+    size_t put = putPos_.load(std::memory_order_relaxed);
+    size_t take = takePos_.load(std::memory_order_relaxed);
+    return put > take ? put - take : 0;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+private:
+  static const int kSpinCount = 128;
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  static size_t roundUp(size_t n) {
+    size_t c = 1;
+    while (c < n) {
+      c <<= 1;
+    }
+    return c;
+  }
+
+  // 槽位序号等于pos时可写，写完置为pos + 1；
+  // 等于pos + 1时可读，读完置为pos + capacity，留给下一轮的生产者
+  bool enqueue(const T &x) {
+    Cell *cell;
+    size_t pos = putPos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &buffer_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (putPos_.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false; // 满
+      } else {
+        pos = putPos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = x;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool dequeue(T *x) {
+    Cell *cell;
+    size_t pos = takePos_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &buffer_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (takePos_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false; // 空
+      } else {
+        pos = takePos_.load(std::memory_order_relaxed);
+      }
+    }
+    *x = std::move(cell->data);
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 睡眠者先在waiters上登记，醒来或者重试成功之后只注销自己的登记；
+  // 唤醒者只推进序号并唤醒一个，不动计数。睡眠者还没来得及注销时
+  // 后续的put()/take()会多做几次futexWake()，但不会漏掉任何睡眠者。
+  //
+  // 与put()/take()里睡眠前的fence配对：要么这里看到waiters > 0，
+  // 要么睡眠者重试时看到刚刚放入/取走的元素。序号在登记之前读取，
+  // 唤醒者推进序号之后futexWait()立即返回
+  static void wake(std::atomic<int> *waiters, std::atomic<int> *seq) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters->load(std::memory_order_relaxed) > 0) {
+      seq->fetch_add(1, std::memory_order_release);
+      detail::futexWake(seq, 1);
+    }
+  }
+
+  const size_t mask_;
+  Cell *const buffer_;
+
+  // 生产者和消费者频繁修改的位置放在不同的cache line
+  char pad0_[64];
+  std::atomic<size_t> putPos_;
+  char pad1_[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> takePos_;
+  char pad2_[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<int> notEmptySeq_;
+  std::atomic<int> notFullSeq_;
+  std::atomic<int> takeWaiters_;
+  std::atomic<int> putWaiters_;
+  // 单核机器上自旋只会拖延对方线程，只尝试一次
+  const int spinCount_;
+};
+
+} // namespace muduo
+
+#endif // MUDUO_BASE_BOUNDEDMPMCQUEUE_H
@@ -0,0 +1,203 @@
+#include "CharSearch.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MUDUO_CHARSEARCH_X86 1
+#endif
+
+using namespace muduo;
+using namespace muduo::detail;
+
+namespace {
+
+const size_t kMaxSimdChars = 8;
+
+typedef const char *(*FindAnyOfFunc)(const char *, const char *, const char *,
+                                     size_t);
+typedef const char *(*FindCRLFFunc)(const char *, const char *);
+
+// 标量实现，也用来处理向量化实现剩下的尾部
+
+const char *findAnyOfScalar(const char *p, const char *end, const char *chars,
+                            size_t n) {
+  bool table[256] = {false};
+  for (size_t i = 0; i < n; ++i) {
+    table[static_cast<unsigned char>(chars[i])] = true;
+  }
+  for (; p < end; ++p) {
+    if (table[static_cast<unsigned char>(*p)]) {
+      return p;
+    }
+  }
+  return NULL;
+}
+
+// 先用memchr()找'\r'，再看下一个字节
+const char *findCRLFScalar(const char *p, const char *end) {
+  while (p < end) {
+    const char *cr = static_cast<const char *>(::memchr(p, '\r', end - p));
+    if (cr == NULL || cr + 1 == end) {
+      return NULL;
+    }
+    if (cr[1] == '\n') {
+      return cr;
+    }
+    p = cr + 1;
+  }
+  return NULL;
+}
+
+#ifdef MUDUO_CHARSEARCH_X86
+
+// 位置i处是'\r'且i+1处是'\n'：两次错开一个字节的load，比较结果相与。
+// 每轮需要读到p + 16，所以至少剩17个字节时才走向量化
+__attribute__((target("sse2"))) const char *findCRLFSse2(const char *p,
+                                                         const char *end) {
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  for (; end - p > 16; p += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1));
+    int mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(a, cr), _mm_cmpeq_epi8(b, lf)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return findCRLFScalar(p, end);
+}
+
+__attribute__((target("avx2"))) const char *findCRLFAvx2(const char *p,
+                                                         const char *end) {
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  for (; end - p > 32; p += 32) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1));
+    unsigned mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(a, cr), _mm256_cmpeq_epi8(b, lf)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return findCRLFSse2(p, end);
+}
+
+__attribute__((target("sse2"))) const char *
+findAnyOfSse2(const char *p, const char *end, const char *chars, size_t n) {
+  if (n > kMaxSimdChars) {
+    return findAnyOfScalar(p, end, chars, n);
+  }
+  __m128i needles[kMaxSimdChars];
+  for (size_t i = 0; i < n; ++i) {
+    needles[i] = _mm_set1_epi8(chars[i]);
+  }
+  for (; end - p >= 16; p += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i hit = _mm_setzero_si128();
+    for (size_t i = 0; i < n; ++i) {
+      hit = _mm_or_si128(hit, _mm_cmpeq_epi8(a, needles[i]));
+    }
+    int mask = _mm_movemask_epi8(hit);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return findAnyOfScalar(p, end, chars, n);
+}
+
+__attribute__((target("avx2"))) const char *
+findAnyOfAvx2(const char *p, const char *end, const char *chars, size_t n) {
+  if (n > kMaxSimdChars) {
+    return findAnyOfScalar(p, end, chars, n);
+  }
+  __m256i needles[kMaxSimdChars];
+  for (size_t i = 0; i < n; ++i) {
+    needles[i] = _mm256_set1_epi8(chars[i]);
+  }
+  for (; end - p >= 32; p += 32) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i hit = _mm256_setzero_si256();
+    for (size_t i = 0; i < n; ++i) {
+      hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(a, needles[i]));
+    }
+    unsigned mask = _mm256_movemask_epi8(hit);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  return findAnyOfSse2(p, end, chars, n);
+}
+
+#endif // MUDUO_CHARSEARCH_X86
+
+SimdLevel detectSimdLevel() {
+#ifdef MUDUO_CHARSEARCH_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return kAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return kSse2;
+  }
+#endif
+  return kScalar;
+}
+
+struct Dispatch {
+  explicit Dispatch(SimdLevel l) : detected(l) { select(l); }
+
+  void select(SimdLevel l) {
+    level = l;
+    findAnyOf = findAnyOfScalar;
+    findCRLF = findCRLFScalar;
+#ifdef MUDUO_CHARSEARCH_X86
+    if (l == kAvx2) {
+      findAnyOf = findAnyOfAvx2;
+      findCRLF = findCRLFAvx2;
+    } else if (l == kSse2) {
+      findAnyOf = findAnyOfSse2;
+      findCRLF = findCRLFSse2;
+    }
+#endif
+  }
+
+  const SimdLevel detected;
+  SimdLevel level;
+  FindAnyOfFunc findAnyOf;
+  FindCRLFFunc findCRLF;
+};
+
+// 第一次使用时检测，其他编译单元的静态初始化中调用也是安全的
+Dispatch &dispatch() {
+  static Dispatch d(detectSimdLevel());
+  return d;
+}
+
+} // namespace
+
+const char *detail::findByte(const char *begin, const char *end, char c) {
+  return static_cast<const char *>(::memchr(begin, c, end - begin));
+}
+
+const char *detail::findAnyOf(const char *begin, const char *end,
+                              const char *chars, size_t n) {
+  if (n == 1) {
+    return findByte(begin, end, chars[0]);
+  }
+  return dispatch().findAnyOf(begin, end, chars, n);
+}
+
+const char *detail::findCRLF(const char *begin, const char *end) {
+  return dispatch().findCRLF(begin, end);
+}
+
+SimdLevel detail::simdLevel() { return dispatch().level; }
+
+SimdLevel detail::setSimdLevel(SimdLevel level) {
+  Dispatch &d = dispatch();
+  d.select(level < d.detected ? level : d.detected);
+  return d.level;
+}
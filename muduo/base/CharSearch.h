@@ -0,0 +1,32 @@
+#ifndef MUDUO_BASE_CHARSEARCH_H
+#define MUDUO_BASE_CHARSEARCH_H
+
+#include <stddef.h>
+
+namespace muduo {
+namespace detail {
+
+///
+/// 在[begin, end)中查找分隔符，供Buffer和各种行协议使用，没有找到返回NULL。
+///
+/// x86上运行时检测CPU，选用AVX2或SSE2实现，一次比较32/16个字节；
+/// 其他平台用标量实现。单字节查找直接用memchr()，glibc已经做了同样的事。
+///
+enum SimdLevel { kScalar, kSse2, kAvx2 };
+
+const char *findByte(const char *begin, const char *end, char c);
+// chars中任意一个字节，n较小（不超过8）时走向量化实现
+const char *findAnyOf(const char *begin, const char *end, const char *chars,
+                      size_t n);
+const char *findCRLF(const char *begin, const char *end);
+
+// 当前使用的实现
+SimdLevel simdLevel();
+// 测试和benchmark用，不能超过CPU支持的级别，返回实际生效的级别。
+// 不是线程安全的，应当在启动其他线程之前调用
+SimdLevel setSimdLevel(SimdLevel level);
+
+} // namespace detail
+} // namespace muduo
+
+#endif // MUDUO_BASE_CHARSEARCH_H
@@ -6,13 +6,19 @@
 #include "Condition.h"
 
 #include <errno.h>
+#include <stdint.h>
 
 // returns true if time out, false otherwise.
-bool muduo::Condition::waitForSeconds(int seconds)
+bool muduo::Condition::waitForSeconds(double seconds)
 {
   struct timespec abstime;
   clock_gettime(CLOCK_REALTIME, &abstime);
-  abstime.tv_sec += seconds;
+
+  const int64_t kNanoSecondsPerSecond = 1000 * 1000 * 1000;
+  int64_t nanoseconds = static_cast<int64_t>(seconds * kNanoSecondsPerSecond);
+  abstime.tv_sec += static_cast<time_t>((abstime.tv_nsec + nanoseconds) / kNanoSecondsPerSecond);
+  abstime.tv_nsec = static_cast<long>((abstime.tv_nsec + nanoseconds) % kNanoSecondsPerSecond);
+  MutexLock::UnassignGuard ug(mutex_);
   return ETIMEDOUT == pthread_cond_timedwait(&pcond_, mutex_.getPthreadMutex(), &abstime);
 }
 
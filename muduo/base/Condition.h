@@ -22,10 +22,13 @@ public:
   ~Condition() { pthread_cond_destroy(&pcond_); }
 
   //会解锁互斥量(unlock mutex_) 
-  void wait() { pthread_cond_wait(&pcond_, mutex_.getPthreadMutex()); }
+  void wait() {
+    MutexLock::UnassignGuard ug(mutex_);
+    pthread_cond_wait(&pcond_, mutex_.getPthreadMutex());
+  }
 
   // returns true if time out, false otherwise.
-  bool waitForSeconds(int seconds);
+  bool waitForSeconds(double seconds);
 
   //和java的类似，一次唤醒一个线程，具体哪个线程被唤醒是不确定的（可以认为是随机的）。
   void notify() { pthread_cond_signal(&pcond_); }
@@ -0,0 +1,239 @@
+#ifndef MUDUO_BASE_COWSNAPSHOT_H
+#define MUDUO_BASE_COWSNAPSHOT_H
+
+#include "Atomic.h"
+#include "Mutex.h"
+#include "ShardedCounter.h"
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+namespace muduo {
+
+///
+/// 读多写少的共享数据（连接集合、路由表、配置），类似RCU的写时复制。
+///
+/// 读者用ReadGuard得到当前快照的const引用：不加锁，不改引用计数，
+/// 只在自己线程的分片上加减一个读者计数（与ShardedCounter共用分片号）。
+/// 写者在互斥锁内复制当前值、修改、原子地换上去，旧快照先退役，
+/// 等换上新值之前进入的读者都离开之后才删除。
+///
+/// 宽限期用两组读者计数判断：读者登记在当前parity的计数上；
+/// 回收时把parity翻转，旧parity的计数全部为零就说明再没有人能看到
+/// 翻转前退役的快照。回收不等待：还有读者时留到下一次更新或reclaim()。
+///
+/// 回收默认在写者线程里进行；setReclaimExecutor()可以把它交给指定的
+/// EventLoop，例如
+///   snapshot.setReclaimExecutor(
+///       boost::bind(&EventLoop::queueInLoop, loop, _1));
+///
+/// ReadGuard只能在一段作用域内使用；要长期持有快照请复制一份，
+/// 或者用AtomicSharedPtr。mutator里不能再调用update()。
+///
+template <typename T> class CowSnapshot : boost::noncopyable {
+  struct State;
+
+public:
+  typedef boost::function<void()> Functor;
+  typedef boost::function<void(const Functor &)> Executor;
+  typedef boost::function<void(T *)> Mutator;
+
+  class ReadGuard : boost::noncopyable {
+  public:
+    explicit ReadGuard(const CowSnapshot &snapshot)
+        : readers_(snapshot.state_->enter()),
+          value_(snapshot.state_->current.load(std::memory_order_seq_cst)) {}
+
+    ~ReadGuard() { readers_->fetch_sub(1, std::memory_order_release); }
+
+    const T &operator*() const { return *value_; }
+    const T *operator->() const { return value_; }
+    const T *get() const { return value_; }
+
+  private:
+    std::atomic<int64_t> *readers_;
+    const T *value_;
+  };
+
+  CowSnapshot() : state_(new State(new T)) {}
+  explicit CowSnapshot(const T &initial) : state_(new State(new T(initial))) {}
+
+  void setReclaimExecutor(const Executor &executor) {
+    MutexLockGuard lock(state_->mutex);
+    state_->executor = executor;
+  }
+
+  /// 复制一份当前值
+  T read() const {
+    ReadGuard guard(*this);
+    return *guard;
+  }
+
+  void set(const T &value) {
+    T *next = new T(value);
+    MutexLockGuard lock(state_->mutex);
+    retireLocked(next);
+  }
+
+  /// 在写者锁内复制、修改、换上去，写者之间串行
+  void update(const Mutator &mutator) {
+    MutexLockGuard lock(state_->mutex);
+    T *next = new T(*state_->current.load(std::memory_order_relaxed));
+    try {
+      mutator(next);
+    } catch (...) {
+      delete next;
+      throw;
+    }
+    retireLocked(next);
+  }
+
+  /// 尽量删除退役的快照，返回还在等读者离开的个数。
+  /// 可以定时调用，例如loop->runEvery(1.0, ...)
+  size_t reclaim() {
+    MutexLockGuard lock(state_->mutex);
+    return state_->reclaimLocked();
+  }
+
+  size_t retiredCount() const {
+    MutexLockGuard lock(state_->mutex);
+    return state_->pending.size() + state_->waiting.size();
+  }
+
+private:
+  struct Shard {
+    std::atomic<int64_t> readers[2];
+    char pad[kCacheLineSize - 2 * sizeof(std::atomic<int64_t>)];
+  };
+
+  struct State : boost::noncopyable {
+    explicit State(T *initial)
+        : current(initial), parity(0), mask(numShards() - 1), shards(NULL),
+          reclaimQueued(false) {
+      void *p = NULL;
+      if (::posix_memalign(&p, kCacheLineSize, sizeof(Shard) * (mask + 1)) !=
+          0) {
+        delete initial;
+        throw std::bad_alloc();
+      }
+      shards = static_cast<Shard *>(p);
+      for (int i = 0; i <= mask; ++i) {
+        new (&shards[i].readers[0]) std::atomic<int64_t>(0);
+        new (&shards[i].readers[1]) std::atomic<int64_t>(0);
+      }
+    }
+
+    ~State() {
+      deleteAll(&pending);
+      deleteAll(&waiting);
+      delete current.load(std::memory_order_relaxed);
+      ::free(shards);
+    }
+
+    static int numShards() {
+      int n = static_cast<int>(::sysconf(_SC_NPROCESSORS_ONLN));
+      int c = 1;
+      while (c < n) {
+        c <<= 1;
+      }
+      return c;
+    }
+
+    // 登记后再确认parity没变，否则这次登记可能落在已经检查过的那组
+    // 计数上，而之后的翻转又不会再检查它
+    std::atomic<int64_t> *enter() {
+      int shard = detail::t_counterShard;
+      if (shard < 0) {
+        shard = detail::assignCounterShard();
+      }
+      Shard &s = shards[shard & mask];
+      for (;;) {
+        int p = parity.load(std::memory_order_seq_cst);
+        std::atomic<int64_t> *readers = &s.readers[p];
+        readers->fetch_add(1, std::memory_order_seq_cst);
+        if (parity.load(std::memory_order_seq_cst) == p) {
+          return readers;
+        }
+        readers->fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+
+    int64_t readers(int p) const {
+      int64_t sum = 0;
+      for (int i = 0; i <= mask; ++i) {
+        sum += shards[i].readers[p].load(std::memory_order_seq_cst);
+      }
+      return sum;
+    }
+
+    // waiting是上次翻转之前退役的，等旧parity的读者离开；
+    // pending是之后退役的，下次翻转时转入waiting
+    size_t reclaimLocked() {
+      if (!waiting.empty()) {
+        if (readers(1 - parity.load(std::memory_order_relaxed)) != 0) {
+          return waiting.size() + pending.size();
+        }
+        deleteAll(&waiting);
+      }
+      if (!pending.empty()) {
+        int old = parity.load(std::memory_order_relaxed);
+        waiting.swap(pending);
+        parity.store(1 - old, std::memory_order_seq_cst);
+        if (readers(old) == 0) {
+          deleteAll(&waiting);
+        }
+      }
+      return waiting.size();
+    }
+
+    static void deleteAll(std::vector<T *> *snapshots) {
+      for (size_t i = 0; i < snapshots->size(); ++i) {
+        delete (*snapshots)[i];
+      }
+      snapshots->clear();
+    }
+
+    std::atomic<T *> current;
+    std::atomic<int> parity;
+    const int mask;
+    Shard *shards;
+
+    mutable MutexLock mutex; // 保护以下成员，也是写者锁
+    std::vector<T *> pending;
+    std::vector<T *> waiting;
+    Executor executor;
+    bool reclaimQueued;
+  };
+
+  void retireLocked(T *next) {
+    T *old = state_->current.exchange(next, std::memory_order_seq_cst);
+    state_->pending.push_back(old);
+    if (!state_->executor) {
+      state_->reclaimLocked();
+    } else if (!state_->reclaimQueued) {
+      state_->reclaimQueued = true;
+      // 持有State，CowSnapshot先析构也不会悬空
+      state_->executor(boost::bind(&CowSnapshot::runQueuedReclaim, state_));
+    }
+  }
+
+  static void runQueuedReclaim(const boost::shared_ptr<State> &state) {
+    MutexLockGuard lock(state->mutex);
+    state->reclaimQueued = false;
+    state->reclaimLocked();
+  }
+
+  boost::shared_ptr<State> state_;
+};
+
+} // namespace muduo
+
+#endif // MUDUO_BASE_COWSNAPSHOT_H
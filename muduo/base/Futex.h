@@ -0,0 +1,42 @@
+#ifndef MUDUO_BASE_FUTEX_H
+#define MUDUO_BASE_FUTEX_H
+
+#include <atomic>
+#include <linux/futex.h>
+#include <stddef.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace muduo {
+namespace detail {
+
+// 自旋等待和futex睡眠/唤醒，供BoundedMpmcQueue、AdaptiveMutex等使用
+
+inline void futexWait(std::atomic<int> *addr, int expected) {
+  ::syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAIT_PRIVATE,
+            expected, NULL, NULL, 0);
+}
+
+inline void futexWake(std::atomic<int> *addr, int count) {
+  ::syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAKE_PRIVATE,
+            count, NULL, NULL, 0);
+}
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// 单核机器上自旋只会拖延持有者
+inline bool spinWorthwhile() {
+  static const bool multicore = ::sysconf(_SC_NPROCESSORS_ONLN) > 1;
+  return multicore;
+}
+
+} // namespace detail
+} // namespace muduo
+
+#endif // MUDUO_BASE_FUTEX_H
@@ -0,0 +1,400 @@
+#ifndef MUDUO_BASE_FUTURE_H
+#define MUDUO_BASE_FUTURE_H
+
+#include "Condition.h"
+#include "Mutex.h"
+#include "copyable.h"
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace muduo {
+
+namespace detail {
+
+class FutureStateBase : boost::noncopyable {
+public:
+  typedef boost::function<void()> Functor;
+  typedef boost::function<void(const Functor &)> Executor;
+
+  FutureStateBase() : mutex_(), ready_(false), cancelled_(false) {}
+
+  bool ready() const {
+    MutexLockGuard lock(mutex_);
+    return ready_;
+  }
+
+  bool cancelled() const {
+    MutexLockGuard lock(mutex_);
+    return cancelled_;
+  }
+
+  // 任务不会再执行（被线程池丢弃或者线程池已经停止）：
+  // 唤醒get()，交付onCancel()注册的回调，then()注册的回调不再执行
+  void cancel() {
+    Functor cb;
+    Executor executor;
+    {
+      MutexLockGuard lock(mutex_);
+      assert(!ready_);
+      cancelled_ = true;
+      markReadyLocked();
+      cb.swap(cancelCallback_);
+      executor.swap(cancelExecutor_);
+    }
+    if (cb) {
+      deliver(cb, executor);
+    }
+  }
+
+  void onCancel(const Functor &cb, const Executor &executor) {
+    {
+      MutexLockGuard lock(mutex_);
+      assert(!cancelCallback_);
+      if (!ready_) {
+        cancelCallback_ = cb;
+        cancelExecutor_ = executor;
+        return;
+      }
+      if (!cancelled_) {
+        return;
+      }
+    }
+    deliver(cb, executor);
+  }
+
+protected:
+  // 调用时必须持有mutex_
+  void waitLocked() {
+    if (!ready_) {
+      if (!cond_) {
+        cond_.reset(new Condition(mutex_));
+      }
+      while (!ready_) {
+        cond_->wait();
+      }
+    }
+  }
+
+  // 调用时必须持有mutex_
+  void markReadyLocked() {
+    ready_ = true;
+    if (cond_) {
+      cond_->notifyAll();
+    }
+  }
+
+  static void deliver(const Functor &f, const Executor &executor) {
+    if (executor) {
+      executor(f);
+    } else {
+      f();
+    }
+  }
+
+  mutable MutexLock mutex_;
+  bool ready_;
+  bool cancelled_;
+  boost::scoped_ptr<Condition> cond_;
+  Executor executor_;
+  Functor cancelCallback_;
+  Executor cancelExecutor_;
+};
+
+template <typename T> class FutureState : public FutureStateBase {
+public:
+  typedef boost::function<void(const T &)> Callback;
+  typedef const T &Result;
+
+  FutureState() : value_() {}
+
+  void set(const T &v) {
+    Callback cb;
+    Executor executor;
+    {
+      MutexLockGuard lock(mutex_);
+      assert(!ready_);
+      value_ = v;
+      markReadyLocked();
+      cb.swap(callback_);
+      executor.swap(executor_);
+    }
+    if (cb) {
+      deliver(boost::bind(cb, value_), executor);
+    }
+  }
+
+  const T &get() {
+    MutexLockGuard lock(mutex_);
+    waitLocked();
+    return value_;
+  }
+
+  void then(const Callback &cb, const Executor &executor) {
+    {
+      MutexLockGuard lock(mutex_);
+      assert(!callback_);
+      if (!ready_) {
+        callback_ = cb;
+        executor_ = executor;
+        return;
+      }
+      if (cancelled_) {
+        return;
+      }
+    }
+    // 已经就绪，value_不会再改变
+    deliver(boost::bind(cb, value_), executor);
+  }
+
+private:
+  T value_;
+  Callback callback_;
+};
+
+template <> class FutureState<void> : public FutureStateBase {
+public:
+  typedef boost::function<void()> Callback;
+  typedef void Result;
+
+  void set() {
+    Callback cb;
+    Executor executor;
+    {
+      MutexLockGuard lock(mutex_);
+      assert(!ready_);
+      markReadyLocked();
+      cb.swap(callback_);
+      executor.swap(executor_);
+    }
+    if (cb) {
+      deliver(cb, executor);
+    }
+  }
+
+  void get() {
+    MutexLockGuard lock(mutex_);
+    waitLocked();
+  }
+
+  void then(const Callback &cb, const Executor &executor) {
+    {
+      MutexLockGuard lock(mutex_);
+      assert(!callback_);
+      if (!ready_) {
+        callback_ = cb;
+        executor_ = executor;
+        return;
+      }
+      if (cancelled_) {
+        return;
+      }
+    }
+    deliver(cb, executor);
+  }
+
+private:
+  Callback callback_;
+};
+
+} // namespace detail
+
+///
+/// ThreadPool::submit()返回的轻量future。
+///
+/// 结果就绪后：
+/// - then(cb, executor)注册的回调交给executor执行，
+///   IO线程一般用thenInLoop(loop, cb)，回调经由loop->runInLoop()回到IO线程；
+/// - get()阻塞等待结果。只有真的需要等待时才创建条件变量，
+///   只用then()的调用者不会为每个任务分配条件变量。
+///
+/// 任务被线程池丢弃（kDropOldest）或者线程池停止时future被取消：
+/// get()返回T()，cancelled()为true，只有onCancel()注册的回调会执行。
+///
+/// 每个future只能注册一个then()回调和一个onCancel()回调。
+/// T必须可以默认构造和复制。
+///
+template <typename T> class Future : public muduo::copyable {
+public:
+  typedef detail::FutureState<T> State;
+  typedef typename State::Callback Callback;
+  typedef typename State::Executor Executor;
+
+  Future() {}
+  explicit Future(const boost::shared_ptr<State> &state) : state_(state) {}
+
+  bool valid() const { return static_cast<bool>(state_); }
+  bool ready() const { return state_->ready(); }
+  // 就绪之后才有意义
+  bool cancelled() const { return state_->cancelled(); }
+
+  // 阻塞直到结果就绪或者被取消，不要在IO线程里调用
+  typename State::Result get() const { return state_->get(); }
+
+  // executor为空时，回调在完成任务的线程（或者调用then()的线程）里执行
+  void then(const Callback &cb, const Executor &executor = Executor()) const {
+    state_->then(cb, executor);
+  }
+
+  // 回调经由loop->runInLoop()在loop所在的IO线程执行
+  template <typename Loop>
+  void thenInLoop(Loop *loop, const Callback &cb) const {
+    state_->then(cb, boost::bind(&Loop::runInLoop, loop, _1));
+  }
+
+  // 被取消时执行，executor的含义与then()相同
+  void onCancel(const boost::function<void()> &cb,
+                const Executor &executor = Executor()) const {
+    state_->onCancel(cb, executor);
+  }
+
+private:
+  boost::shared_ptr<State> state_;
+};
+
+template <typename T> class Promise : public muduo::copyable {
+public:
+  Promise() : state_(new detail::FutureState<T>) {}
+
+  Future<T> getFuture() const { return Future<T>(state_); }
+  void setValue(const T &v) const { state_->set(v); }
+  void cancel() const { state_->cancel(); }
+
+private:
+  boost::shared_ptr<detail::FutureState<T> > state_;
+};
+
+template <> class Promise<void> : public muduo::copyable {
+public:
+  Promise() : state_(new detail::FutureState<void>) {}
+
+  Future<void> getFuture() const { return Future<void>(state_); }
+  void setValue() const { state_->set(); }
+  void cancel() const { state_->cancel(); }
+
+private:
+  boost::shared_ptr<detail::FutureState<void> > state_;
+};
+
+namespace detail {
+
+template <typename R> struct RunAndSet {
+  static void run(const Promise<R> &promise, const boost::function<R()> &f) {
+    promise.setValue(f());
+  }
+};
+
+template <> struct RunAndSet<void> {
+  static void run(const Promise<void> &promise,
+                  const boost::function<void()> &f) {
+    f();
+    promise.setValue();
+  }
+};
+
+// 结果用数组而不是std::vector<T>保存：各个完成线程写不同的元素，
+// std::vector<bool>按位存放，写相邻元素会互相覆盖
+template <typename T> struct WhenAllState : boost::noncopyable {
+  explicit WhenAllState(size_t n)
+      : remaining(n), cancelled(false), size(n), results(new T[n]) {}
+
+  void onResult(size_t i, const T &v) {
+    results[i] = v;
+    finish();
+  }
+
+  void onCancel() {
+    cancelled.store(true, std::memory_order_relaxed);
+    finish();
+  }
+
+  // 全部都有了结果才完成，有一个被取消就取消
+  void finish() {
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      if (cancelled.load(std::memory_order_relaxed)) {
+        promise.cancel();
+      } else {
+        promise.setValue(std::vector<T>(results.get(), results.get() + size));
+      }
+    }
+  }
+
+  std::atomic<size_t> remaining;
+  std::atomic<bool> cancelled;
+  const size_t size;
+  boost::scoped_array<T> results;
+  Promise<std::vector<T> > promise;
+};
+
+struct WhenAllVoidState : boost::noncopyable {
+  explicit WhenAllVoidState(size_t n) : remaining(n), cancelled(false) {}
+
+  void onResult() { finish(); }
+
+  void onCancel() {
+    cancelled.store(true, std::memory_order_relaxed);
+    finish();
+  }
+
+  void finish() {
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      if (cancelled.load(std::memory_order_relaxed)) {
+        promise.cancel();
+      } else {
+        promise.setValue();
+      }
+    }
+  }
+
+  std::atomic<size_t> remaining;
+  std::atomic<bool> cancelled;
+  Promise<void> promise;
+};
+
+} // namespace detail
+
+// 所有future都就绪后，返回的future按原顺序给出全部结果；
+// 其中有被取消的，返回的future也被取消
+template <typename T>
+Future<std::vector<T> > whenAll(const std::vector<Future<T> > &futures) {
+  boost::shared_ptr<detail::WhenAllState<T> > state(
+      new detail::WhenAllState<T>(futures.size()));
+  Future<std::vector<T> > result = state->promise.getFuture();
+  if (futures.empty()) {
+    state->promise.setValue(std::vector<T>());
+  }
+  for (size_t i = 0; i < futures.size(); ++i) {
+    futures[i].then(
+        boost::bind(&detail::WhenAllState<T>::onResult, state, i, _1));
+    futures[i].onCancel(
+        boost::bind(&detail::WhenAllState<T>::onCancel, state));
+  }
+  return result;
+}
+
+inline Future<void> whenAll(const std::vector<Future<void> > &futures) {
+  boost::shared_ptr<detail::WhenAllVoidState> state(
+      new detail::WhenAllVoidState(futures.size()));
+  Future<void> result = state->promise.getFuture();
+  if (futures.empty()) {
+    state->promise.setValue();
+  }
+  for (size_t i = 0; i < futures.size(); ++i) {
+    futures[i].then(
+        boost::bind(&detail::WhenAllVoidState::onResult, state));
+    futures[i].onCancel(
+        boost::bind(&detail::WhenAllVoidState::onCancel, state));
+  }
+  return result;
+}
+
+} // namespace muduo
+
+#endif // MUDUO_BASE_FUTURE_H
@@ -0,0 +1,178 @@
+#include "LockProfiler.h"
+#include "Mutex.h"
+
+#include <algorithm>
+#include <map>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+using namespace muduo;
+
+namespace {
+
+// 注册表本身不能用MutexLock：MutexLock(const char*)的构造要用到它，
+// 而且全局对象的构造顺序不确定，所以用静态初始化的pthread_mutex_t
+pthread_mutex_t g_sitesMutex = PTHREAD_MUTEX_INITIALIZER;
+std::map<string, LockSite *> *g_sites = NULL;
+
+int bucketOf(int64_t nanos) {
+  int b = 0;
+  while (nanos > 1 && b < LockSite::kBuckets - 1) {
+    nanos >>= 1;
+    ++b;
+  }
+  return b;
+}
+
+void updateMax(std::atomic<int64_t> *max, int64_t value) {
+  int64_t old = max->load(std::memory_order_relaxed);
+  while (value > old &&
+         !max->compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+  }
+}
+
+// 直方图中位于第p百分位的桶的上界，不超过max
+int64_t percentile(const std::atomic<int64_t> *histogram, double p,
+                   const std::atomic<int64_t> &max) {
+  int64_t limit = max.load(std::memory_order_relaxed);
+  int64_t total = 0;
+  for (int i = 0; i < LockSite::kBuckets; ++i) {
+    total += histogram[i].load(std::memory_order_relaxed);
+  }
+  if (total == 0) {
+    return 0;
+  }
+  int64_t target = static_cast<int64_t>(static_cast<double>(total) * p);
+  int64_t seen = 0;
+  for (int i = 0; i < LockSite::kBuckets; ++i) {
+    seen += histogram[i].load(std::memory_order_relaxed);
+    if (seen > target) {
+      return std::min(static_cast<int64_t>(2) << i, limit);
+    }
+  }
+  return limit;
+}
+
+bool moreWait(const LockSite *a, const LockSite *b) {
+  return a->waitNanos.load(std::memory_order_relaxed) >
+         b->waitNanos.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+LockSite::LockSite(const string &n) : name(n) { reset(); }
+
+void LockSite::recordWait(int64_t nanos) {
+  waitNanos.fetch_add(nanos, std::memory_order_relaxed);
+  updateMax(&maxWaitNanos, nanos);
+  waitHistogram[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LockSite::recordHold(int64_t nanos) {
+  holdNanos.fetch_add(nanos, std::memory_order_relaxed);
+  updateMax(&maxHoldNanos, nanos);
+  holdHistogram[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LockSite::reset() {
+  acquisitions.store(0, std::memory_order_relaxed);
+  contentions.store(0, std::memory_order_relaxed);
+  waitNanos.store(0, std::memory_order_relaxed);
+  maxWaitNanos.store(0, std::memory_order_relaxed);
+  holdNanos.store(0, std::memory_order_relaxed);
+  maxHoldNanos.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < kBuckets; ++i) {
+    waitHistogram[i].store(0, std::memory_order_relaxed);
+    holdHistogram[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void LockProfiler::enable() {
+  detail::g_lockProfiling.store(true, std::memory_order_relaxed);
+}
+
+void LockProfiler::disable() {
+  detail::g_lockProfiling.store(false, std::memory_order_relaxed);
+}
+
+bool LockProfiler::enabled() {
+  return detail::g_lockProfiling.load(std::memory_order_relaxed);
+}
+
+LockSite *LockProfiler::site(const char *name) {
+  if (name == NULL) {
+    return NULL;
+  }
+  pthread_mutex_lock(&g_sitesMutex);
+  if (g_sites == NULL) {
+    g_sites = new std::map<string, LockSite *>;
+  }
+  LockSite *&site = (*g_sites)[name];
+  if (site == NULL) {
+    site = new LockSite(name);
+  }
+  LockSite *result = site;
+  pthread_mutex_unlock(&g_sitesMutex);
+  return result;
+}
+
+void LockProfiler::reset() {
+  pthread_mutex_lock(&g_sitesMutex);
+  if (g_sites) {
+    for (std::map<string, LockSite *>::iterator it = g_sites->begin();
+         it != g_sites->end(); ++it) {
+      it->second->reset();
+    }
+  }
+  pthread_mutex_unlock(&g_sitesMutex);
+}
+
+string LockProfiler::dump(int topN) {
+  std::vector<LockSite *> sites;
+  pthread_mutex_lock(&g_sitesMutex);
+  if (g_sites) {
+    for (std::map<string, LockSite *>::iterator it = g_sites->begin();
+         it != g_sites->end(); ++it) {
+      sites.push_back(it->second);
+    }
+  }
+  pthread_mutex_unlock(&g_sitesMutex);
+
+  std::sort(sites.begin(), sites.end(), moreWait);
+  if (topN >= 0 && sites.size() > static_cast<size_t>(topN)) {
+    sites.resize(topN);
+  }
+
+  string result;
+  char buf[256];
+  snprintf(buf, sizeof buf, "%-28s %12s %10s %7s %12s %10s %10s %10s %12s %10s\n",
+           "site", "acquired", "contended", "rate%", "wait_ms", "avg_us",
+           "p99_us", "max_us", "hold_ms", "p99_us");
+  result += buf;
+  for (size_t i = 0; i < sites.size(); ++i) {
+    const LockSite &s = *sites[i];
+    int64_t acquired = s.acquisitions.load(std::memory_order_relaxed);
+    int64_t contended = s.contentions.load(std::memory_order_relaxed);
+    int64_t wait = s.waitNanos.load(std::memory_order_relaxed);
+    snprintf(buf, sizeof buf,
+             "%-28s %12lld %10lld %7.2f %12.3f %10.2f %10.2f %10.2f %12.3f %10.2f\n",
+             s.name.c_str(), static_cast<long long>(acquired),
+             static_cast<long long>(contended),
+             acquired ? 100.0 * contended / acquired : 0.0, wait / 1e6,
+             contended ? wait / 1e3 / contended : 0.0,
+             percentile(s.waitHistogram, 0.99, s.maxWaitNanos) / 1e3,
+             s.maxWaitNanos.load(std::memory_order_relaxed) / 1e3,
+             s.holdNanos.load(std::memory_order_relaxed) / 1e6,
+             percentile(s.holdHistogram, 0.99, s.maxHoldNanos) / 1e3);
+    result += buf;
+  }
+  return result;
+}
+
+int64_t LockProfiler::nowNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
@@ -0,0 +1,65 @@
+#ifndef MUDUO_BASE_LOCKPROFILER_H
+#define MUDUO_BASE_LOCKPROFILER_H
+
+#include "Types.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <stdint.h>
+
+namespace muduo {
+
+///
+/// 一个加锁位置的统计，所有同名的MutexLock共用。
+/// 直方图第i个桶统计[2^i, 2^(i+1))纳秒。
+///
+struct LockSite : boost::noncopyable {
+  static const int kBuckets = 40;
+
+  explicit LockSite(const string &n);
+
+  void recordWait(int64_t nanos);
+  void recordHold(int64_t nanos);
+  void reset();
+
+  const string name;
+  std::atomic<int64_t> acquisitions; // 计时期间的加锁次数
+  std::atomic<int64_t> contentions;  // 其中trylock失败、需要等待的次数
+  std::atomic<int64_t> waitNanos;
+  std::atomic<int64_t> maxWaitNanos;
+  std::atomic<int64_t> holdNanos;
+  std::atomic<int64_t> maxHoldNanos;
+  std::atomic<int64_t> waitHistogram[kBuckets];
+  std::atomic<int64_t> holdHistogram[kBuckets];
+};
+
+///
+/// MutexLock的竞争分析，默认关闭。
+///
+/// 用MutexLock(const char* site)构造的锁才参与统计。打开后每次加锁先trylock，
+/// 失败时记录等待时间；持有时间从取得锁记到unlock()或Condition::wait()。
+/// 关闭时MutexLock::lock()只多一次relaxed load。
+///
+/// dump()按总等待时间从大到小列出竞争最严重的topN个加锁位置。
+///
+class LockProfiler : boost::noncopyable {
+public:
+  static void enable();
+  static void disable();
+  static bool enabled();
+
+  // 清零所有统计，不影响开关
+  static void reset();
+
+  static string dump(int topN = 10);
+
+  // internal usage, 同名返回同一个LockSite，永不释放
+  static LockSite *site(const char *name);
+
+  static int64_t nowNanos();
+};
+
+} // namespace muduo
+
+#endif // MUDUO_BASE_LOCKPROFILER_H
@@ -0,0 +1,249 @@
+#include "LogCompressor.h"
+#include "Logging.h" // strerror_tl
+#include "Timestamp.h"
+
+#include <boost/bind.hpp>
+
+#include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <zlib.h>
+
+using namespace muduo;
+
+namespace {
+
+const int kChunkSize = 64 * 1024;
+
+// 把调用线程降为最低优先级：CPU用SCHED_IDLE（不支持时退化为nice 19），
+// IO用idle类，只在磁盘空闲时才能得到带宽。
+void lowerPriority() {
+  struct sched_param param = {0};
+  if (::sched_setscheduler(0, SCHED_IDLE, &param) < 0) {
+    ::setpriority(PRIO_PROCESS, CurrentThread::tid(), 19);
+  }
+#ifdef SYS_ioprio_set
+  const int kIoprioWhoProcess = 1;
+  const int kIoprioClassIdle = 3;
+  const int kIoprioClassShift = 13;
+  ::syscall(SYS_ioprio_set, kIoprioWhoProcess, CurrentThread::tid(),
+            kIoprioClassIdle << kIoprioClassShift);
+#endif
+}
+
+} // namespace
+
+LogCompressor::LogCompressor(const string &manifest, int level,
+                             size_t bytesPerSecond, int maxPending)
+    : manifest_(manifest), level_(level), bytesPerSecond_(bytesPerSecond),
+      maxPending_(maxPending), mutex_(), cond_(mutex_), running_(false),
+      compressedFiles_(0), skippedFiles_(0) {
+  assert(level_ >= 1 && level_ <= 9);
+  assert(maxPending > 0);
+}
+
+LogCompressor::~LogCompressor() {
+  if (running_) {
+    stop();
+  }
+}
+
+void LogCompressor::start(int numThreads) {
+  assert(threads_.empty());
+  running_ = true;
+  threads_.reserve(numThreads);
+
+  for (int i = 0; i < numThreads; ++i) {
+    char id[32];
+    snprintf(id, sizeof id, "LogCompressor%d", i);
+    threads_.push_back(
+        new muduo::Thread(boost::bind(&LogCompressor::runInThread, this), id));
+    threads_[i].start();
+  }
+}
+
+void LogCompressor::stop() {
+  {
+    MutexLockGuard lock(mutex_);
+    running_ = false;
+    cond_.notifyAll();
+  }
+  for_each(threads_.begin(), threads_.end(),
+           boost::bind(&muduo::Thread::join, _1));
+
+  // 没来得及压缩的文件保留原样，记为raw
+  std::deque<string> skipped;
+  {
+    MutexLockGuard lock(mutex_);
+    skipped.swap(skipped_);
+    skipped.insert(skipped.end(), queue_.begin(), queue_.end());
+    queue_.clear();
+  }
+  recordSkipped(&skipped);
+}
+
+// 排队的文件由后台线程取出时记为raw；入队失败的文件同样记为raw，
+// 工具仍然可以从manifest找到它，也交给后台线程去写。
+// 只有没有后台线程时才在调用者线程里写
+bool LogCompressor::compress(const string &filename) {
+  {
+    MutexLockGuard lock(mutex_);
+    if (running_ && queue_.size() < maxPending_) {
+      queue_.push_back(filename);
+      cond_.notify();
+      return true;
+    }
+    ++skippedFiles_;
+    if (running_) {
+      if (!manifest_.empty()) {
+        skipped_.push_back(filename);
+        cond_.notify();
+      }
+      return false;
+    }
+  }
+  record("raw", -1, -1, filename);
+  return false;
+}
+
+int64_t LogCompressor::compressedFiles() const {
+  MutexLockGuard lock(mutex_);
+  return compressedFiles_;
+}
+
+int64_t LogCompressor::skippedFiles() const {
+  MutexLockGuard lock(mutex_);
+  return skippedFiles_;
+}
+
+void LogCompressor::runInThread() {
+  lowerPriority();
+  for (;;) {
+    string filename;
+    std::deque<string> skipped;
+    {
+      MutexLockGuard lock(mutex_);
+      while (queue_.empty() && skipped_.empty() && running_) {
+        cond_.wait();
+      }
+      if (!running_) {
+        break;
+      }
+      skipped.swap(skipped_);
+      if (!queue_.empty()) {
+        filename = queue_.front();
+        queue_.pop_front();
+      }
+    }
+
+    recordSkipped(&skipped);
+    if (filename.empty()) {
+      continue;
+    }
+    record("raw", -1, -1, filename);
+    int64_t rawBytes = 0;
+    int64_t gzBytes = 0;
+    if (compressFile(filename, &rawBytes, &gzBytes)) {
+      {
+        MutexLockGuard lock(mutex_);
+        ++compressedFiles_;
+      }
+      record("gz", rawBytes, gzBytes, filename + ".gz");
+    } else {
+      record("failed", rawBytes, -1, filename);
+    }
+  }
+}
+
+// 先写到filename.gz.tmp，完成后rename，再删除原文件，
+// 任何时刻manifest中的文件都是完整的。
+bool LogCompressor::compressFile(const string &filename, int64_t *rawBytes,
+                                 int64_t *gzBytes) {
+  FILE *in = ::fopen(filename.c_str(), "rbe");
+  if (in == NULL) {
+    fprintf(stderr, "LogCompressor: open %s failed %s\n", filename.c_str(),
+            strerror_tl(errno));
+    return false;
+  }
+
+  string gzname = filename + ".gz";
+  string tmpname = gzname + ".tmp";
+  char mode[8];
+  snprintf(mode, sizeof mode, "wb%d", level_);
+  gzFile out = ::gzopen(tmpname.c_str(), mode);
+  if (out == NULL) {
+    fprintf(stderr, "LogCompressor: gzopen %s failed\n", tmpname.c_str());
+    ::fclose(in);
+    return false;
+  }
+
+  bool ok = true;
+  char buf[kChunkSize];
+  Timestamp start(Timestamp::now());
+  size_t nread = 0;
+  while ((nread = ::fread(buf, 1, sizeof buf, in)) > 0) {
+    if (::gzwrite(out, buf, static_cast<unsigned>(nread)) !=
+        static_cast<int>(nread)) {
+      ok = false;
+      break;
+    }
+    *rawBytes += nread;
+
+    if (bytesPerSecond_ > 0) {
+      // 按bytesPerSecond_计算应当耗费的时间，提前完成就睡眠补齐
+      int64_t expected = *rawBytes * Timestamp::kMicroSecondsPerSecond /
+                         static_cast<int64_t>(bytesPerSecond_);
+      int64_t elapsed = Timestamp::now().microSecondsSinceEpoch() -
+                        start.microSecondsSinceEpoch();
+      if (expected > elapsed) {
+        CurrentThread::sleepUsec(expected - elapsed);
+      }
+    }
+  }
+  if (::ferror(in)) {
+    ok = false;
+  }
+  ::fclose(in);
+  if (::gzclose(out) != Z_OK) {
+    ok = false;
+  }
+
+  struct stat st;
+  if (ok && ::stat(tmpname.c_str(), &st) == 0 &&
+      ::rename(tmpname.c_str(), gzname.c_str()) == 0) {
+    *gzBytes = st.st_size;
+    ::unlink(filename.c_str());
+    return true;
+  }
+
+  fprintf(stderr, "LogCompressor: compress %s failed\n", filename.c_str());
+  ::unlink(tmpname.c_str());
+  return false;
+}
+
+void LogCompressor::recordSkipped(std::deque<string> *skipped) {
+  for (size_t i = 0; i < skipped->size(); ++i) {
+    record("raw", -1, -1, (*skipped)[i]);
+  }
+  skipped->clear();
+}
+
+void LogCompressor::record(const char *state, int64_t rawBytes,
+                           int64_t gzBytes, const string &filename) {
+  if (manifest_.empty()) {
+    return;
+  }
+
+  MutexLockGuard lock(manifestMutex_);
+  FILE *fp = ::fopen(manifest_.c_str(), "ae");
+  if (fp) {
+    fprintf(fp, "%s %lld %lld %s\n", state, static_cast<long long>(rawBytes),
+            static_cast<long long>(gzBytes), filename.c_str());
+    ::fclose(fp);
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef MUDUO_BASE_LOGCOMPRESSOR_H
+#define MUDUO_BASE_LOGCOMPRESSOR_H
+
+#include "Condition.h"
+#include "Mutex.h"
+#include "Thread.h"
+#include "Types.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <deque>
+
+namespace muduo {
+
+///
+/// 已滚动日志文件的后台gzip压缩（zlib）。
+///
+/// LogFile/MmapLogFile滚动后把写完的文件交给compress()，
+/// 由numThreads个低优先级（SCHED_IDLE + idle IO优先级）线程压缩成
+/// filename.gz并删除原文件。
+/// 等待队列有上限，满了就保留原文件不压缩，绝不阻塞写日志的线程；
+/// bytesPerSecond限制每个线程读取原文件的速度，以此限制CPU和磁盘占用。
+///
+/// 如果指定了manifest，每个文件的状态变化都追加一行：
+///   <state> <rawBytes> <gzBytes> <filename>
+/// state为raw（已滚动，未压缩）、gz（已压缩，filename为.gz文件）
+/// 或failed（压缩失败，原文件保留）。字节数未知时为-1，同一文件以最后一行为准。
+/// manifest也由后台线程写，compress()不做文件IO。
+///
+class LogCompressor : boost::noncopyable {
+public:
+  explicit LogCompressor(const string &manifest = string(), int level = 6,
+                         size_t bytesPerSecond = 0, int maxPending = 16);
+  ~LogCompressor();
+
+  void start(int numThreads = 1);
+  // 等待正在压缩的文件完成，队列里剩余的文件保留原样
+  void stop();
+
+  // 线程安全，不阻塞。返回false表示没有排队（队列已满或未启动）
+  bool compress(const string &filename);
+
+  int64_t compressedFiles() const;
+  int64_t skippedFiles() const;
+
+private:
+  void runInThread();
+  void recordSkipped(std::deque<string> *skipped);
+  bool compressFile(const string &filename, int64_t *rawBytes,
+                    int64_t *gzBytes);
+  void record(const char *state, int64_t rawBytes, int64_t gzBytes,
+              const string &filename);
+
+  const string manifest_;
+  const int level_;
+  const size_t bytesPerSecond_;
+  const size_t maxPending_;
+
+  mutable MutexLock mutex_;
+  Condition cond_;
+  std::deque<string> queue_;
+  std::deque<string> skipped_; // 没有排队、还没写入manifest的文件
+  boost::ptr_vector<muduo::Thread> threads_;
+  bool running_;
+  int64_t compressedFiles_;
+  int64_t skippedFiles_;
+
+  MutexLock manifestMutex_;
+};
+
+} // namespace muduo
+#endif // MUDUO_BASE_LOGCOMPRESSOR_H
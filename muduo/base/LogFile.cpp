@@ -1,4 +1,5 @@
 #include "LogFile.h"
+#include "LogCompressor.h"
 #include "Logging.h" // strerror_tl
 #include "ProcessInfo.h"
 
@@ -12,7 +13,8 @@ using namespace muduo;
 class LogFile::File : boost::noncopyable {
 public:
   explicit File(const string &filename)
-      : fp_(::fopen(filename.data(), "ae")), writtenBytes_(0) {
+      : filename_(filename), fp_(::fopen(filename.data(), "ae")),
+        writtenBytes_(0) {
     assert(fp_);
     ::setbuffer(fp_, buffer_, sizeof buffer_);
     // posix_fadvise POSIX_FADV_DONTNEED ?
@@ -44,6 +46,7 @@ public:
   void flush() { ::fflush(fp_); }
 
   size_t writtenBytes() const { return writtenBytes_; }
+  const string &filename() const { return filename_; }
 
 private:
   size_t write(const char *logline, size_t len) {
@@ -51,21 +54,29 @@ private:
     return ::fwrite_unlocked(logline, 1, len, fp_);
   }
 
+  const string filename_;
   FILE *fp_;
   char buffer_[64 * 1024];
   size_t writtenBytes_;
 };
 
 LogFile::LogFile(const string &basename, size_t rollSize, bool threadSafe,
-                 int flushInterval)
+                 int flushInterval, LogCompressor *compressor)
     : basename_(basename), rollSize_(rollSize), flushInterval_(flushInterval),
-      count_(0), mutex_(threadSafe ? new MutexLock : NULL), startOfPeriod_(0),
+      compressor_(compressor), count_(0),
+      mutex_(threadSafe ? new MutexLock("LogFile::mutex_") : NULL), startOfPeriod_(0),
       lastRoll_(0), lastFlush_(0) {
   assert(basename.find('/') == string::npos);
   rollFile();
 }
 
-LogFile::~LogFile() {}
+LogFile::~LogFile() {
+  if (compressor_ && file_) {
+    string finished = file_->filename();
+    file_.reset();
+    compressor_->compress(finished);
+  }
+}
 
 void LogFile::append(const char *logline, int len) {
   if (mutex_) {
@@ -118,7 +129,13 @@ void LogFile::rollFile() {
     lastRoll_ = now;
     lastFlush_ = now;
     startOfPeriod_ = start;
-    file_.reset(new File(filename));
+    boost::scoped_ptr<File> old(new File(filename));
+    file_.swap(old);
+    if (old && compressor_) {
+      string finished = old->filename();
+      old.reset(); // 关闭之后再压缩
+      compressor_->compress(finished);
+    }
   }
 }
 
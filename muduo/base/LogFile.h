@@ -9,10 +9,13 @@
 
 namespace muduo {
 
+class LogCompressor;
+
 class LogFile : boost::noncopyable {
 public:
+  // compressor非空时，滚动后的文件交给它在后台压缩，compressor的生命期必须更长
   LogFile(const string &basename, size_t rollSize, bool threadSafe = true,
-          int flushInterval = 3);
+          int flushInterval = 3, LogCompressor *compressor = NULL);
   ~LogFile();
 
   void append(const char *logline, int len);
@@ -27,6 +30,7 @@ private:
   const string basename_;   // 日志文件basename
   const size_t rollSize_;   // 日志文件达到rolSize_换一个新文件
   const int flushInterval_; // 日志写入间隔时间
+  LogCompressor *compressor_;
 
   int count_;
 
@@ -89,10 +89,8 @@ public:
 
   self &operator<<(const void *);
 
-  self &operator<<(float v) {
-    *this << static_cast<double>(v);
-    return *this;
-  }
+  // 浮点数输出最短的、能精确还原的十进制表示（Grisu2），不经过snprintf
+  self &operator<<(float);
   self &operator<<(double);
   // self& operator<<(long double);
 
@@ -146,10 +144,15 @@ class Fmt // : boost::noncopyable
 public:
   template <typename T> Fmt(const char *fmt, T val);
 
+  // 与Fmt("%.*f", precision, v)结果相同，precision <= 9时不经过snprintf
+  static Fmt fixed(double v, int precision);
+
   const char *data() const { return buf_; }
   int length() const { return length_; }
 
 private:
+  Fmt() : length_(0) {}
+
   char buf_[32];
   int length_;
 };
@@ -0,0 +1,312 @@
+#include "MmapLogFile.h"
+#include "LogCompressor.h"
+#include "Logging.h" // strerror_tl
+#include "ProcessInfo.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace muduo;
+
+// 一个日志文件，最后一个引用它的Window释放时（总是在后台线程）
+// 把预分配但没有写到的尾部截掉，然后关闭文件。
+// 预先创建却从未写入的文件（例如跨天时作废的）直接删除。
+struct MmapLogFile::Segment : boost::noncopyable {
+  Segment(int fdArg, const string &filenameArg, size_t capacityArg,
+          time_t startOfPeriodArg, LogCompressor *compressorArg)
+      : fd(fdArg), filename(filenameArg), capacity(capacityArg), written(0),
+        startOfPeriod(startOfPeriodArg), compressor(compressorArg) {}
+
+  ~Segment() {
+    if (written == 0) {
+      ::unlink(filename.c_str());
+      ::close(fd);
+      return;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(written)) < 0) {
+      fprintf(stderr, "MmapLogFile: ftruncate %s failed %s\n",
+              filename.c_str(), strerror_tl(errno));
+    }
+    ::close(fd);
+    if (compressor) {
+      compressor->compress(filename);
+    }
+  }
+
+  const int fd;
+  const string filename;
+  const size_t capacity;
+  size_t written; // 由写线程在mutex_保护下更新
+  const time_t startOfPeriod;
+  LogCompressor *const compressor;
+};
+
+MmapLogFile::MmapLogFile(const string &basename, size_t rollSize,
+                         int flushInterval, size_t windowSize,
+                         LogCompressor *compressor)
+    : basename_(basename), hostname_(ProcessInfo::hostname()),
+      segmentSize_((rollSize + windowSize - 1) / windowSize * windowSize),
+      windowSize_(windowSize), flushInterval_(flushInterval),
+      compressor_(compressor), mutex_(),
+      cond_(mutex_), pos_(0), rollPending_(false), flushPending_(false),
+      running_(true), inlineMaps_(0),
+      thread_(boost::bind(&MmapLogFile::threadFunc, this), "MmapLogFile") {
+  assert(basename.find('/') == string::npos);
+  assert(windowSize_ > 0 &&
+         windowSize_ % static_cast<size_t>(::sysconf(_SC_PAGESIZE)) == 0);
+  assert(segmentSize_ > 0);
+
+  // 第一个文件在构造时同步创建，与LogFile一致
+  SegmentPtr segment = openSegment();
+  if (segment) {
+    mapWindow(segment, 0, &current_);
+  }
+  thread_.start();
+}
+
+MmapLogFile::~MmapLogFile() {
+  {
+    MutexLockGuard lock(mutex_);
+    running_ = false;
+    retire(&current_);
+    retire(&next_);
+    cond_.notify();
+  }
+  thread_.join();
+}
+
+void MmapLogFile::append(const char *logline, int len) {
+  MutexLockGuard lock(mutex_);
+  // 跨天：新文件已经就绪才切换，不在调用线程里等待
+  if (rollPending_ && next_.data != NULL) {
+    advance();
+  }
+
+  size_t remain = static_cast<size_t>(len);
+  while (remain > 0) {
+    if (current_.data == NULL || pos_ == current_.size) {
+      advance();
+      if (current_.data == NULL) {
+        // 无法映射（例如磁盘已满），丢弃本条日志
+        return;
+      }
+    }
+    size_t n = std::min(remain, current_.size - pos_);
+    memcpy(current_.data + pos_, logline, n);
+    pos_ += n;
+    logline += n;
+    remain -= n;
+    current_.segment->written = static_cast<size_t>(current_.offset) + pos_;
+  }
+}
+
+void MmapLogFile::flush() {
+  MutexLockGuard lock(mutex_);
+  flushPending_ = true;
+  cond_.notify();
+}
+
+int64_t MmapLogFile::inlineMaps() const {
+  MutexLockGuard lock(mutex_);
+  return inlineMaps_;
+}
+
+bool MmapLogFile::nextIsNewSegment() const {
+  return !current_.segment || rollPending_ ||
+         static_cast<size_t>(current_.offset) + current_.size >=
+             current_.segment->capacity;
+}
+
+// 切换到下一个窗口。正常情况下后台线程已经把它映射好了，
+// 这里只是指针交换；否则退化为在调用线程里映射。
+void MmapLogFile::advance() {
+  SegmentPtr oldSegment = current_.segment;
+  if (next_.data == NULL) {
+    bool newSegment = nextIsNewSegment();
+    off_t offset =
+        current_.data ? current_.offset + static_cast<off_t>(current_.size) : 0;
+    retire(&current_);
+    ++inlineMaps_;
+    if (newSegment) {
+      SegmentPtr segment = openSegment();
+      if (segment) {
+        mapWindow(segment, 0, &current_);
+      }
+    } else {
+      mapWindow(oldSegment, offset, &current_);
+    }
+  } else {
+    retire(&current_);
+    current_ = next_;
+    next_ = Window();
+  }
+
+  if (current_.segment && current_.segment != oldSegment) {
+    rollPending_ = false;
+  }
+  pos_ = 0;
+  cond_.notify();
+}
+
+void MmapLogFile::retire(Window *window) {
+  if (window->data != NULL) {
+    retired_.push_back(*window);
+  }
+  *window = Window();
+}
+
+void MmapLogFile::threadFunc() {
+  bool backoff = false;
+  for (;;) {
+    std::vector<Window> retired;
+    Window current;
+    size_t pos = 0;
+    bool prepare = false;
+    bool newSegment = false;
+    {
+      MutexLockGuard lock(mutex_);
+      bool needNext = running_ && next_.data == NULL;
+      if (running_ && retired_.empty() && !flushPending_ &&
+          (!needNext || backoff)) {
+        cond_.waitForSeconds(flushInterval_);
+      }
+      if (!running_ && retired_.empty()) {
+        break;
+      }
+
+      if (running_ && current_.segment && !rollPending_) {
+        time_t now = ::time(NULL);
+        if (now / kRollPerSeconds_ * kRollPerSeconds_ !=
+            current_.segment->startOfPeriod) {
+          rollPending_ = true;
+          // 已准备好的窗口还属于旧文件，作废
+          if (next_.segment == current_.segment) {
+            retire(&next_);
+          }
+        }
+      }
+
+      retired.swap(retired_);
+      flushPending_ = false;
+      current = current_;
+      pos = pos_;
+      if (running_ && next_.data == NULL) {
+        prepare = true;
+        newSegment = nextIsNewSegment();
+      }
+    }
+
+    for (size_t i = 0; i < retired.size(); ++i) {
+      unmapWindow(&retired[i]);
+    }
+    retired.clear(); // 可能触发Segment析构：截断并关闭文件
+
+    // 定期刷盘；current映射只会由本线程解除，这里不加锁也安全
+    if (current.data != NULL && pos > 0) {
+      ::msync(current.data, pos, MS_ASYNC);
+    }
+
+    if (prepare) {
+      Window window;
+      bool ok = false;
+      if (newSegment) {
+        SegmentPtr segment = openSegment();
+        ok = segment && mapWindow(segment, 0, &window);
+      } else {
+        ok = mapWindow(current.segment,
+                       current.offset + static_cast<off_t>(current.size),
+                       &window);
+      }
+      backoff = !ok;
+
+      MutexLockGuard lock(mutex_);
+      if (ok) {
+        // 准备期间写线程可能已经自己映射过，或者发生了跨天，检查是否仍然有效
+        if (running_ && next_.data == NULL &&
+            current_.data == current.data && nextIsNewSegment() == newSegment) {
+          next_ = window;
+        } else {
+          retire(&window);
+        }
+      }
+    }
+  }
+}
+
+MmapLogFile::SegmentPtr MmapLogFile::openSegment() {
+  time_t now = ::time(NULL);
+  char timebuf[32];
+  char pidbuf[32];
+  struct tm tm;
+  gmtime_r(&now, &tm);
+  strftime(timebuf, sizeof timebuf, ".%Y%m%d-%H%M%S.", &tm);
+  snprintf(pidbuf, sizeof pidbuf, ".%d", ProcessInfo::pid());
+  string prefix = basename_ + timebuf + hostname_ + pidbuf;
+
+  // 同一秒内滚动多次时，文件名追加序号，而不是覆盖前一个文件
+  string filename;
+  int fd = -1;
+  for (int seq = 0; fd < 0; ++seq) {
+    filename = prefix;
+    if (seq > 0) {
+      char seqbuf[32];
+      snprintf(seqbuf, sizeof seqbuf, ".%d", seq);
+      filename += seqbuf;
+    }
+    filename += ".log";
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0 && errno != EEXIST) {
+      fprintf(stderr, "MmapLogFile: open %s failed %s\n", filename.c_str(),
+              strerror_tl(errno));
+      return SegmentPtr();
+    }
+  }
+
+  off_t size = static_cast<off_t>(segmentSize_);
+  if (::fallocate(fd, 0, 0, size) < 0) {
+    // 文件系统不支持fallocate时退化为稀疏文件
+    if (::ftruncate(fd, size) < 0) {
+      fprintf(stderr, "MmapLogFile: allocate %s failed %s\n", filename.c_str(),
+              strerror_tl(errno));
+      ::close(fd);
+      ::unlink(filename.c_str());
+      return SegmentPtr();
+    }
+  }
+
+  return SegmentPtr(new Segment(fd, filename, segmentSize_,
+                                now / kRollPerSeconds_ * kRollPerSeconds_,
+                                compressor_));
+}
+
+bool MmapLogFile::mapWindow(const SegmentPtr &segment, off_t offset,
+                            Window *window) {
+  // MAP_POPULATE: 在后台线程里预先缺页，写线程memcpy时不再陷入缺页中断
+  void *p = ::mmap(NULL, windowSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, segment->fd, offset);
+  if (p == MAP_FAILED) {
+    fprintf(stderr, "MmapLogFile: mmap %s failed %s\n",
+            segment->filename.c_str(), strerror_tl(errno));
+    return false;
+  }
+  window->segment = segment;
+  window->data = static_cast<char *>(p);
+  window->offset = offset;
+  window->size = windowSize_;
+  return true;
+}
+
+void MmapLogFile::unmapWindow(Window *window) {
+  ::msync(window->data, window->size, MS_ASYNC);
+  ::munmap(window->data, window->size);
+  *window = Window();
+}
@@ -0,0 +1,96 @@
+#ifndef MUDUO_BASE_MMAPLOGFILE_H
+#define MUDUO_BASE_MMAPLOGFILE_H
+
+#include "Condition.h"
+#include "Mutex.h"
+#include "Thread.h"
+#include "Types.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <sys/types.h>
+#include <vector>
+
+namespace muduo {
+
+class LogCompressor;
+
+///
+/// 基于mmap的日志文件，接口与LogFile相同。
+///
+/// 每个日志文件（segment）创建时用fallocate预分配rollSize字节，
+/// 写入通过一个滑动的mmap窗口直接memcpy到page cache。
+/// 新文件的创建、下一个窗口的映射（MAP_POPULATE预先缺页）、
+/// 旧窗口的msync/munmap以及文件截断关闭全部由后台线程完成，
+/// append()只做memcpy，不会阻塞在文件系统元数据操作上。
+///
+/// 数据写入的是MAP_SHARED映射，进程崩溃后已append的内容仍然保留在文件中。
+///
+class MmapLogFile : boost::noncopyable {
+public:
+  // compressor非空时，写完的文件在后台线程关闭后交给它压缩，
+  // compressor的生命期必须更长
+  MmapLogFile(const string &basename, size_t rollSize, int flushInterval = 3,
+              size_t windowSize = kDefaultWindowSize,
+              LogCompressor *compressor = NULL);
+  ~MmapLogFile();
+
+  void append(const char *logline, int len);
+  // 不阻塞，只是通知后台线程立即msync
+  void flush();
+
+  // 后台线程来不及准备下一个窗口时，调用线程自己映射的次数
+  int64_t inlineMaps() const;
+
+  static const size_t kDefaultWindowSize = 4 * 1024 * 1024;
+
+private:
+  struct Segment;
+  typedef boost::shared_ptr<Segment> SegmentPtr;
+
+  struct Window {
+    Window() : data(NULL), offset(0), size(0) {}
+
+    SegmentPtr segment;
+    char *data;
+    off_t offset; // 窗口在文件中的偏移
+    size_t size;
+  };
+
+  void threadFunc();
+
+  SegmentPtr openSegment();
+  bool mapWindow(const SegmentPtr &segment, off_t offset, Window *window);
+  static void unmapWindow(Window *window);
+
+  // 以下函数调用时必须持有mutex_
+  bool nextIsNewSegment() const;
+  void advance();
+  void retire(Window *window);
+
+  const string basename_;
+  const string hostname_;
+  const size_t segmentSize_; // rollSize向上取整到windowSize_的整数倍
+  const size_t windowSize_;
+  const int flushInterval_;
+  LogCompressor *compressor_;
+
+  mutable MutexLock mutex_;
+  Condition cond_;
+  Window current_;
+  size_t pos_; // current_中已写入的字节数
+  Window next_; // 后台线程准备好的下一个窗口
+  std::vector<Window> retired_; // 等待后台线程msync/munmap的窗口
+  bool rollPending_;            // 跨天，下一个窗口要换新文件
+  bool flushPending_;
+  bool running_;
+  int64_t inlineMaps_;
+
+  Thread thread_;
+
+  const static int kRollPerSeconds_ = 60 * 60 * 24;
+};
+
+} // namespace muduo
+#endif // MUDUO_BASE_MMAPLOGFILE_H
@@ -0,0 +1,37 @@
+#include "Mutex.h"
+#include "LockProfiler.h"
+
+using namespace muduo;
+
+namespace muduo {
+namespace detail {
+std::atomic<bool> g_lockProfiling(false);
+} // namespace detail
+} // namespace muduo
+
+MutexLock::MutexLock(const char *site)
+    : holder_(0), site_(LockProfiler::site(site)), lockedAt_(0) {
+  int ret = pthread_mutex_init(&mutex_, NULL);
+  assert(ret == 0);
+  (void)ret;
+}
+
+void MutexLock::lockProfiled() {
+  if (pthread_mutex_trylock(&mutex_) != 0) {
+    int64_t start = LockProfiler::nowNanos();
+    pthread_mutex_lock(&mutex_);
+    startHold();
+    site_->contentions.fetch_add(1, std::memory_order_relaxed);
+    site_->recordWait(lockedAt_ - start);
+  } else {
+    startHold();
+  }
+  site_->acquisitions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MutexLock::startHold() { lockedAt_ = LockProfiler::nowNanos(); }
+
+void MutexLock::recordHold() {
+  site_->recordHold(LockProfiler::nowNanos() - lockedAt_);
+  lockedAt_ = 0;
+}
@@ -8,19 +8,30 @@
 
 #include "CurrentThread.h"
 #include <assert.h>
+#include <atomic>
 #include <boost/noncopyable.hpp>
 #include <pthread.h>
+#include <stdint.h>
 
 namespace muduo {
 
+struct LockSite;
+
+namespace detail {
+extern std::atomic<bool> g_lockProfiling;
+} // namespace detail
+
 class MutexLock : boost::noncopyable {
 public:
-  MutexLock() : holder_(0) {
+  MutexLock() : holder_(0), site_(NULL), lockedAt_(0) {
     int ret = pthread_mutex_init(&mutex_, NULL);//初始化互斥量(mutex_)
     assert(ret == 0);//断言初始化成功
     // (void)ret;
   }
 
+  // site是加锁位置的名字，同名的锁共用一组统计，见LockProfiler
+  explicit MutexLock(const char *site);
+
   ~MutexLock() {
     assert(holder_ == 0);//确保互斥量销毁时，已经没人持有它
     int ret = pthread_mutex_destroy(&mutex_);
@@ -35,12 +46,20 @@ public:
   // internal usage
 
   void lock() {
-    pthread_mutex_lock(&mutex_);
-    holder_ = CurrentThread::tid();
+    // 没有打开LockProfiler时只多一次relaxed load
+    if (site_ && detail::g_lockProfiling.load(std::memory_order_relaxed)) {
+      lockProfiled();
+    } else {
+      pthread_mutex_lock(&mutex_);
+    }
+    assignHolder();
   }
 
   void unlock() {
-    holder_ = 0;
+    if (lockedAt_ != 0) {
+      recordHold();
+    }
+    unassignHolder();
     pthread_mutex_unlock(&mutex_);
   }
 
@@ -51,8 +70,43 @@ public:
   }
 
 private:
+  friend class Condition;
+
+  // Condition::wait()期间mutex_被pthread_cond_wait()释放，
+  // 相应地清除holder_并结束这一段持有时间，醒来后再恢复
+  class UnassignGuard : boost::noncopyable {
+  public:
+    explicit UnassignGuard(MutexLock &owner) : owner_(owner) {
+      if (owner_.lockedAt_ != 0) {
+        owner_.recordHold();
+      }
+      owner_.unassignHolder();
+    }
+
+    ~UnassignGuard() {
+      owner_.assignHolder();
+      if (owner_.site_ &&
+          detail::g_lockProfiling.load(std::memory_order_relaxed)) {
+        owner_.startHold();
+      }
+    }
+
+  private:
+    MutexLock &owner_;
+  };
+
+  void assignHolder() { holder_ = CurrentThread::tid(); }
+  void unassignHolder() { holder_ = 0; }
+
+  // 以下在Mutex.cpp中
+  void lockProfiled();
+  void startHold();
+  void recordHold();
+
   pthread_mutex_t mutex_;//互斥量
   pid_t holder_;//持有者的线程标识(tid)
+  LockSite *site_;
+  int64_t lockedAt_; // 取得锁的时刻（纳秒），0表示这次加锁没有计时
 };
 
 class MutexLockGuard : boost::noncopyable {
@@ -0,0 +1,73 @@
+#ifndef MUDUO_BASE_RWLOCK_H
+#define MUDUO_BASE_RWLOCK_H
+
+#include <assert.h>
+#include <boost/noncopyable.hpp>
+#include <pthread.h>
+
+namespace muduo {
+
+///
+/// 写者优先的读写锁，用于读多写少的表（路由表、连接集合等）。
+///
+/// glibc默认的pthread_rwlock_t读者优先，持续的读请求会让写者饿死；
+/// 这里设为PREFER_WRITER_NONRECURSIVE：有写者在等待时，新的读者也要等待。
+/// 因此同一线程不能重复加读锁。
+///
+class RWLock : boost::noncopyable {
+public:
+  RWLock() {
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    pthread_rwlockattr_setkind_np(&attr,
+                                  PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    int ret = pthread_rwlock_init(&rwlock_, &attr);
+    assert(ret == 0);
+    (void)ret;
+    pthread_rwlockattr_destroy(&attr);
+  }
+
+  ~RWLock() {
+    int ret = pthread_rwlock_destroy(&rwlock_);
+    assert(ret == 0);
+    (void)ret;
+  }
+
+  // internal usage
+
+  void readLock() { pthread_rwlock_rdlock(&rwlock_); }
+  void writeLock() { pthread_rwlock_wrlock(&rwlock_); }
+  void unlock() { pthread_rwlock_unlock(&rwlock_); }
+
+private:
+  pthread_rwlock_t rwlock_;
+};
+
+class ReadLockGuard : boost::noncopyable {
+public:
+  explicit ReadLockGuard(RWLock &lock) : lock_(lock) { lock_.readLock(); }
+  ~ReadLockGuard() { lock_.unlock(); }
+
+private:
+  RWLock &lock_;
+};
+
+class WriteLockGuard : boost::noncopyable {
+public:
+  explicit WriteLockGuard(RWLock &lock) : lock_(lock) { lock_.writeLock(); }
+  ~WriteLockGuard() { lock_.unlock(); }
+
+private:
+  RWLock &lock_;
+};
+
+} // namespace muduo
+
+// Prevent misuse like:
+// ReadLockGuard(lock_);
+#define ReadLockGuard(x) error "Missing guard object name"
+#define WriteLockGuard(x) error "Missing guard object name"
+
+#endif // MUDUO_BASE_RWLOCK_H
@@ -0,0 +1,147 @@
+#ifndef MUDUO_BASE_SEQLOCK_H
+#define MUDUO_BASE_SEQLOCK_H
+
+#include "Futex.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+namespace muduo {
+
+template <typename T> class SeqLockWriteGuard;
+
+///
+/// 保护一小块POD数据的顺序锁，读者不写任何共享内存。
+///
+/// 写者把序号加一（变为奇数）、写数据、再加一；读者读数据前后各读一次序号，
+/// 两次相同且为偶数才算读到一致的快照，否则重试。适合读远多于写、
+/// T只有几十字节的场合，例如统计快照、配置参数。
+///
+/// 数据按8字节拆成relaxed原子变量保存，读写与写者并发时没有数据竞争。
+/// 写者之间用序号的CAS互斥，写者应当很少。
+///
+template <typename T> class SeqLock : boost::noncopyable {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock<T> requires a trivially copyable T");
+
+public:
+  SeqLock() : seq_(0) { store(T()); }
+  explicit SeqLock(const T &value) : seq_(0) { store(value); }
+
+  T read() const {
+    T value;
+    for (int spins = 0;; ++spins) {
+      uint32_t s1 = seq_.load(std::memory_order_acquire);
+      if (s1 & 1) {
+        backoff(spins);
+        continue;
+      }
+      load(&value);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == s1) {
+        return value;
+      }
+    }
+  }
+
+  void write(const T &value) {
+    beginWrite();
+    store(value);
+    endWrite();
+  }
+
+private:
+  friend class SeqLockWriteGuard<T>;
+
+  static const int kSpinCount = 64;
+  static const size_t kWords =
+      (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  void beginWrite() {
+    uint32_t s = seq_.load(std::memory_order_relaxed);
+    for (int spins = 0;; ++spins) {
+      if ((s & 1) == 0 &&
+          seq_.compare_exchange_weak(s, s + 1, std::memory_order_relaxed)) {
+        break;
+      }
+      backoff(spins);
+      s = seq_.load(std::memory_order_relaxed);
+    }
+    // 序号变为奇数必须先于数据的写入被看到
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  // 写者被抢占时自旋没有意义，自旋一阵（单核上不自旋）后让出CPU
+  static void backoff(int spins) {
+    if (spins < kSpinCount && detail::spinWorthwhile()) {
+      detail::cpuRelax();
+    } else {
+      ::sched_yield();
+    }
+  }
+
+  void endWrite() { seq_.fetch_add(1, std::memory_order_release); }
+
+  void load(T *value) const {
+    uint64_t buf[kWords];
+    for (size_t i = 0; i < kWords; ++i) {
+      buf[i] = data_[i].load(std::memory_order_relaxed);
+    }
+    memcpy(value, buf, sizeof(T));
+  }
+
+  void store(const T &value) {
+    uint64_t buf[kWords] = {0};
+    memcpy(buf, &value, sizeof(T));
+    for (size_t i = 0; i < kWords; ++i) {
+      data_[i].store(buf[i], std::memory_order_relaxed);
+    }
+  }
+
+  // 写者持有锁时读当前值，不需要校验序号
+  T current() const {
+    T value;
+    load(&value);
+    return value;
+  }
+
+  std::atomic<uint32_t> seq_;
+  std::atomic<uint64_t> data_[kWords];
+};
+
+///
+/// 写者的RAII guard：构造时取得写锁并复制当前值，
+/// 通过value()修改，析构时写回并释放写锁。
+///
+///   {
+///     SeqLockWriteGuard<Stats> guard(statsLock_);
+///     guard.value().bytes += n;
+///   }
+///
+template <typename T> class SeqLockWriteGuard : boost::noncopyable {
+public:
+  explicit SeqLockWriteGuard(SeqLock<T> &lock) : lock_(lock) {
+    lock_.beginWrite();
+    value_ = lock_.current();
+  }
+
+  ~SeqLockWriteGuard() {
+    lock_.store(value_);
+    lock_.endWrite();
+  }
+
+  T &value() { return value_; }
+
+private:
+  SeqLock<T> &lock_;
+  T value_;
+};
+
+} // namespace muduo
+
+#endif // MUDUO_BASE_SEQLOCK_H
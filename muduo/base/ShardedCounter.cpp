@@ -0,0 +1,71 @@
+#include "ShardedCounter.h"
+
+#include <new>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace muduo {
+namespace detail {
+
+__thread int t_counterShard = -1;
+
+namespace {
+AtomicInt32 g_nextShard;
+}
+
+int assignCounterShard() {
+  t_counterShard = g_nextShard.getAndAdd(1, std::memory_order_relaxed);
+  return t_counterShard;
+}
+
+} // namespace detail
+} // namespace muduo
+
+using namespace muduo;
+
+namespace {
+
+int roundUpShards(int n) {
+  if (n <= 0) {
+    n = static_cast<int>(::sysconf(_SC_NPROCESSORS_ONLN));
+  }
+  int c = 1;
+  while (c < n) {
+    c <<= 1;
+  }
+  return c;
+}
+
+} // namespace
+
+ShardedCounter::ShardedCounter(int numShards)
+    : mask_(roundUpShards(numShards) - 1), shards_(NULL) {
+  // new[]不保证按cache line对齐
+  void *p = NULL;
+  int ret = ::posix_memalign(&p, kCacheLineSize, sizeof(Shard) * (mask_ + 1));
+  if (ret != 0) {
+    throw std::bad_alloc();
+  }
+  shards_ = static_cast<Shard *>(p);
+  for (int i = 0; i <= mask_; ++i) {
+    new (&shards_[i].value) std::atomic<int64_t>(0);
+  }
+}
+
+ShardedCounter::~ShardedCounter() { ::free(shards_); }
+
+int64_t ShardedCounter::get() const {
+  int64_t sum = 0;
+  for (int i = 0; i <= mask_; ++i) {
+    sum += shards_[i].value.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+int64_t ShardedCounter::getAndReset() {
+  int64_t sum = 0;
+  for (int i = 0; i <= mask_; ++i) {
+    sum += shards_[i].value.exchange(0, std::memory_order_relaxed);
+  }
+  return sum;
+}
@@ -0,0 +1,60 @@
+#ifndef MUDUO_BASE_SHARDEDCOUNTER_H
+#define MUDUO_BASE_SHARDEDCOUNTER_H
+
+#include "Atomic.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <stdint.h>
+
+namespace muduo {
+
+namespace detail {
+extern __thread int t_counterShard;
+int assignCounterShard();
+} // namespace detail
+
+///
+/// 分片计数器，用于所有IO线程都会累加的统计量。
+///
+/// 每个分片独占一个cache line，线程第一次使用时轮流分配一个分片号，
+/// add()只对自己的分片做relaxed fetch_add，不会与其他线程争抢同一个cache line。
+/// get()把全部分片相加，结果是近似的瞬时值，适合读得少、写得多的场合。
+///
+class ShardedCounter : boost::noncopyable {
+public:
+  // numShards向上取整为2的幂，默认取在线CPU数
+  explicit ShardedCounter(int numShards = 0);
+  ~ShardedCounter();
+
+  void add(int64_t x) {
+    int shard = detail::t_counterShard;
+    if (shard < 0) {
+      shard = detail::assignCounterShard();
+    }
+    shards_[shard & mask_].value.fetch_add(x, std::memory_order_relaxed);
+  }
+
+  void increment() { add(1); }
+  void decrement() { add(-1); }
+
+  int64_t get() const;
+  // 读出并清零，只保证每次累加恰好被某一次getAndReset()读到
+  int64_t getAndReset();
+
+  int numShards() const { return mask_ + 1; }
+
+private:
+  struct Shard {
+    std::atomic<int64_t> value;
+    char pad[kCacheLineSize - sizeof(std::atomic<int64_t>)];
+  };
+
+  const int mask_;
+  Shard *shards_;
+};
+
+} // namespace muduo
+
+#endif // MUDUO_BASE_SHARDEDCOUNTER_H
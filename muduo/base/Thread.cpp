@@ -84,11 +84,11 @@ void CurrentThread::cacheTid() {
 bool CurrentThread::isMainThread() { return tid() == ::getpid(); }
 
 //创建线程的数量; 初始化，调用无参构造函数
-AtomicInt32 Thread::numCreated_;
+CacheLinePadded<AtomicInt32> Thread::numCreated_;
 
 Thread::Thread(const ThreadFunc &func, const string &name)
     : started_(false), pthreadId_(0), tid_(0), func_(func), name_(name) {
-  numCreated_.increment();
+  numCreated_.value.increment();
 }
 
 Thread::~Thread() {
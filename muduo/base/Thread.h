@@ -30,7 +30,7 @@ public:
   pid_t tid() const { return tid_; }
   const string &name() const { return name_; }
 
-  static int numCreated() { return numCreated_.get(); }
+  static int numCreated() { return numCreated_.value.get(); }
 
 private:
   static void *startThread(void *thread);
@@ -42,8 +42,8 @@ private:
   ThreadFunc func_;
   string name_;
 
-  //记录创建线程的数量
-  static AtomicInt32 numCreated_; //需要初始化，现在只是声明
+  //记录创建线程的数量，各线程都可能创建线程，单独占一个cache line
+  static CacheLinePadded<AtomicInt32> numCreated_; //需要初始化，现在只是声明
 };
 
 } // namespace muduo
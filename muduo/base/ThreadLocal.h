@@ -34,6 +34,8 @@ private:
     T *obj = static_cast<T *>(x);
     typedef char T_must_be_complete_type
         [sizeof(T) == 0 ? -1 : 1]; //保证编译阶段就能知道T类型是完全类型
+    T_must_be_complete_type dummy;
+    (void)dummy;
     delete obj;
   }
 
@@ -9,12 +9,14 @@
 #include <assert.h>
 #include <boost/bind.hpp>
 #include <stdio.h>
+#include <string.h>
 
 using namespace muduo;
 
 ThreadPool::ThreadPool(const string &name)
-    : mutex_(), cond_(mutex_), name_(name), running_(false) {
-  ;
+    : mutex_("ThreadPool::mutex_"), notEmpty_(mutex_), notFull_(mutex_), name_(name),
+      maxQueueSize_(0), policy_(kBlock), running_(false) {
+  memset(&stats_, 0, sizeof stats_);
 }
 
 ThreadPool::~ThreadPool() {
@@ -42,20 +44,201 @@ void ThreadPool::stop() {
   {
     MutexLockGuard lock(mutex_);
     running_ = false;
-    cond_.notifyAll();
+    notEmpty_.notifyAll();
+    notFull_.notifyAll();
   }
   for_each(threads_.begin(), threads_.end(),
            boost::bind(&muduo::Thread::join, _1));
+
+  // 剩下的任务不会再执行，取消它们的future
+  std::deque<Entry> left;
+  {
+    MutexLockGuard lock(mutex_);
+    left.swap(queue_);
+  }
+  for (size_t i = 0; i < left.size(); ++i) {
+    if (left[i].cancel) {
+      left[i].cancel();
+    }
+  }
 }
 
 //通过线程池执行传入的任务(task)
-void ThreadPool::run(const Task &task) {
+void ThreadPool::run(const Task &task) { runOrCancel(task, Task()); }
+
+// cancel在task被丢弃或者不会执行时调用
+void ThreadPool::runOrCancel(const Task &task, const Task &cancel) {
+  if (threads_.empty()) {
+    task();
+    return;
+  }
+
+  bool runInCaller = false;
+  bool rejected = false;
+  Task dropped;
+  {
+    MutexLockGuard lock(mutex_);
+    if (!running_) {
+      rejected = true;
+    } else if (isFull()) {
+      switch (policy_) {
+      case kCallerRuns:
+        ++stats_.callerRuns;
+        runInCaller = true;
+        break;
+      case kDropOldest:
+        dropped.swap(queue_.front().cancel);
+        queue_.pop_front();
+        ++stats_.dropped;
+        break;
+      case kBlock: {
+        Timestamp start(Timestamp::now());
+        while (isFull() && running_) {
+          notFull_.wait();
+        }
+        stats_.blockedUs += Timestamp::now().microSecondsSinceEpoch() -
+                            start.microSecondsSinceEpoch();
+        rejected = !running_;
+        break;
+      }
+      }
+    }
+    if (!runInCaller && !rejected) {
+      enqueue(task, cancel);
+      notEmpty_.notify();
+    }
+  }
+  // 在锁外执行，不阻塞其他提交者和工作线程
+  if (runInCaller) {
+    task();
+  }
+  if (dropped) {
+    dropped();
+  }
+  if (rejected && cancel) {
+    cancel();
+  }
+}
+
+bool ThreadPool::tryRun(const Task &task) {
   if (threads_.empty()) {
     task();
-  } else {
+    return true;
+  }
+
+  MutexLockGuard lock(mutex_);
+  // 停止后没有工作线程，stop()也已经清空了队列，放进去的任务不会执行
+  if (!running_ || isFull()) {
+    ++stats_.rejected;
+    return false;
+  }
+  enqueue(task, Task());
+  notEmpty_.notify();
+  return true;
+}
+
+namespace {
+
+void runBatchTask(const boost::shared_ptr<detail::WhenAllVoidState> &state,
+                  const ThreadPool::Task &task) {
+  task();
+  state->onResult();
+}
+
+} // namespace
+
+Future<void> ThreadPool::submitBatch(const std::vector<Task> &tasks) {
+  boost::shared_ptr<detail::WhenAllVoidState> state(
+      new detail::WhenAllVoidState(tasks.size()));
+  Future<void> future = state->promise.getFuture();
+  if (tasks.empty()) {
+    state->promise.setValue();
+    return future;
+  }
+  if (threads_.empty()) {
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      runBatchTask(state, tasks[i]);
+    }
+    return future;
+  }
+
+  Task cancel(boost::bind(&detail::WhenAllVoidState::onCancel, state));
+  std::vector<Task> callerRuns;
+  std::vector<Task> dropped;
+  size_t rejected = 0; // 线程池停止，没有放进队列的任务数
+  {
     MutexLockGuard lock(mutex_);
-    queue_.push_back(task);
-    cond_.notify();
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      if (!running_) {
+        rejected = tasks.size() - i;
+        break;
+      }
+      Task task(boost::bind(&runBatchTask, state, tasks[i]));
+      if (isFull()) {
+        if (policy_ == kCallerRuns) {
+          ++stats_.callerRuns;
+          callerRuns.push_back(task);
+          continue;
+        } else if (policy_ == kDropOldest) {
+          if (queue_.front().cancel) {
+            dropped.push_back(queue_.front().cancel);
+          }
+          queue_.pop_front();
+          ++stats_.dropped;
+        } else {
+          // 先唤醒工作线程腾出空位，再等待
+          notEmpty_.notifyAll();
+          Timestamp start(Timestamp::now());
+          while (isFull() && running_) {
+            notFull_.wait();
+          }
+          stats_.blockedUs += Timestamp::now().microSecondsSinceEpoch() -
+                              start.microSecondsSinceEpoch();
+          if (!running_) {
+            rejected = tasks.size() - i;
+            break;
+          }
+        }
+      }
+      enqueue(task, cancel);
+    }
+    notEmpty_.notifyAll();
+  }
+
+  for (size_t i = 0; i < callerRuns.size(); ++i) {
+    callerRuns[i]();
+  }
+  for (size_t i = 0; i < dropped.size(); ++i) {
+    dropped[i]();
+  }
+  for (size_t i = 0; i < rejected; ++i) {
+    cancel();
+  }
+  return future;
+}
+
+size_t ThreadPool::queueSize() const {
+  MutexLockGuard lock(mutex_);
+  return queue_.size();
+}
+
+ThreadPool::Stats ThreadPool::stats() const {
+  MutexLockGuard lock(mutex_);
+  Stats s = stats_;
+  s.queueSize = queue_.size();
+  return s;
+}
+
+// 以下函数调用时必须持有mutex_
+bool ThreadPool::isFull() const {
+  return maxQueueSize_ > 0 && queue_.size() >= maxQueueSize_;
+}
+
+void ThreadPool::enqueue(const Task &task, const Task &cancel) {
+  queue_.push_back(Entry(task, cancel, Timestamp::now()));
+  ++stats_.queued;
+  if (queue_.size() > stats_.peakQueueSize) {
+    stats_.peakQueueSize = queue_.size();
   }
 }
 
@@ -63,13 +246,23 @@ ThreadPool::Task ThreadPool::take() {
   MutexLockGuard lock(mutex_);
   // always use a while-loop, due to spurious wakeup
   while (queue_.empty() && running_) {
-    cond_.wait();
+    notEmpty_.wait();
   }
 
   Task task;
   if (!queue_.empty()) {
-    task = queue_.front();
+    Entry &front = queue_.front();
+    int64_t waitUs = Timestamp::now().microSecondsSinceEpoch() -
+                     front.enqueueTime.microSecondsSinceEpoch();
+    stats_.totalWaitUs += waitUs;
+    if (waitUs > stats_.maxWaitUs) {
+      stats_.maxWaitUs = waitUs;
+    }
+    task.swap(front.task);
     queue_.pop_front();
+    if (maxQueueSize_ > 0) {
+      notFull_.notify();
+    }
   }
 
   return task;
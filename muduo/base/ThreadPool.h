@@ -7,8 +7,10 @@
 #define MUDUO_BASE_THREADPOOL_H
 
 #include "Condition.h"
+#include "Future.h"
 #include "Mutex.h"
 #include "Thread.h"
+#include "Timestamp.h"
 // #include "Types.h"
 
 #include <boost/function.hpp>
@@ -16,6 +18,8 @@
 #include <boost/ptr_container/ptr_vector.hpp>
 
 #include <deque>
+#include <type_traits>
+#include <vector>
 
 namespace muduo {
 
@@ -23,26 +27,97 @@ class ThreadPool : boost::noncopyable {
 public:
   typedef boost::function<void()> Task;
 
+  // 队列满时run()的行为
+  enum RejectPolicy {
+    kBlock,       // 等待，直到队列有空位
+    kCallerRuns,  // 在调用run()的线程里直接执行
+    kDropOldest,  // 丢弃队列中最旧的任务，submit()的future被取消
+  };
+
+  // 队列统计，时间单位为微秒
+  struct Stats {
+    size_t queueSize;     // 当前排队的任务数
+    size_t peakQueueSize; // 历史最大排队数
+    int64_t queued;       // 进入过队列的任务总数
+    int64_t callerRuns;   // kCallerRuns: 在调用者线程执行的任务数
+    int64_t dropped;      // kDropOldest: 被丢弃的任务数
+    int64_t rejected;     // tryRun()返回false的次数
+    int64_t totalWaitUs;  // 任务在队列中等待的总时间
+    int64_t maxWaitUs;    // 单个任务在队列中等待的最长时间
+    int64_t blockedUs;    // kBlock: 调用者在run()里等待空位的总时间
+  };
+
   explicit ThreadPool(const string &name = string());
   ~ThreadPool();
 
+  // 必须在start()之前调用，0表示不限长度（默认）
+  void setMaxQueueSize(int maxSize) {
+    assert(maxSize >= 0);
+    maxQueueSize_ = static_cast<size_t>(maxSize);
+  }
+  void setRejectPolicy(RejectPolicy policy) { policy_ = policy; }
+
   void start(int numThreads);
   void stop();
 
   void run(const Task &f);
+  // 队列满或者线程池已经停止时不等待，直接返回false
+  bool tryRun(const Task &f);
+
+  // 与run()相同，返回的Future在f执行完后给出f的返回值。
+  // f被丢弃、或者因为线程池停止而不会执行时，Future被取消
+  template <typename F>
+  Future<typename std::result_of<typename std::decay<F>::type()>::type>
+  submit(const F &f);
+
+  // 一次加锁、一次notifyAll放入一批任务，返回的Future在全部任务完成后就绪。
+  // 队列满时按RejectPolicy处理；其中有任务被丢弃或者不会执行时，
+  // Future在其余任务都结束后被取消
+  Future<void> submitBatch(const std::vector<Task> &tasks);
+
+  size_t queueSize() const;
+  Stats stats() const;
 
 private:
+  struct Entry {
+    Entry(const Task &t, const Task &c, Timestamp e)
+        : task(t), cancel(c), enqueueTime(e) {}
+
+    Task task;
+    Task cancel; // 任务被丢弃或者线程池停止时调用，可以为空
+    Timestamp enqueueTime;
+  };
+
+  void runOrCancel(const Task &task, const Task &cancel);
+  bool isFull() const;
+  void enqueue(const Task &task, const Task &cancel);
   void runInThread();
   Task take();
 
-  MutexLock mutex_;
-  Condition cond_;
+  mutable MutexLock mutex_;
+  Condition notEmpty_;
+  Condition notFull_;
   string name_;
   boost::ptr_vector<muduo::Thread> threads_;
-  std::deque<Task> queue_;//任务队列
+  std::deque<Entry> queue_;//任务队列
+  size_t maxQueueSize_;
+  RejectPolicy policy_;
   bool running_;
+  Stats stats_;
 };
 
+template <typename F>
+Future<typename std::result_of<typename std::decay<F>::type()>::type>
+ThreadPool::submit(const F &f) {
+  typedef typename std::result_of<typename std::decay<F>::type()>::type R;
+  Promise<R> promise;
+  // 先转成boost::function，避免f本身是bind表达式时被外层bind立即求值
+  runOrCancel(boost::bind(&detail::RunAndSet<R>::run, promise,
+                          boost::function<R()>(f)),
+              boost::bind(&Promise<R>::cancel, promise));
+  return promise.getFuture();
+}
+
 } // namespace muduo
 
 #endif
@@ -0,0 +1,140 @@
+#ifndef MUDUO_BASE_WORKSTEALINGDEQUE_H
+#define MUDUO_BASE_WORKSTEALINGDEQUE_H
+
+#include <boost/noncopyable.hpp>
+
+#include <assert.h>
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+namespace muduo {
+
+///
+/// Chase-Lev work-stealing deque.
+/// "Dynamic Circular Work-Stealing Deque", SPAA 2005;
+/// 内存序取自 "Correct and Efficient Work-Stealing for Weak Memory Models",
+/// PPoPP 2013.
+///
+/// 只有拥有者线程可以push()/take()（LIFO一端），
+/// 任何线程都可以steal()（FIFO一端）。T必须是指针之类可以原子读写的类型，
+/// 空值用T()表示。
+///
+template <typename T> class WorkStealingDeque : boost::noncopyable {
+public:
+  explicit WorkStealingDeque(int64_t capacity = 1024)
+      : top_(0), bottom_(0), array_(new Array(capacity)) {
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    garbage_.push_back(array_.load(std::memory_order_relaxed));
+  }
+
+  ~WorkStealingDeque() {
+    for (size_t i = 0; i < garbage_.size(); ++i) {
+      delete garbage_[i];
+    }
+  }
+
+  // owner only
+  void push(T x) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Array *a = array_.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1) {
+      a = grow(a, b, t);
+    }
+    a->put(b, x);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // owner only, 空时返回T()
+  T take() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Array *a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+
+    T x = T();
+    if (t <= b) {
+      x = a->get(b);
+      if (t == b) {
+        // 只剩最后一个元素，与steal()竞争
+        if (!top_.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+          x = T();
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return x;
+  }
+
+  // 任何线程，空或者与别人竞争失败时返回T()
+  T steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+
+    T x = T();
+    if (t < b) {
+      Array *a = array_.load(std::memory_order_acquire);
+      x = a->get(t);
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        x = T();
+      }
+    }
+    return x;
+  }
+
+  // 近似值，只用于判断是否值得去偷
+  int64_t size() const {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? b - t : 0;
+  }
+
+private:
+  struct Array : boost::noncopyable {
+    explicit Array(int64_t c)
+        : capacity(c), mask(c - 1), buffer(new std::atomic<T>[c]) {}
+    ~Array() { delete[] buffer; }
+
+    T get(int64_t i) const {
+      return buffer[i & mask].load(std::memory_order_relaxed);
+    }
+    void put(int64_t i, T x) {
+      buffer[i & mask].store(x, std::memory_order_relaxed);
+    }
+
+    const int64_t capacity;
+    const int64_t mask;
+    std::atomic<T> *buffer;
+  };
+
+  // 旧数组可能仍在被steal()读取，留到析构时再释放
+  Array *grow(Array *a, int64_t b, int64_t t) {
+    Array *bigger = new Array(a->capacity * 2);
+    for (int64_t i = t; i < b; ++i) {
+      bigger->put(i, a->get(i));
+    }
+    garbage_.push_back(bigger);
+    array_.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  // top_和bottom_分别被偷取者和拥有者频繁修改，放在不同的cache line
+  std::atomic<int64_t> top_;
+  char pad_[64 - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> bottom_;
+  std::atomic<Array *> array_;
+  std::vector<Array *> garbage_; // owner only
+};
+
+} // namespace muduo
+
+#endif // MUDUO_BASE_WORKSTEALINGDEQUE_H
@@ -0,0 +1,211 @@
+#include "WorkStealingThreadPool.h"
+#include "Exception.h"
+
+#include <assert.h>
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <sched.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+namespace {
+
+// 当前线程所属的线程池及其下标，用来判断run()是否来自工作线程
+__thread WorkStealingThreadPool *t_pool = NULL;
+__thread int t_index = -1;
+__thread uint32_t t_seed = 0;
+
+// 偷取时随机选择起点，避免所有空闲线程挤在同一个victim上
+uint32_t nextRandom() {
+  uint32_t x = t_seed;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  t_seed = x;
+  return x;
+}
+
+const int kSpinCount = 64;
+
+} // namespace
+
+struct WorkStealingThreadPool::Worker : boost::noncopyable {
+  Worker() : inboxSize(0) {}
+
+  WorkStealingDeque<Task *> deque;
+  MutexLock inboxMutex;
+  std::deque<Task *> inbox; // 外部线程提交的任务
+  std::atomic<size_t> inboxSize;
+};
+
+WorkStealingThreadPool::WorkStealingThreadPool(const string &name)
+    : name_(name), running_(false), nextInbox_(0), sleepers_(0), mutex_(),
+      cond_(mutex_) {}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  if (running_) {
+    stop();
+  }
+}
+
+void WorkStealingThreadPool::start(int numThreads) {
+  assert(threads_.empty());
+  running_ = true;
+  workers_.reserve(numThreads);
+  threads_.reserve(numThreads);
+
+  for (int i = 0; i < numThreads; ++i) {
+    workers_.push_back(new Worker);
+  }
+  for (int i = 0; i < numThreads; ++i) {
+    char id[32];
+    snprintf(id, sizeof id, "%d", i);
+    threads_.push_back(new muduo::Thread(
+        boost::bind(&WorkStealingThreadPool::runInThread, this, i),
+        name_ + id));
+    threads_[i].start();
+  }
+}
+
+void WorkStealingThreadPool::stop() {
+  running_ = false;
+  {
+    MutexLockGuard lock(mutex_);
+    cond_.notifyAll();
+  }
+  for_each(threads_.begin(), threads_.end(),
+           boost::bind(&muduo::Thread::join, _1));
+
+  // 与ThreadPool一样，stop()之后未执行的任务直接丢弃
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    Worker &w = workers_[i];
+    while (Task *task = w.deque.take()) {
+      delete task;
+    }
+    for (size_t j = 0; j < w.inbox.size(); ++j) {
+      delete w.inbox[j];
+    }
+    w.inbox.clear();
+  }
+}
+
+void WorkStealingThreadPool::run(const Task &task) {
+  if (threads_.empty()) {
+    task();
+    return;
+  }
+
+  Task *t = new Task(task);
+  if (t_pool == this) {
+    workers_[t_index].deque.push(t);
+  } else {
+    unsigned i = nextInbox_.fetch_add(1, std::memory_order_relaxed) %
+                 static_cast<unsigned>(workers_.size());
+    Worker &w = workers_[i];
+    MutexLockGuard lock(w.inboxMutex);
+    w.inbox.push_back(t);
+    w.inboxSize.store(w.inbox.size(), std::memory_order_relaxed);
+  }
+  wakeup();
+}
+
+void WorkStealingThreadPool::wakeup() {
+  // 与runInThread()里睡眠前的fence配对：要么这里看到sleepers_ > 0，
+  // 要么睡眠线程在hasWork()里看到刚放进去的任务
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleepers_.load(std::memory_order_relaxed) > 0) {
+    MutexLockGuard lock(mutex_);
+    cond_.notify();
+  }
+}
+
+bool WorkStealingThreadPool::hasWork() const {
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    const Worker &w = workers_[i];
+    if (w.deque.size() > 0 || w.inboxSize.load(std::memory_order_relaxed) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+WorkStealingThreadPool::Task *WorkStealingThreadPool::stealFrom(int victim) {
+  Worker &w = workers_[victim];
+  Task *task = w.deque.steal();
+  if (task == NULL && w.inboxSize.load(std::memory_order_relaxed) > 0) {
+    MutexLockGuard lock(w.inboxMutex);
+    if (!w.inbox.empty()) {
+      task = w.inbox.front();
+      w.inbox.pop_front();
+      w.inboxSize.store(w.inbox.size(), std::memory_order_relaxed);
+    }
+  }
+  return task;
+}
+
+WorkStealingThreadPool::Task *WorkStealingThreadPool::take(int index) {
+  Worker &self = workers_[index];
+  // 自己的deque是LIFO，刚产生的子任务cache最热
+  Task *task = self.deque.take();
+  if (task == NULL) {
+    task = stealFrom(index);
+  }
+
+  int n = static_cast<int>(workers_.size());
+  int start = static_cast<int>(nextRandom() % static_cast<uint32_t>(n));
+  for (int i = 0; task == NULL && i < n; ++i) {
+    int victim = (start + i) % n;
+    if (victim != index) {
+      task = stealFrom(victim);
+    }
+  }
+  return task;
+}
+
+void WorkStealingThreadPool::runInThread(int index) {
+  t_pool = this;
+  t_index = index;
+  t_seed = static_cast<uint32_t>(index) * 2654435761u + 1;
+  try {
+    while (running_) {
+      Task *task = take(index);
+      for (int spin = 0; task == NULL && spin < kSpinCount && running_;
+           ++spin) {
+        ::sched_yield();
+        task = take(index);
+      }
+
+      if (task) {
+        boost::scoped_ptr<Task> holder(task);
+        (*task)();
+        continue;
+      }
+
+      MutexLockGuard lock(mutex_);
+      sleepers_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (running_ && !hasWork()) {
+        cond_.wait();
+      }
+      sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  } catch (const Exception &ex) {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n",
+            name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    fprintf(stderr, "stack trace: %s\n", ex.stackTrace());
+    abort();
+  } catch (const std::exception &ex) {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n",
+            name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    abort();
+  } catch (...) {
+    fprintf(stderr, "unknown exception caught in WorkStealingThreadPool %s\n",
+            name_.c_str());
+    throw; // rethrow
+  }
+  t_pool = NULL;
+  t_index = -1;
+}
@@ -0,0 +1,61 @@
+#ifndef MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+#define MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+
+#include "Condition.h"
+#include "Mutex.h"
+#include "Thread.h"
+#include "WorkStealingDeque.h"
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <atomic>
+#include <deque>
+
+namespace muduo {
+
+///
+/// 与ThreadPool接口相同的work-stealing线程池。
+///
+/// 每个工作线程有自己的Chase-Lev deque：
+/// - 工作线程里调用run()，任务压入自己的deque，不加锁；
+/// - 其他线程调用run()，任务轮流放进各工作线程的收件箱（各自一把锁）；
+/// - 工作线程依次从自己的deque、收件箱取任务，都空了就随机去别的线程偷，
+///   还是没有才睡眠。
+///
+class WorkStealingThreadPool : boost::noncopyable {
+public:
+  typedef boost::function<void()> Task;
+
+  explicit WorkStealingThreadPool(const string &name = string());
+  ~WorkStealingThreadPool();
+
+  void start(int numThreads);
+  void stop();
+
+  void run(const Task &f);
+
+private:
+  struct Worker;
+
+  void runInThread(int index);
+  Task *take(int index);
+  Task *stealFrom(int victim);
+  bool hasWork() const;
+  void wakeup();
+
+  string name_;
+  boost::ptr_vector<Worker> workers_;
+  boost::ptr_vector<muduo::Thread> threads_;
+  std::atomic<bool> running_;
+  std::atomic<unsigned> nextInbox_; // 外部提交的轮转位置
+  std::atomic<int> sleepers_;
+
+  MutexLock mutex_; // 只用于睡眠/唤醒
+  Condition cond_;
+};
+
+} // namespace muduo
+
+#endif // MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
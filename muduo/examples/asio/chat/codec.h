@@ -4,6 +4,7 @@
 #include "Buffer.h"
 #include "Endian.h"
 #include "Logging.h"
+#include "SharedPayload.h"
 #include "TcpConnection.h"
 
 class LengthHeaderCodec : boost::noncopyable {
@@ -51,6 +52,16 @@ public:
     conn->send(&buf);
   }
 
+  // 广播时只编码一次，每个连接只引用同一份数据
+  muduo::net::SharedPayload encode(const muduo::StringPiece &message) {
+    muduo::net::Buffer buf;
+    buf.append(message.data(), message.size());
+    int32_t len = static_cast<int32_t>(message.size());
+    int32_t be32 = muduo::net::sockets::hostToNetwork32(len);
+    buf.prepend(&be32, sizeof be32);
+    return muduo::net::SharedPayload(&buf);
+  }
+
 private:
   StringMessageCallback messageCallback_;
   const static size_t kHeaderLen = sizeof(int32_t);
@@ -1,8 +1,8 @@
 #include "codec.h"
 
+#include "CowSnapshot.h"
 #include "EventLoop.h"
 #include "Logging.h"
-#include "Mutex.h"
 #include "TcpServer.h"
 
 
@@ -17,8 +17,10 @@ class ChatServer : boost::noncopyable {
 public:
   ChatServer(EventLoop *loop, const InetAddress &listenAddr)
       : server_(loop, listenAddr, "ChatServer"),
-        codec_(std::bind(&ChatServer::onStringMessage, this, _1, _2, _3)),
-        connections_(new ConnectionList) {
+        codec_(std::bind(&ChatServer::onStringMessage, this, _1, _2, _3)) {
+    // 旧的连接列表在主线程里删除
+    connections_.setReclaimExecutor(
+        std::bind(&EventLoop::queueInLoop, loop, _1));
     server_.setConnectionCallback(
         std::bind(&ChatServer::onConnection, this, _1));
     server_.setMessageCallback(
@@ -35,40 +37,30 @@ private:
              << conn->localAddress().toIpPort() << " is "
              << (conn->connected() ? "UP" : "DOWN");
 
-    MutexLockGuard lock(mutex_);
-    if (!connections_.unique()) {
-      connections_.reset(new ConnectionList(*connections_));
-    }
-    assert(connections_.unique());
-
     if (conn->connected()) {
-      connections_->insert(conn);
+      connections_.update(
+          [&conn](ConnectionList *connections) { connections->insert(conn); });
     } else {
-      connections_->erase(conn);
+      connections_.update(
+          [&conn](ConnectionList *connections) { connections->erase(conn); });
     }
   }
 
   typedef std::set<TcpConnectionPtr> ConnectionList;
-  typedef std::shared_ptr<ConnectionList> ConnectionListPtr;
 
   void onStringMessage(const TcpConnectionPtr &, const string &message,
                        Timestamp) {
-    ConnectionListPtr connections = getConnectionList();
-    for (ConnectionList::iterator it = connections->begin();
+    SharedPayload frame(codec_.encode(message));
+    CowSnapshot<ConnectionList>::ReadGuard connections(connections_);
+    for (ConnectionList::const_iterator it = connections->begin();
          it != connections->end(); ++it) {
-      codec_.send(get_pointer(*it), message);
+      (*it)->send(frame);
     }
   }
 
-  ConnectionListPtr getConnectionList() {
-    MutexLockGuard lock(mutex_);
-    return connections_;
-  }
-
   TcpServer server_;
   LengthHeaderCodec codec_;
-  MutexLock mutex_;
-  ConnectionListPtr connections_ GUARDED_BY(mutex_);
+  CowSnapshot<ConnectionList> connections_;
 };
 
 int main(int argc, char *argv[]) {
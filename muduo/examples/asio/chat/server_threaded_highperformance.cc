@@ -47,8 +47,9 @@ private:
 
   void onStringMessage(const TcpConnectionPtr &, const string &message,
                        Timestamp) {
-    EventLoop::Functor f =
-        std::bind(&ChatServer::distributeMessage, this, message);
+    // 只编码一次，各个IO线程共用
+    EventLoop::Functor f = std::bind(&ChatServer::distributeMessage, this,
+                                     codec_.encode(message));
     LOG_DEBUG;
 
     MutexLockGuard lock(mutex_);
@@ -61,11 +62,11 @@ private:
 
   typedef std::set<TcpConnectionPtr> ConnectionList;
 
-  void distributeMessage(const string &message) {
+  void distributeMessage(const SharedPayload &frame) {
     LOG_DEBUG << "begin";
     for (ConnectionList::iterator it = LocalConnections::instance().begin();
          it != LocalConnections::instance().end(); ++it) {
-      codec_.send(get_pointer(*it), message);
+      (*it)->send(frame);
     }
     LOG_DEBUG << "end";
   }
@@ -23,6 +23,10 @@ void EchoServer::onConnection(const muduo::net::TcpConnectionPtr &conn) {
   LOG_INFO << "EchoServer - " << conn->peerAddress().toIpPort() << " -> "
            << conn->localAddress().toIpPort() << " is "
            << (conn->connected() ? "UP" : "DOWN");
+  // 对端只发不收时，待回显的数据到1MiB就不再读
+  if (conn->connected()) {
+    conn->setReadBackpressure(1024 * 1024, 256 * 1024);
+  }
 }
 
 void EchoServer::onMessage(const muduo::net::TcpConnectionPtr &conn,
@@ -10,26 +10,69 @@
 
 #include "EventLoop.h"
 #include "InetAddress.h"
+#include "Logging.h"
 #include "SocketsOps.h"
 
 #include <boost/bind.hpp>
 
 #include <errno.h>
 #include <fcntl.h>
-//#include <sys/types.h>
-//#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+namespace {
+
+// 上次运行残留的套接字文件：是套接字，但没有人在监听。
+// 普通文件、目录或者正在服务的套接字都不动，留给bind报错
+void removeStaleUnixSocket(const struct sockaddr_un &addr) {
+  struct stat st;
+  if (::lstat(addr.sun_path, &st) < 0 || !S_ISSOCK(st.st_mode)) {
+    return;
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return;
+  }
+  if (::connect(fd, reinterpret_cast<const struct sockaddr *>(&addr),
+                sizeof addr) < 0 &&
+      errno == ECONNREFUSED) {
+    LOG_WARN << "Acceptor - removing stale socket " << addr.sun_path;
+    ::unlink(addr.sun_path);
+  }
+  ::close(fd);
+}
+
+} // namespace
+
 Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenAddr)
-    : loop_(loop), acceptSocket_(sockets::createNonblockingOrDie()),
+    : loop_(loop),
+      acceptSocket_(sockets::createNonblockingOrDie(listenAddr.family())),
       // Channel对象都是通过EventLoop对象注册的
       acceptChannel_(loop, acceptSocket_.fd()), listenning_(false),
-      idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)) {
+      paused_(false), idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)),
+      unixDev_(0), unixIno_(0) {
   assert(idleFd_ >= 0);
   acceptSocket_.setReuseAddr(true); // 设置了监听套接字地址复用
+  if (listenAddr.isUnixDomain()) {
+    // 抽象名字空间的地址随套接字关闭自动消失，不对应文件
+    const struct sockaddr_un *addr =
+        reinterpret_cast<const struct sockaddr_un *>(listenAddr.getSockAddr());
+    if (addr->sun_path[0] != '\0') {
+      unixPath_ = addr->sun_path;
+      removeStaleUnixSocket(*addr);
+    }
+  }
   acceptSocket_.bindAddress(listenAddr);
+  struct stat st;
+  if (!unixPath_.empty() && ::lstat(unixPath_.c_str(), &st) == 0) {
+    unixDev_ = st.st_dev;
+    unixIno_ = st.st_ino;
+  }
   acceptChannel_.setReadCallback(boost::bind(&Acceptor::handleRead, this));
 }
 
@@ -38,13 +81,42 @@ Acceptor::~Acceptor() {
   acceptChannel_.disableAll();
   acceptChannel_.remove();
   ::close(idleFd_);
+  // 路径可能已经被别的进程换成了它自己的套接字
+  struct stat st;
+  if (!unixPath_.empty() && ::lstat(unixPath_.c_str(), &st) == 0 &&
+      S_ISSOCK(st.st_mode) && st.st_dev == unixDev_ &&
+      st.st_ino == unixIno_) {
+    ::unlink(unixPath_.c_str());
+  }
 }
 
 void Acceptor::listen() {
   loop_->assertInLoopThread();
   listenning_ = true;
   acceptSocket_.listen();
-  acceptChannel_.enableReading();
+  if (!paused_) {
+    acceptChannel_.enableReading();
+  }
+}
+
+void Acceptor::pause() {
+  loop_->assertInLoopThread();
+  if (!paused_) {
+    paused_ = true;
+    if (acceptChannel_.isReading()) {
+      acceptChannel_.disableReading();
+    }
+  }
+}
+
+void Acceptor::resume() {
+  loop_->assertInLoopThread();
+  if (paused_) {
+    paused_ = false;
+    if (listenning_) {
+      acceptChannel_.enableReading();
+    }
+  }
 }
 
 //调用accept(2)来接受新连接，并回调用户callback
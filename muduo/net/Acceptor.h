@@ -14,8 +14,11 @@
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 
+#include <sys/types.h>
+
 #include "Channel.h"
 #include "Socket.h"
+#include "Types.h"
 
 namespace muduo {
 namespace net {
@@ -26,6 +29,10 @@ class InetAddress;
 ///
 /// Acceptor of incoming TCP connections.
 ///
+/// 也可以监听Unix域地址。文件系统路径上已有的文件只有是没人监听的
+/// 套接字（connect被拒绝）时才在bind前删除，其他情况bind失败；
+/// 析构时只删除自己bind的那个文件（inode没变）。
+///
 class Acceptor : boost::noncopyable {
 public:
   typedef boost::function<void(int sockfd, const InetAddress &)>
@@ -41,6 +48,11 @@ public:
   bool listenning() const { return listenning_; }
   void listen();
 
+  /// 在loop线程中调用。暂停时不再accept，新连接留在内核的backlog里
+  void pause();
+  void resume();
+  bool paused() const { return paused_; }
+
 private:
   void handleRead();
 
@@ -49,7 +61,11 @@ private:
   Channel acceptChannel_; // 用于观察acceptSocket_的readable事件，并回调Accptor::handleRead()
   NewConnectionCallback newConnectionCallback_;
   bool listenning_;
+  bool paused_;
   int idleFd_;  // 一个空闲的文件描述符，用来处理 Too many open files 的情况
+  string unixPath_; // 要删除的Unix域套接字文件，空表示没有
+  dev_t unixDev_;   // bind之后unixPath_的设备号和inode
+  ino_t unixIno_;
 };
 
 } // namespace net
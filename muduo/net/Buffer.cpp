@@ -17,8 +17,6 @@
 using namespace muduo;
 using namespace muduo::net;
 
-const char Buffer::kCRLF[] = "\r\n";
-
 const size_t Buffer::kCheapPrepend;
 const size_t Buffer::kInitialSize;
 
@@ -11,6 +11,7 @@
 #ifndef MUDUO_NET_BUFFER_H
 #define MUDUO_NET_BUFFER_H
 
+#include "CharSearch.h"
 #include "StringPiece.h"
 #include "Types.h"
 #include "copyable.h"
@@ -67,15 +68,54 @@ public:
   const char *peek() const { return begin() + readerIndex_; }
 
   const char *findCRLF() const {
-    const char *crlf = std::search(peek(), beginWrite(), kCRLF, kCRLF + 2);
-    return crlf == beginWrite() ? NULL : crlf;
+    return muduo::detail::findCRLF(peek(), beginWrite());
   }
 
   const char *findCRLF(const char *start) const {
     assert(peek() <= start);
     assert(start <= beginWrite());
-    const char *crlf = std::search(start, beginWrite(), kCRLF, kCRLF + 2);
-    return crlf == beginWrite() ? NULL : crlf;
+    return muduo::detail::findCRLF(start, beginWrite());
+  }
+
+  /// 可以接着上次继续的查找，行协议每次onMessage不必从头扫描。
+  /// *scanned是从peek()算起已经扫描过的字节数，第一次以及每次
+  /// retrieve()之后由调用者置0；没有找到时更新为readableBytes()。
+  const char *findCRLF(size_t *scanned) const {
+    assert(*scanned <= readableBytes());
+    // 上次末尾的'\r'可能和新数据里的'\n'组成CRLF
+    size_t from = *scanned > 0 ? *scanned - 1 : 0;
+    const char *crlf = muduo::detail::findCRLF(peek() + from, beginWrite());
+    *scanned = crlf ? crlf - peek() : readableBytes();
+    return crlf;
+  }
+
+  const char *findEOL() const {
+    return muduo::detail::findByte(peek(), beginWrite(), '\n');
+  }
+
+  const char *findEOL(const char *start) const {
+    assert(peek() <= start);
+    assert(start <= beginWrite());
+    return muduo::detail::findByte(start, beginWrite(), '\n');
+  }
+
+  // 同findCRLF(size_t*)
+  const char *findEOL(size_t *scanned) const {
+    assert(*scanned <= readableBytes());
+    const char *eol =
+        muduo::detail::findByte(peek() + *scanned, beginWrite(), '\n');
+    *scanned = eol ? eol - peek() : readableBytes();
+    return eol;
+  }
+
+  const char *findByte(char c) const {
+    return muduo::detail::findByte(peek(), beginWrite(), c);
+  }
+
+  // chars中任意一个字节第一次出现的位置
+  const char *findAnyOf(const StringPiece &chars) const {
+    return muduo::detail::findAnyOf(peek(), beginWrite(), chars.data(),
+                                    chars.size());
   }
 
   // retrieve returns void, to prevent
@@ -275,7 +315,6 @@ private:
   size_t readerIndex_;       // 读位置
   size_t writerIndex_;       // 写位置
 
-  static const char kCRLF[]; // "\r\n"
 };
 
 } // namespace net
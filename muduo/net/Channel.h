@@ -75,6 +75,7 @@ public:
     update();
   }
   bool isWriting() const { return events_ & kWriteEvent; }
+  bool isReading() const { return events_ & kReadEvent; }
 
   // for Poller
   int index() { return index_; }
@@ -13,19 +13,61 @@
 #include "EventLoop.h"
 #include "Logging.h"
 #include "SocketsOps.h"
+#include "ThreadLocal.h"
 
 #include <boost/bind.hpp>
 
+#include <atomic>
+#include <deque>
 #include <errno.h>
+#include <stdlib.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
 const int Connector::kMaxRetryDelayMs;
+const int Connector::kInitRetryDelayMs;
+
+namespace {
+
+std::atomic<int> g_maxConnectingPerLoop(64);
+
+// 每个IO线程（也就是每个EventLoop）一份，只在该线程中访问
+struct ConnectThrottle {
+  ConnectThrottle() : connecting(0) {}
+
+  int connecting;
+  std::deque<boost::weak_ptr<Connector> > waiting;
+};
+
+ThreadLocal<ConnectThrottle> t_throttle;
+
+__thread unsigned t_jitterSeed = 0;
+
+// [lo, hi]中的随机数
+int randomBetween(int lo, int hi) {
+  if (t_jitterSeed == 0) {
+    t_jitterSeed =
+        static_cast<unsigned>(CurrentThread::tid()) ^
+        static_cast<unsigned>(Timestamp::now().microSecondsSinceEpoch());
+  }
+  return lo + static_cast<int>(rand_r(&t_jitterSeed) % (hi - lo + 1));
+}
+
+} // namespace
+
+void Connector::setMaxConnectingPerLoop(int n) {
+  g_maxConnectingPerLoop.store(n, std::memory_order_relaxed);
+}
+
+int Connector::maxConnectingPerLoop() {
+  return g_maxConnectingPerLoop.load(std::memory_order_relaxed);
+}
 
 Connector::Connector(EventLoop *loop, const InetAddress &serverAddr)
     : loop_(loop), serverAddr_(serverAddr), connect_(false),
-      state_(kDisconnected), retryDelayMs_(kInitRetryDelayMs) {
+      state_(kDisconnected), retryDelayMs_(kInitRetryDelayMs),
+      holdingSlot_(false), queued_(false) {
   LOG_DEBUG << "ctor[" << this << "]";
 }
 
@@ -43,10 +85,59 @@ void Connector::start() {
 void Connector::startInLoop() {
   loop_->assertInLoopThread();
   assert(state_ == kDisconnected);
-  if (connect_) {
-    connect();
-  } else {
+  if (!connect_) {
     LOG_DEBUG << "do not connect";
+    return;
+  }
+  if (queued_) {
+    return;
+  }
+
+  ConnectThrottle &throttle = t_throttle.value();
+  int max = maxConnectingPerLoop();
+  if (max > 0 && throttle.connecting >= max) {
+    queued_ = true;
+    throttle.waiting.push_back(shared_from_this());
+    loop_->recordConnectQueued();
+    return;
+  }
+  ++throttle.connecting;
+  holdingSlot_ = true;
+  connect();
+}
+
+// 名额由passSlot()直接转交过来
+void Connector::startQueued(EventLoop *loop,
+                            const boost::weak_ptr<Connector> &weak) {
+  boost::shared_ptr<Connector> connector(weak.lock());
+  if (connector) {
+    connector->queued_ = false;
+  }
+  if (connector && connector->connect_ &&
+      connector->state_ == kDisconnected) {
+    connector->holdingSlot_ = true;
+    connector->connect();
+  } else {
+    passSlot(loop);
+  }
+}
+
+// 有排队的就把名额交给排得最久的，否则释放
+void Connector::passSlot(EventLoop *loop) {
+  ConnectThrottle &throttle = t_throttle.value();
+  if (throttle.waiting.empty()) {
+    --throttle.connecting;
+  } else {
+    boost::weak_ptr<Connector> next(throttle.waiting.front());
+    throttle.waiting.pop_front();
+    loop->queueInLoop(boost::bind(&Connector::startQueued, loop, next));
+  }
+}
+
+void Connector::releaseSlot() {
+  if (holdingSlot_) {
+    holdingSlot_ = false;
+    passSlot(loop_);
   }
 }
 
@@ -67,8 +158,11 @@ void Connector::stopInLoop() {
 }
 
 void Connector::connect() {
-  int sockfd = sockets::createNonblockingOrDie(); // 创建非阻塞套接字
-  int ret = sockets::connect(sockfd, serverAddr_.getSockAddrInet());
+  connectStart_ = Timestamp::now();
+  // 创建非阻塞套接字
+  int sockfd = sockets::createNonblockingOrDie(serverAddr_.family());
+  int ret = sockets::connect(sockfd, serverAddr_.getSockAddr(),
+                             serverAddr_.sockAddrLen());
   int savedErrno = (ret == 0) ? 0 : errno;
   switch (savedErrno) {
   case 0:
@@ -83,6 +177,7 @@ void Connector::connect() {
   case EADDRNOTAVAIL:
   case ECONNREFUSED:
   case ENETUNREACH:
+  case ENOENT: // Unix域套接字文件还没有创建
     retry(sockfd); // 重连
     break;
 
@@ -95,11 +190,13 @@ void Connector::connect() {
   case ENOTSOCK:
     LOG_SYSERR << "connect error in Connector::startInLoop " << savedErrno;
     sockets::close(sockfd); // 不能重连，关闭sockfd
+    releaseSlot();
     break;
 
   default:
     LOG_SYSERR << "Unexpected error in Connector::startInLoop " << savedErrno;
     sockets::close(sockfd);
+    releaseSlot();
     // connectErrorCallback_();
     break;
   }
@@ -166,6 +263,9 @@ void Connector::handleWrite() {
     } else           // 连接成功
     {
       setState(kConnected);
+      releaseSlot();
+      loop_->recordConnect(
+          timeDifference(Timestamp::now(), connectStart_) * 1000 * 1000);
       if (connect_) {
         newConnectionCallback_(sockfd); // 回调
       } else {
@@ -188,18 +288,27 @@ void Connector::handleError() {
   retry(sockfd);
 }
 
-// 采用back-off策略重连，即重连时间逐渐延长，0.5s, 1s, 2s, ...直至30s
+// decorrelated jitter：在[初始间隔, 上一次 * 3]中随机，不超过30s
+int Connector::nextRetryDelayMs() {
+  int hi = static_cast<int>(
+      std::min<int64_t>(static_cast<int64_t>(retryDelayMs_) * 3,
+                        kMaxRetryDelayMs));
+  return randomBetween(kInitRetryDelayMs, std::max(hi, kInitRetryDelayMs));
+}
+
 void Connector::retry(int sockfd) {
   sockets::close(sockfd);
   setState(kDisconnected);
+  releaseSlot();
   if (connect_) {
+    retryDelayMs_ = nextRetryDelayMs();
+    loop_->recordConnectRetry();
     LOG_INFO << "Connector::retry - Retry connecting to "
              << serverAddr_.toIpPort() << " in " << retryDelayMs_
              << " milliseconds. ";
     // 注册一个定时操作，重连
     loop_->runAfter(retryDelayMs_ / 1000.0,
                     boost::bind(&Connector::startInLoop, shared_from_this()));
-    retryDelayMs_ = std::min(retryDelayMs_ * 2, kMaxRetryDelayMs);
   } else {
     LOG_DEBUG << "do not connect";
   }
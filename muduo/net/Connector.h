@@ -12,11 +12,13 @@
 #define MUDUO_NET_CONNECTOR_H
 
 #include "InetAddress.h"
+#include "Timestamp.h"
 
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/weak_ptr.hpp>
 
 namespace muduo {
 namespace net {
@@ -24,7 +26,14 @@ namespace net {
 class Channel;
 class EventLoop;
 
-// 主动发起连接，带有自动重连功能
+///
+/// 主动发起连接，带有自动重连功能。
+///
+/// 重连间隔采用decorrelated jitter：下一次在[0.5s, 上一次 * 3]中随机，
+/// 最长30秒，大量客户端同时断开后不会成批地同时重连。
+/// 每个EventLoop上同时进行中的connect()不超过maxConnectingPerLoop()个，
+/// 超出的按顺序排队，避免服务端accept队列溢出后全体等待SYN重传。
+///
 class Connector : boost::noncopyable,
                   public boost::enable_shared_from_this<Connector> {
 public:
@@ -43,6 +52,11 @@ public:
 
   const InetAddress &serverAddress() const { return serverAddr_; }
 
+  /// 每个EventLoop上同时进行中的连接数上限，0表示不限，默认64。
+  /// 对之后发起的连接生效
+  static void setMaxConnectingPerLoop(int n);
+  static int maxConnectingPerLoop();
+
 private:
   enum States { kDisconnected, kConnecting, kConnected };
   static const int kMaxRetryDelayMs = 30 * 1000; // 30秒，最大重连延迟时间
@@ -52,11 +66,16 @@ private:
   void setState(States s) { state_ = s; }
   void startInLoop();
   void stopInLoop();
+  static void startQueued(EventLoop *loop,
+                          const boost::weak_ptr<Connector> &weak);
+  static void passSlot(EventLoop *loop);
   void connect();
   void connecting(int sockfd);
   void handleWrite();
   void handleError();
   void retry(int sockfd);
+  void releaseSlot();
+  int nextRetryDelayMs();
   int removeAndResetChannel();
   void resetChannel();
 
@@ -67,6 +86,9 @@ private:
   boost::scoped_ptr<Channel> channel_;          // Connector所对应的Channel
   NewConnectionCallback newConnectionCallback_; // 连接成功回调函数，
   int retryDelayMs_; // 重连延迟时间（单位：毫秒）
+  bool holdingSlot_;  // 占用了所在loop的一个并发连接名额
+  bool queued_;       // 正在排队等待名额
+  Timestamp connectStart_;
 };
 
 } // namespace net
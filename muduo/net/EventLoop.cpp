@@ -17,6 +17,8 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <sys/eventfd.h>
 
 using namespace muduo;
@@ -39,6 +41,52 @@ int createEventfd() {
 }
 } // namespace
 
+// 除pendingFunctors/maxPendingFunctors（在mutex_保护下写）外，
+// 只有loop所在线程写，用relaxed load + store累加，不需要原子RMW；
+// 其他线程随时可以relaxed load读取
+struct EventLoop::Counters {
+  typedef std::atomic<int64_t> Counter;
+
+  Counters()
+      : iterations(0), events(0), maxEventsPerPoll(0), wakeups(0),
+        functorsRun(0), pendingFunctors(0), maxPendingFunctors(0),
+        pollMicros(0), handlingMicros(0), timerMicros(0), functorMicros(0),
+        connects(0), connectRetries(0), connectsQueued(0), connectMicros(0),
+        maxConnectMicros(0) {}
+
+  static void add(Counter *c, int64_t x) {
+    c->store(c->load(std::memory_order_relaxed) + x,
+             std::memory_order_relaxed);
+  }
+
+  static void setMax(Counter *c, int64_t x) {
+    if (x > c->load(std::memory_order_relaxed)) {
+      c->store(x, std::memory_order_relaxed);
+    }
+  }
+
+  static int64_t get(const Counter &c) {
+    return c.load(std::memory_order_relaxed);
+  }
+
+  Counter iterations;
+  Counter events;
+  Counter maxEventsPerPoll;
+  Counter wakeups;
+  Counter functorsRun;
+  Counter pendingFunctors;
+  Counter maxPendingFunctors;
+  Counter pollMicros;
+  Counter handlingMicros; // 处理全部活动Channel的时间，含定时器
+  Counter timerMicros;
+  Counter functorMicros;
+  Counter connects;
+  Counter connectRetries;
+  Counter connectsQueued;
+  Counter connectMicros;
+  Counter maxConnectMicros;
+};
+
 EventLoop *EventLoop::getEventLoopOfCurrentThread() {
   return t_loopInThisThread;
 }
@@ -49,7 +97,8 @@ EventLoop::EventLoop()
       poller_(Poller::newDefaultPoller(this)),
       timerQueue_(new TimerQueue(this)), wakeupFd_(createEventfd()),
       wakeupChannel_(new Channel(this, wakeupFd_)),
-      currentActiveChannel_(NULL) {
+      currentActiveChannel_(NULL), mutex_("EventLoop::mutex_"),
+      counters_(new Counters) {
   LOG_TRACE << "EventLoop created " << this << " in thread " << threadId_;
   // 如果当前线程已经创建了EventLoop对象，终止(LOG_FATAL)
   if (t_loopInThisThread) {
@@ -84,11 +133,11 @@ void EventLoop::loop() {
   LOG_TRACE << "EventLoop " << this << " start looping";
 
   //::poll(NULL, 0, 5*1000);
+  Timestamp iterationEnd(Timestamp::now());
   while (!quit_) {
     activeChannels_.clear();
     //执行完Poller::poll()的时间
     pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
-    //++iteration_;
     if (Logger::logLevel() <= Logger::TRACE) {
       printActiveChannels();
     }
@@ -101,9 +150,27 @@ void EventLoop::loop() {
     }
     currentActiveChannel_ = NULL;
     eventHandling_ = false; //标识事件已处理完成
+    Timestamp handled(Timestamp::now());
 
     // 让IO线程也能执行一些计算任务，IO不忙的时候，处于阻塞状态
     doPendingFunctors(); // 执行其他线程或者本线程添加的一些回调任务
+    Timestamp finished(Timestamp::now());
+
+    // 每次循环只多读两次时钟，poll的起点就是上一次循环的终点
+    int64_t numEvents = static_cast<int64_t>(activeChannels_.size());
+    Counters::add(&counters_->iterations, 1);
+    Counters::add(&counters_->events, numEvents);
+    Counters::setMax(&counters_->maxEventsPerPoll, numEvents);
+    Counters::add(&counters_->pollMicros,
+                  pollReturnTime_.microSecondsSinceEpoch() -
+                      iterationEnd.microSecondsSinceEpoch());
+    Counters::add(&counters_->handlingMicros,
+                  handled.microSecondsSinceEpoch() -
+                      pollReturnTime_.microSecondsSinceEpoch());
+    Counters::add(&counters_->functorMicros,
+                  finished.microSecondsSinceEpoch() -
+                      handled.microSecondsSinceEpoch());
+    iterationEnd = finished;
   }
 
   LOG_TRACE << "EventLoop " << this << " stop looping";
@@ -133,6 +200,9 @@ void EventLoop::queueInLoop(const Functor &cb) {
   {
     MutexLockGuard lock(mutex_);
     pendingFunctors_.push_back(cb);
+    int64_t depth = static_cast<int64_t>(pendingFunctors_.size());
+    counters_->pendingFunctors.store(depth, std::memory_order_relaxed);
+    Counters::setMax(&counters_->maxPendingFunctors, depth);
   }
 
   /**
@@ -163,6 +233,48 @@ TimerId EventLoop::runEvery(double interval, const TimerCallback &cb) {
 
 void EventLoop::cancel(TimerId timerId) { return timerQueue_->cancel(timerId); }
 
+EventLoopMetrics EventLoop::metrics() const {
+  const Counters &c = *counters_;
+  EventLoopMetrics m;
+  m.iterations = Counters::get(c.iterations);
+  m.events = Counters::get(c.events);
+  m.maxEventsPerPoll = Counters::get(c.maxEventsPerPoll);
+  m.wakeups = Counters::get(c.wakeups);
+  m.functorsRun = Counters::get(c.functorsRun);
+  m.pendingFunctors = Counters::get(c.pendingFunctors);
+  m.maxPendingFunctors = Counters::get(c.maxPendingFunctors);
+  m.pollMicros = Counters::get(c.pollMicros);
+  m.timerMicros = Counters::get(c.timerMicros);
+  // 两个计数器分开读，相减可能短暂为负
+  m.eventMicros =
+      std::max<int64_t>(Counters::get(c.handlingMicros) - m.timerMicros, 0);
+  m.functorMicros = Counters::get(c.functorMicros);
+  m.connects = Counters::get(c.connects);
+  m.connectRetries = Counters::get(c.connectRetries);
+  m.connectsQueued = Counters::get(c.connectsQueued);
+  m.connectMicros = Counters::get(c.connectMicros);
+  m.maxConnectMicros = Counters::get(c.maxConnectMicros);
+  return m;
+}
+
+void EventLoop::recordTimerTime(int64_t micros) {
+  Counters::add(&counters_->timerMicros, micros);
+}
+
+void EventLoop::recordConnect(int64_t micros) {
+  Counters::add(&counters_->connects, 1);
+  Counters::add(&counters_->connectMicros, micros);
+  Counters::setMax(&counters_->maxConnectMicros, micros);
+}
+
+void EventLoop::recordConnectRetry() {
+  Counters::add(&counters_->connectRetries, 1);
+}
+
+void EventLoop::recordConnectQueued() {
+  Counters::add(&counters_->connectsQueued, 1);
+}
+
 void EventLoop::updateChannel(Channel *channel) {
   assert(channel->ownerLoop() == this);
   assertInLoopThread();
@@ -203,6 +315,9 @@ void EventLoop::handleRead() {
   ssize_t n = ::read(wakeupFd_, &one, sizeof one);
   if (n != sizeof one) {
     LOG_ERROR << "EventLoop::handleRead() reads " << n << " bytes instead of 8";
+  } else {
+    // eventfd的值是上次读取以来wakeup()的次数之和
+    Counters::add(&counters_->wakeups, static_cast<int64_t>(one));
   }
 }
 
@@ -215,11 +330,13 @@ void EventLoop::doPendingFunctors() {
     MutexLockGuard lock(mutex_);
     //可以减小临界区的长度(意味着不会阻塞其它线程的queueInLoop())，另一方面，也避免了死锁(因为Functor可能再次调用queueInLoop())
     functors.swap(pendingFunctors_);
+    counters_->pendingFunctors.store(0, std::memory_order_relaxed);
   }
 
   for (size_t i = 0; i < functors.size(); ++i) {
     functors[i]();
   }
+  Counters::add(&counters_->functorsRun, static_cast<int64_t>(functors.size()));
   callingPendingFunctors_ = false;
 }
 
@@ -22,6 +22,7 @@
 #include "Timestamp.h"
 
 #include "Callbacks.h"
+#include "EventLoopMetrics.h"
 #include "TimerId.h"
 
 namespace muduo {
@@ -94,8 +95,18 @@ public:
   ///
   void cancel(TimerId timerId);
 
+  ///
+  /// Runtime statistics of this loop.
+  /// Counters are written only by the loop thread, safe to call from other threads.
+  ///
+  EventLoopMetrics metrics() const;
+
   // internal usage
   void wakeup();
+  void recordTimerTime(int64_t micros); // TimerQueue::handleRead()耗费的时间
+  void recordConnect(int64_t micros);   // Connector建立一个连接耗费的时间
+  void recordConnectRetry();
+  void recordConnectQueued();
   void updateChannel(Channel *channel); // 在Poller中添加或者更新通道
   void removeChannel(Channel *channel); // 从Poller中移除通道
 
@@ -118,6 +129,8 @@ private:
 
   void printActiveChannels() const; // DEBUG
 
+  struct Counters;
+
   typedef std::vector<Channel *> ChannelList;
 
   //说明：在linux中对bool类型的操作都是原子性的
@@ -137,6 +150,7 @@ private:
   Channel *currentActiveChannel_; // 当前正在处理的活动通道
   MutexLock mutex_;
   std::vector<Functor> pendingFunctors_; // @BuardedBy mutex_   即将发生的回调，即在IO线程中执行需要执行回调函数集合
+  boost::scoped_ptr<Counters> counters_; // 运行统计
 };
 
 } // namespace net
@@ -0,0 +1,88 @@
+#include "EventLoopMetrics.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+EventLoopMetrics::EventLoopMetrics()
+    : iterations(0), events(0), maxEventsPerPoll(0), wakeups(0),
+      functorsRun(0), pendingFunctors(0), maxPendingFunctors(0),
+      pollMicros(0), eventMicros(0), timerMicros(0), functorMicros(0),
+      connects(0), connectRetries(0), connectsQueued(0), connectMicros(0),
+      maxConnectMicros(0) {}
+
+double EventLoopMetrics::eventsPerPoll() const {
+  return iterations > 0 ? static_cast<double>(events) / iterations : 0.0;
+}
+
+double EventLoopMetrics::utilisation() const {
+  int64_t busy = eventMicros + timerMicros + functorMicros;
+  int64_t total = busy + pollMicros;
+  return total > 0 ? static_cast<double>(busy) / total : 0.0;
+}
+
+double EventLoopMetrics::avgConnectMicros() const {
+  return connects > 0 ? static_cast<double>(connectMicros) / connects : 0.0;
+}
+
+EventLoopMetrics EventLoopMetrics::since(const EventLoopMetrics &earlier) const {
+  EventLoopMetrics d(*this);
+  d.iterations -= earlier.iterations;
+  d.events -= earlier.events;
+  d.wakeups -= earlier.wakeups;
+  d.functorsRun -= earlier.functorsRun;
+  d.pollMicros -= earlier.pollMicros;
+  d.eventMicros -= earlier.eventMicros;
+  d.timerMicros -= earlier.timerMicros;
+  d.functorMicros -= earlier.functorMicros;
+  d.connects -= earlier.connects;
+  d.connectRetries -= earlier.connectRetries;
+  d.connectsQueued -= earlier.connectsQueued;
+  d.connectMicros -= earlier.connectMicros;
+  return d;
+}
+
+EventLoopMetrics &EventLoopMetrics::operator+=(const EventLoopMetrics &rhs) {
+  iterations += rhs.iterations;
+  events += rhs.events;
+  maxEventsPerPoll = std::max(maxEventsPerPoll, rhs.maxEventsPerPoll);
+  wakeups += rhs.wakeups;
+  functorsRun += rhs.functorsRun;
+  pendingFunctors += rhs.pendingFunctors;
+  maxPendingFunctors = std::max(maxPendingFunctors, rhs.maxPendingFunctors);
+  pollMicros += rhs.pollMicros;
+  eventMicros += rhs.eventMicros;
+  timerMicros += rhs.timerMicros;
+  functorMicros += rhs.functorMicros;
+  connects += rhs.connects;
+  connectRetries += rhs.connectRetries;
+  connectsQueued += rhs.connectsQueued;
+  connectMicros += rhs.connectMicros;
+  maxConnectMicros = std::max(maxConnectMicros, rhs.maxConnectMicros);
+  return *this;
+}
+
+string EventLoopMetrics::toString() const {
+  char buf[384];
+  snprintf(buf, sizeof buf,
+           "util %.1f%% iterations %lld events/poll %.2f (max %lld) "
+           "wakeups %lld functors %lld pending %lld (max %lld) "
+           "event %lldus timer %lldus functor %lldus poll %lldus "
+           "connects %lld (avg %.0fus max %lldus) retries %lld queued %lld",
+           utilisation() * 100, static_cast<long long>(iterations),
+           eventsPerPoll(), static_cast<long long>(maxEventsPerPoll),
+           static_cast<long long>(wakeups), static_cast<long long>(functorsRun),
+           static_cast<long long>(pendingFunctors),
+           static_cast<long long>(maxPendingFunctors),
+           static_cast<long long>(eventMicros),
+           static_cast<long long>(timerMicros),
+           static_cast<long long>(functorMicros),
+           static_cast<long long>(pollMicros),
+           static_cast<long long>(connects), avgConnectMicros(),
+           static_cast<long long>(maxConnectMicros),
+           static_cast<long long>(connectRetries),
+           static_cast<long long>(connectsQueued));
+  return buf;
+}
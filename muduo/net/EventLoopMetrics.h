@@ -0,0 +1,55 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_EVENTLOOPMETRICS_H
+#define MUDUO_NET_EVENTLOOPMETRICS_H
+
+#include "Types.h"
+
+#include <stdint.h>
+
+namespace muduo {
+namespace net {
+
+///
+/// EventLoop运行统计的快照，见EventLoop::metrics()。
+///
+/// 除pendingFunctors外都是自loop创建以来的累计值，
+/// 两次快照用since()相减得到这段时间内的值。时间单位为微秒。
+///
+struct EventLoopMetrics {
+  EventLoopMetrics();
+
+  int64_t iterations;       // loop()循环次数，即poll次数
+  int64_t events;           // poll返回的活动Channel总数
+  int64_t maxEventsPerPoll;
+  int64_t wakeups;          // wakeup()次数（从eventfd读到的计数）
+  int64_t functorsRun;      // 执行的pendingFunctors_个数
+  int64_t pendingFunctors;  // 当前排队的回调数
+  int64_t maxPendingFunctors;
+  int64_t pollMicros;       // 阻塞在poll中（空闲）的时间
+  int64_t eventMicros;      // Channel::handleEvent，不含定时器
+  int64_t timerMicros;      // 定时器回调
+  int64_t functorMicros;    // doPendingFunctors
+  int64_t connects;         // Connector成功建立的连接数
+  int64_t connectRetries;   // Connector失败后安排的重试次数
+  int64_t connectsQueued;   // 因为并发连接数上限而排队的次数
+  int64_t connectMicros;    // 成功的连接从connect()到可写的时间
+  int64_t maxConnectMicros;
+
+  double eventsPerPoll() const;
+  // 忙碌时间占比，1.0表示loop已经饱和
+  double utilisation() const;
+  double avgConnectMicros() const;
+
+  // 累计值相减，当前值（pendingFunctors和各个max）取本快照的
+  EventLoopMetrics since(const EventLoopMetrics &earlier) const;
+  // 汇总多个loop：累计值和当前值相加，max取最大
+  EventLoopMetrics &operator+=(const EventLoopMetrics &rhs);
+
+  string toString() const;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_EVENTLOOPMETRICS_H
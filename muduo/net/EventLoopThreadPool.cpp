@@ -59,3 +59,32 @@ EventLoop *EventLoopThreadPool::getNextLoop() {
 
   return loop;
 }
+
+std::vector<EventLoop *> EventLoopThreadPool::getAllLoops() const {
+  assert(started_);
+  if (loops_.empty()) {
+    return std::vector<EventLoop *>(1, baseLoop_);
+  }
+  return loops_;
+}
+
+std::vector<EventLoopMetrics> EventLoopThreadPool::metrics() const {
+  std::vector<EventLoopMetrics> result;
+  if (loops_.empty()) {
+    result.push_back(baseLoop_->metrics());
+  } else {
+    for (size_t i = 0; i < loops_.size(); ++i) {
+      result.push_back(loops_[i]->metrics());
+    }
+  }
+  return result;
+}
+
+EventLoopMetrics EventLoopThreadPool::aggregateMetrics() const {
+  std::vector<EventLoopMetrics> all = metrics();
+  EventLoopMetrics sum;
+  for (size_t i = 0; i < all.size(); ++i) {
+    sum += all[i];
+  }
+  return sum;
+}
@@ -12,6 +12,7 @@
 #define MUDUO_NET_EVENTLOOPTHREADPOOL_H
 
 #include "Condition.h"
+#include "EventLoopMetrics.h"
 #include "Mutex.h"
 
 #include <boost/function.hpp>
@@ -35,6 +36,13 @@ public:
   void setThreadNum(int numThreads) { numThreads_ = numThreads; }
   void start(const ThreadInitCallback &cb = ThreadInitCallback());
   EventLoop *getNextLoop();
+  // 所有IO线程的loop，没有IO线程时只有baseLoop_。start()之后不再改变
+  std::vector<EventLoop *> getAllLoops() const;
+
+  // 每个IO线程一项；没有IO线程时只有baseLoop_。可以在任何线程调用
+  std::vector<EventLoopMetrics> metrics() const;
+  // 所有loop汇总，max取各loop的最大值
+  EventLoopMetrics aggregateMetrics() const;
 
 private:
   EventLoop *baseLoop_; // 与Acceptor所属EventLoop相同
@@ -9,9 +9,12 @@
 #include "InetAddress.h"
 
 #include "Endian.h"
+#include "Logging.h"
 #include "SocketsOps.h"
 
 #include <netinet/in.h>
+#include <stddef.h> // offsetof
+#include <string.h>
 #include <strings.h> // bzero
 
 #include <boost/static_assert.hpp>
@@ -37,27 +40,91 @@ static const in_addr_t kInaddrAny = INADDR_ANY;
 using namespace muduo;
 using namespace muduo::net;
 
-BOOST_STATIC_ASSERT(sizeof(InetAddress) == sizeof(struct sockaddr_in));
+BOOST_STATIC_ASSERT(sizeof(InetAddress) <= sizeof(struct sockaddr_storage));
+BOOST_STATIC_ASSERT(offsetof(struct sockaddr_in, sin_family) ==
+                    offsetof(struct sockaddr_un, sun_family));
+
+namespace {
+
+const size_t kSunPathOffset = offsetof(struct sockaddr_un, sun_path);
+const size_t kSunPathSize = sizeof(struct sockaddr_un) - kSunPathOffset;
+
+} // namespace
 
 InetAddress::InetAddress(uint16_t port) {
-  bzero(&addr_, sizeof addr_);
+  bzero(&addrUn_, sizeof addrUn_);
   addr_.sin_family = AF_INET;
   addr_.sin_addr.s_addr = sockets::hostToNetwork32(kInaddrAny);
   addr_.sin_port = sockets::hostToNetwork16(port);
 }
 
 InetAddress::InetAddress(const StringPiece &ip, uint16_t port) {
-  bzero(&addr_, sizeof addr_);
+  bzero(&addrUn_, sizeof addrUn_);
   sockets::fromIpPort(ip.data(), port, &addr_);
 }
 
+InetAddress::InetAddress(const struct sockaddr_storage &addr) {
+  bzero(&addrUn_, sizeof addrUn_);
+  if (addr.ss_family == AF_UNIX) {
+    memcpy(&addrUn_, &addr, sizeof addrUn_);
+  } else {
+    memcpy(&addr_, &addr, sizeof addr_);
+  }
+}
+
+InetAddress InetAddress::unixDomain(const StringPiece &path) {
+  struct sockaddr_un addr;
+  bzero(&addr, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  // 不能截断：截断后是另一个地址，bind/connect/unlink都会作用在别的路径上
+  size_t len = static_cast<size_t>(path.size());
+  if (len > kSunPathSize - 1) {
+    LOG_FATAL << "InetAddress::unixDomain path too long " << path;
+  }
+  // 抽象名字空间：sun_path[0]为'\0'，后面是名字
+  memcpy(addr.sun_path, path.data(), len);
+  if (len > 0 && path[0] == '@') {
+    addr.sun_path[0] = '\0';
+  }
+  return InetAddress(addr);
+}
+
+void InetAddress::setSockAddrInet(const struct sockaddr_in &addr) {
+  bzero(&addrUn_, sizeof addrUn_);
+  addr_ = addr;
+}
+
+socklen_t InetAddress::sockAddrLen() const {
+  if (!isUnixDomain()) {
+    return static_cast<socklen_t>(sizeof addr_);
+  }
+  size_t len = addrUn_.sun_path[0] == '\0'
+                   ? 1 + strnlen(addrUn_.sun_path + 1, kSunPathSize - 1)
+                   : strnlen(addrUn_.sun_path, kSunPathSize);
+  return static_cast<socklen_t>(kSunPathOffset + len);
+}
+
 string InetAddress::toIpPort() const {
+  if (isUnixDomain()) {
+    return toIp();
+  }
   char buf[32];
   sockets::toIpPort(buf, sizeof buf, addr_);
   return buf;
 }
 
 string InetAddress::toIp() const {
+  if (isUnixDomain()) {
+    string s("unix:");
+    if (addrUn_.sun_path[0] != '\0') {
+      s.append(addrUn_.sun_path, strnlen(addrUn_.sun_path, kSunPathSize));
+    } else if (addrUn_.sun_path[1] != '\0') {
+      s.push_back('@');
+      s.append(addrUn_.sun_path + 1,
+               strnlen(addrUn_.sun_path + 1, kSunPathSize - 1));
+    }
+    return s; // 未绑定的一端（通常是客户端）只有"unix:"
+  }
   char buf[32];
   sockets::toIp(buf, sizeof buf, addr_);
   return buf;
@@ -15,14 +15,18 @@
 #include "copyable.h"
 
 #include <netinet/in.h>
+#include <sys/un.h>
 
 namespace muduo {
 namespace net {
 
 ///
-/// Wrapper of sockaddr_in.
+/// Wrapper of sockaddr_in or sockaddr_un.
 ///
 /// This is an POD interface class.
+///
+/// Unix域地址用unixDomain()构造，以'@'开头的名字是Linux的抽象名字空间，
+/// 不在文件系统中创建文件。TcpServer/TcpClient对两种地址的用法完全相同。
 class InetAddress : public muduo::copyable {
 public:
   /// Constructs an endpoint with given port number.
@@ -36,8 +40,22 @@ public:
 
   /// Constructs an endpoint with given struct @c sockaddr_in
   /// Mostly used when accepting new connections
-  InetAddress(const struct sockaddr_in &addr) : addr_(addr) {}
+  InetAddress(const struct sockaddr_in &addr) { setSockAddrInet(addr); }
+
+  /// Constructs an endpoint with given struct @c sockaddr_un
+  InetAddress(const struct sockaddr_un &addr) { setSockAddrUnix(addr); }
+
+  /// Constructs an endpoint from getsockname()/getpeername() result
+  InetAddress(const struct sockaddr_storage &addr);
 
+  /// Constructs an AF_UNIX endpoint, "@name" for the abstract namespace.
+  /// 路径超过sun_path的长度时终止(LOG_FATAL)
+  static InetAddress unixDomain(const StringPiece &path);
+
+  sa_family_t family() const { return addr_.sin_family; }
+  bool isUnixDomain() const { return family() == AF_UNIX; }
+
+  // Unix域地址返回"unix:/path"或"unix:@name"
   string toIp() const;
   string toIpPort() const;
 
@@ -47,14 +65,25 @@ public:
 
   // default copy/assignment are Okay
 
+  const struct sockaddr *getSockAddr() const {
+    return reinterpret_cast<const struct sockaddr *>(&addrUn_);
+  }
+  // 传给bind()/connect()的长度，抽象名字空间的地址必须精确
+  socklen_t sockAddrLen() const;
+
   const struct sockaddr_in &getSockAddrInet() const { return addr_; }
-  void setSockAddrInet(const struct sockaddr_in &addr) { addr_ = addr; }
+  void setSockAddrInet(const struct sockaddr_in &addr);
+  void setSockAddrUnix(const struct sockaddr_un &addr) { addrUn_ = addr; }
 
+  // 以下两个只对AF_INET有意义
   uint32_t ipNetEndian() const { return addr_.sin_addr.s_addr; }
   uint16_t portNetEndian() const { return addr_.sin_port; }
 
 private:
-  struct sockaddr_in addr_;
+  union {
+    struct sockaddr_in addr_;
+    struct sockaddr_un addrUn_;
+  };
 };
 
 } // namespace net
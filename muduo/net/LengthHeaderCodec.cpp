@@ -0,0 +1,142 @@
+#include "LengthHeaderCodec.h"
+
+#include "Buffer.h"
+#include "Endian.h"
+#include "EventLoop.h"
+#include "Logging.h"
+#include "TcpConnection.h"
+
+#include <limits.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t LengthHeaderCodec::kDefaultMaxMessageSize;
+
+namespace {
+
+// 头部能表示的最大长度，StringPiece的长度是int
+size_t maxLengthOf(int headerLen) {
+  switch (headerLen) {
+  case 1:
+    return UINT8_MAX;
+  case 2:
+    return UINT16_MAX;
+  default:
+    return INT_MAX;
+  }
+}
+
+} // namespace
+
+LengthHeaderCodec::LengthHeaderCodec(const StringPieceMessageCallback &cb,
+                                     int headerLen, size_t maxMessageSize)
+    : messageCallback_(cb), headerLen_(headerLen),
+      maxMessageSize_(std::min(maxMessageSize, maxLengthOf(headerLen))) {
+  assert(headerLen == 1 || headerLen == 2 || headerLen == 4);
+  assert(static_cast<size_t>(headerLen) <= Buffer::kCheapPrepend);
+}
+
+void LengthHeaderCodec::onMessage(const TcpConnectionPtr &conn, Buffer *buf,
+                                  Timestamp receiveTime) {
+  const char *begin = buf->peek();
+  const char *end = begin + buf->readableBytes();
+  const char *p = begin;
+  while (static_cast<size_t>(end - p) >= static_cast<size_t>(headerLen_)) {
+    size_t len = readHeader(p);
+    if (len > maxMessageSize_) {
+      LOG_ERROR << "LengthHeaderCodec: invalid length " << len;
+      buf->retrieveAll();
+      if (errorCallback_) {
+        errorCallback_(conn, len);
+      } else {
+        conn->shutdown(); // FIXME: disable reading
+      }
+      return;
+    }
+    if (static_cast<size_t>(end - p) - headerLen_ < len) {
+      break;
+    }
+    messageCallback_(conn, StringPiece(p + headerLen_, static_cast<int>(len)),
+                     receiveTime);
+    p += headerLen_ + len;
+  }
+  // 整批消息处理完只移动一次读位置
+  buf->retrieve(p - begin);
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr &conn,
+                             const StringPiece &message) const {
+  if (conn->getLoop()->isInLoopThread()) {
+    encode(conn->outputBuffer(), message);
+    conn->flushOutput();
+  } else {
+    Buffer buf;
+    buf.append(message);
+    send(conn, &buf);
+  }
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr &conn,
+                             Buffer *message) const {
+  size_t len = message->readableBytes();
+  assert(len <= maxMessageSize_);
+  assert(message->prependableBytes() >= static_cast<size_t>(headerLen_));
+  char header[sizeof(int32_t)];
+  writeHeader(header, len);
+  message->prepend(header, headerLen_);
+  conn->send(message);
+}
+
+void LengthHeaderCodec::encode(Buffer *output,
+                               const StringPiece &message) const {
+  size_t len = message.size();
+  assert(len <= maxMessageSize_);
+  char header[sizeof(int32_t)];
+  writeHeader(header, len);
+  output->ensureWritableBytes(headerLen_ + len);
+  output->append(header, headerLen_);
+  output->append(message);
+}
+
+SharedPayload LengthHeaderCodec::encodeShared(const StringPiece &message) const {
+  Buffer buf;
+  encode(&buf, message);
+  return SharedPayload(&buf);
+}
+
+// 头部可能不对齐，用memcpy读写
+size_t LengthHeaderCodec::readHeader(const char *p) const {
+  switch (headerLen_) {
+  case 1:
+    return static_cast<uint8_t>(*p);
+  case 2: {
+    uint16_t be16 = 0;
+    ::memcpy(&be16, p, sizeof be16);
+    return sockets::networkToHost16(be16);
+  }
+  default: {
+    uint32_t be32 = 0;
+    ::memcpy(&be32, p, sizeof be32);
+    return sockets::networkToHost32(be32);
+  }
+  }
+}
+
+void LengthHeaderCodec::writeHeader(char *p, size_t len) const {
+  switch (headerLen_) {
+  case 1:
+    *p = static_cast<char>(len);
+    break;
+  case 2: {
+    uint16_t be16 = sockets::hostToNetwork16(static_cast<uint16_t>(len));
+    ::memcpy(p, &be16, sizeof be16);
+    break;
+  }
+  default: {
+    uint32_t be32 = sockets::hostToNetwork32(static_cast<uint32_t>(len));
+    ::memcpy(p, &be32, sizeof be32);
+    break;
+  }
+  }
+}
@@ -0,0 +1,80 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_LENGTHHEADERCODEC_H
+#define MUDUO_NET_LENGTHHEADERCODEC_H
+
+#include "Callbacks.h"
+#include "SharedPayload.h"
+#include "StringPiece.h"
+#include "Timestamp.h"
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace muduo {
+namespace net {
+
+class Buffer;
+
+///
+/// 长度前缀的消息编解码：每条消息前是headerLen字节（1、2或4）
+/// 网络字节序的长度，不含头部本身。
+///
+/// 解码：一次onMessage()处理缓冲区里所有完整的消息，消息以指向输入
+/// 缓冲区的StringPiece交给回调，不复制；回调返回后才retrieve()，
+/// 所以StringPiece只在回调期间有效，回调中也不能再读这个Buffer。
+///
+/// 编码：在IO线程里直接追加到连接的输出缓冲区，不构造临时Buffer。
+/// 一个codec可以被多个连接（多个IO线程）共用。
+///
+class LengthHeaderCodec : boost::noncopyable {
+public:
+  typedef boost::function<void(const TcpConnectionPtr &,
+                               const StringPiece &message, Timestamp)>
+      StringPieceMessageCallback;
+  // 长度超过上限，默认打日志并shutdown()
+  typedef boost::function<void(const TcpConnectionPtr &, size_t length)>
+      ErrorCallback;
+
+  static const size_t kDefaultMaxMessageSize = 64 * 1024 * 1024;
+
+  explicit LengthHeaderCodec(const StringPieceMessageCallback &cb,
+                             int headerLen = 4,
+                             size_t maxMessageSize = kDefaultMaxMessageSize);
+
+  void setErrorCallback(const ErrorCallback &cb) { errorCallback_ = cb; }
+
+  int headerLen() const { return headerLen_; }
+  size_t maxMessageSize() const { return maxMessageSize_; }
+
+  void onMessage(const TcpConnectionPtr &conn, Buffer *buf,
+                 Timestamp receiveTime);
+
+  /// 在IO线程中直接编码进输出缓冲区并写出，
+  /// 其他线程中编码到临时Buffer再转交给IO线程。
+  void send(const TcpConnectionPtr &conn, const StringPiece &message) const;
+
+  /// message已经在一个Buffer里时，头部写进它的prepend区，消息本身不再复制。
+  void send(const TcpConnectionPtr &conn, Buffer *message) const;
+
+  /// 只编码不发送。在IO线程中可以把多条消息编码进conn->outputBuffer()，
+  /// 然后调用一次conn->flushOutput()。
+  void encode(Buffer *output, const StringPiece &message) const;
+
+  /// 编码成可以发给多个连接的SharedPayload，广播时只编码一次。
+  SharedPayload encodeShared(const StringPiece &message) const;
+
+private:
+  size_t readHeader(const char *p) const;
+  void writeHeader(char *p, size_t len) const;
+
+  StringPieceMessageCallback messageCallback_;
+  ErrorCallback errorCallback_;
+  const int headerLen_;
+  const size_t maxMessageSize_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_LENGTHHEADERCODEC_H
@@ -0,0 +1,54 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_SHAREDPAYLOAD_H
+#define MUDUO_NET_SHAREDPAYLOAD_H
+
+#include "Buffer.h"
+#include "StringPiece.h"
+#include "copyable.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace muduo {
+namespace net {
+
+///
+/// 编码好之后不再修改的一段数据，带引用计数。
+///
+/// 广播时先编码一次，再用TcpConnection::send(const SharedPayload&)
+/// 发给每个连接：没写完的部分只在连接的输出队列里保存一个引用，
+/// 不复制到各自的outputBuffer_，内存是O(1)条消息而不是O(接收者)。
+/// 复制SharedPayload只增加引用计数，可以跨线程传递。
+///
+class SharedPayload : public muduo::copyable {
+public:
+  SharedPayload() {}
+
+  /// 复制一次data
+  explicit SharedPayload(const StringPiece &data) : block_(new Buffer) {
+    block_->append(data.data(), data.size());
+  }
+
+  /// 取走buf中的数据，不复制，buf变为空
+  explicit SharedPayload(Buffer *buf) : block_(new Buffer) {
+    block_->swap(*buf);
+  }
+
+  const char *data() const { return block_ ? block_->peek() : NULL; }
+  size_t size() const { return block_ ? block_->readableBytes() : 0; }
+  bool empty() const { return size() == 0; }
+  StringPiece toStringPiece() const {
+    return StringPiece(data(), static_cast<int>(size()));
+  }
+
+  // 引用计数，测试用
+  long useCount() const { return block_.use_count(); }
+
+private:
+  boost::shared_ptr<Buffer> block_; // 构造之后只读
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_SHAREDPAYLOAD_H
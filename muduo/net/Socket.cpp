@@ -9,6 +9,7 @@
 #include "Socket.h"
 
 #include "InetAddress.h"
+#include "Logging.h"
 #include "SocketsOps.h"
 
 #include <netinet/in.h>
@@ -21,17 +22,17 @@ using namespace muduo::net;
 Socket::~Socket() { sockets::close(sockfd_); }
 
 void Socket::bindAddress(const InetAddress &addr) {
-  sockets::bindOrDie(sockfd_, addr.getSockAddrInet());
+  sockets::bindOrDie(sockfd_, addr.getSockAddr(), addr.sockAddrLen());
 }
 
 void Socket::listen() { sockets::listenOrDie(sockfd_); }
 
 int Socket::accept(InetAddress *peeraddr) {
-  struct sockaddr_in addr;
+  struct sockaddr_storage addr;
   bzero(&addr, sizeof addr);
   int connfd = sockets::accept(sockfd_, &addr);
   if (connfd >= 0) {
-    peeraddr->setSockAddrInet(addr);
+    *peeraddr = InetAddress(addr);
   }
   return connfd;
 }
@@ -50,6 +51,15 @@ void Socket::setReuseAddr(bool on) {
   // FIXME CHECK
 }
 
+void Socket::setReusePort(bool on) {
+  int optval = on ? 1 : 0;
+  int ret =
+      ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof optval);
+  if (ret < 0 && on) {
+    LOG_SYSERR << "SO_REUSEPORT failed.";
+  }
+}
+
 void Socket::setKeepAlive(bool on) {
   int optval = on ? 1 : 0;
   ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof optval);
@@ -71,6 +71,12 @@ public:
   ///
   void setReuseAddr(bool on);
 
+  ///
+  /// Enable/disable SO_REUSEPORT
+  ///
+  // 多个套接字绑定同一端口，由内核在它们之间分配数据报/连接
+  void setReusePort(bool on);
+
   ///
   /// Enable/disable SO_KEEPALIVE
   ///
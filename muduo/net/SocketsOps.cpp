@@ -27,13 +27,15 @@ namespace {
 
 typedef struct sockaddr SA; //通用地址
 
-// 网际地址转换通用地址
-const SA *sockaddr_cast(const struct sockaddr_in *addr) {
-  return static_cast<const SA *>(implicit_cast<const void *>(addr));
+// 能容纳任何地址族的地址转换通用地址
+SA *sockaddr_cast(struct sockaddr_storage *addr) {
+  return static_cast<SA *>(implicit_cast<void *>(addr));
 }
 
-SA *sockaddr_cast(struct sockaddr_in *addr) {
-  return static_cast<SA *>(implicit_cast<void *>(addr));
+const struct sockaddr_in *
+sockaddr_in_cast(const struct sockaddr_storage *addr) {
+  return static_cast<const struct sockaddr_in *>(
+      implicit_cast<const void *>(addr));
 }
 
 void setNonBlockAndCloseOnExec(int sockfd) {
@@ -54,18 +56,19 @@ void setNonBlockAndCloseOnExec(int sockfd) {
 
 } // namespace
 
-int sockets::createNonblockingOrDie() {
+int sockets::createNonblockingOrDie(sa_family_t family) {
+  int protocol = family == AF_UNIX ? 0 : IPPROTO_TCP;
   // socket
 #if VALGRIND // 内存泄露检测工具，还能够检测文件描述符的打开状态
-  int sockfd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  int sockfd = ::socket(family, SOCK_STREAM, protocol);
   if (sockfd < 0) {
     LOG_SYSFATAL << "sockets::createNonblockingOrDie";
   }
   setNonBlockAndCloseOnExec(sockfd);
 #else
   // Linux 2.6.27以上的内核支持SOCK_NONBLOCK与SOCK_CLOEXEC
-  int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
-                        IPPROTO_TCP);
+  int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        protocol);
   if (sockfd < 0) {
     LOG_SYSFATAL << "sockets::createNonblockingOrDie";
   }
@@ -74,8 +77,25 @@ int sockets::createNonblockingOrDie() {
   return sockfd;
 }
 
-void sockets::bindOrDie(int sockfd, const struct sockaddr_in &addr) {
-  int ret = ::bind(sockfd, sockaddr_cast(&addr), sizeof addr);
+int sockets::createUdpNonblockingOrDie(sa_family_t family) {
+#if VALGRIND
+  int sockfd = ::socket(family, SOCK_DGRAM, 0);
+  if (sockfd < 0) {
+    LOG_SYSFATAL << "sockets::createUdpNonblockingOrDie";
+  }
+  setNonBlockAndCloseOnExec(sockfd);
+#else
+  int sockfd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sockfd < 0) {
+    LOG_SYSFATAL << "sockets::createUdpNonblockingOrDie";
+  }
+#endif
+  return sockfd;
+}
+
+void sockets::bindOrDie(int sockfd, const struct sockaddr *addr,
+                        socklen_t addrlen) {
+  int ret = ::bind(sockfd, addr, addrlen);
   if (ret < 0) {
     LOG_SYSFATAL << "sockets::bindOrDie";
   }
@@ -88,7 +108,7 @@ void sockets::listenOrDie(int sockfd) {
   }
 }
 
-int sockets::accept(int sockfd, struct sockaddr_in *addr) {
+int sockets::accept(int sockfd, struct sockaddr_storage *addr) {
   socklen_t addrlen = sizeof *addr;
 
 #if VALGRIND
@@ -132,8 +152,9 @@ int sockets::accept(int sockfd, struct sockaddr_in *addr) {
   return connfd;
 }
 
-int sockets::connect(int sockfd, const struct sockaddr_in &addr) {
-  return ::connect(sockfd, sockaddr_cast(&addr), sizeof addr);
+int sockets::connect(int sockfd, const struct sockaddr *addr,
+                     socklen_t addrlen) {
+  return ::connect(sockfd, addr, addrlen);
 }
 
 ssize_t sockets::read(int sockfd, void *buf, size_t count) {
@@ -150,12 +171,25 @@ ssize_t sockets::write(int sockfd, const void *buf, size_t count) {
   return ::write(sockfd, buf, count);
 }
 
+ssize_t sockets::writev(int sockfd, const struct iovec *iov, int iovcnt) {
+  return ::writev(sockfd, iov, iovcnt);
+}
+
 void sockets::close(int sockfd) {
   if (::close(sockfd) < 0) {
     LOG_SYSERR << "sockets::close";
   }
 }
 
+void sockets::abortiveClose(int sockfd) {
+  struct linger lingerZero = {1, 0};
+  if (::setsockopt(sockfd, SOL_SOCKET, SO_LINGER, &lingerZero,
+                   static_cast<socklen_t>(sizeof lingerZero)) < 0) {
+    LOG_SYSERR << "sockets::abortiveClose";
+  }
+  close(sockfd);
+}
+
 // 只关闭写的这一半，进入半关闭状态(close SHUT_WR)
 void sockets::shutdownWrite(int sockfd) {
   if (::shutdown(sockfd, SHUT_WR) < 0) {
@@ -201,8 +235,8 @@ int sockets::getSocketError(int sockfd) {
 }
 
 // 本地地址
-struct sockaddr_in sockets::getLocalAddr(int sockfd) {
-  struct sockaddr_in localaddr;
+struct sockaddr_storage sockets::getLocalAddr(int sockfd) {
+  struct sockaddr_storage localaddr;
   bzero(&localaddr, sizeof localaddr);
   socklen_t addrlen = sizeof(localaddr);
   if (::getsockname(sockfd, sockaddr_cast(&localaddr), &addrlen) < 0) {
@@ -212,8 +246,8 @@ struct sockaddr_in sockets::getLocalAddr(int sockfd) {
 }
 
 // 对等端地址
-struct sockaddr_in sockets::getPeerAddr(int sockfd) {
-  struct sockaddr_in peeraddr;
+struct sockaddr_storage sockets::getPeerAddr(int sockfd) {
+  struct sockaddr_storage peeraddr;
   bzero(&peeraddr, sizeof peeraddr);
   socklen_t addrlen = sizeof(peeraddr);
   if (::getpeername(sockfd, sockaddr_cast(&peeraddr), &addrlen) < 0) {
@@ -229,9 +263,15 @@ struct sockaddr_in sockets::getPeerAddr(int sockfd) {
 // 服务器尚未开启，即服务器还没有在destPort端口上处于监听
 // 就有可能出现自连接，这样，服务器也无法启动了
 
+// Unix域套接字不会自连接
 bool sockets::isSelfConnect(int sockfd) {
-  struct sockaddr_in localaddr = getLocalAddr(sockfd);
-  struct sockaddr_in peeraddr = getPeerAddr(sockfd);
-  return localaddr.sin_port == peeraddr.sin_port &&
-         localaddr.sin_addr.s_addr == peeraddr.sin_addr.s_addr;
+  struct sockaddr_storage local = getLocalAddr(sockfd);
+  struct sockaddr_storage peer = getPeerAddr(sockfd);
+  if (local.ss_family != AF_INET || peer.ss_family != AF_INET) {
+    return false;
+  }
+  const struct sockaddr_in *localaddr = sockaddr_in_cast(&local);
+  const struct sockaddr_in *peeraddr = sockaddr_in_cast(&peer);
+  return localaddr->sin_port == peeraddr->sin_port &&
+         localaddr->sin_addr.s_addr == peeraddr->sin_addr.s_addr;
 }
@@ -14,6 +14,7 @@
 #define MUDUO_NET_SOCKETSOPS_H
 
 #include <arpa/inet.h>
+#include <sys/socket.h>
 
 namespace muduo {
 namespace net {
@@ -23,16 +24,22 @@ namespace sockets {
 /// Creates a non-blocking socket file descriptor,
 /// abort if any error.
 // 创建一个非阻塞套接字，如果创建失败就终止程序abort
-int createNonblockingOrDie();
+// family为AF_INET时是TCP，AF_UNIX时是Unix域字节流
+int createNonblockingOrDie(sa_family_t family = AF_INET);
+// 非阻塞的数据报套接字，AF_INET时是UDP
+int createUdpNonblockingOrDie(sa_family_t family = AF_INET);
 
-int connect(int sockfd, const struct sockaddr_in &addr);
-void bindOrDie(int sockfd, const struct sockaddr_in &addr);
+int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen);
+void bindOrDie(int sockfd, const struct sockaddr *addr, socklen_t addrlen);
 void listenOrDie(int sockfd);
-int accept(int sockfd, struct sockaddr_in *addr);
+int accept(int sockfd, struct sockaddr_storage *addr);
 ssize_t read(int sockfd, void *buf, size_t count);
 ssize_t readv(int sockfd, const struct iovec *iov, int iovcnt);
 ssize_t write(int sockfd, const void *buf, size_t count);
+ssize_t writev(int sockfd, const struct iovec *iov, int iovcnt);
 void close(int sockfd);
+// SO_LINGER为0再close()，直接发RST，不进入TIME_WAIT
+void abortiveClose(int sockfd);
 void shutdownWrite(int sockfd);
 
 void toIpPort(char *buf, size_t size, const struct sockaddr_in &addr);
@@ -41,8 +48,8 @@ void fromIpPort(const char *ip, uint16_t port, struct sockaddr_in *addr);
 
 int getSocketError(int sockfd);
 
-struct sockaddr_in getLocalAddr(int sockfd);
-struct sockaddr_in getPeerAddr(int sockfd);
+struct sockaddr_storage getLocalAddr(int sockfd);
+struct sockaddr_storage getPeerAddr(int sockfd);
 bool isSelfConnect(int sockfd);
 
 } // namespace sockets
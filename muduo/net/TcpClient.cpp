@@ -53,7 +53,7 @@ TcpClient::TcpClient(EventLoop *loop, const InetAddress &serverAddr,
     : loop_(CHECK_NOTNULL(loop)), connector_(new Connector(loop, serverAddr)),
       name_(name), connectionCallback_(defaultConnectionCallback),
       messageCallback_(defaultMessageCallback), retry_(false), connect_(true),
-      nextConnId_(1) {
+      nextConnId_(1), mutex_("TcpClient::mutex_") {
   // 设置连接成功回调函数
   connector_->setNewConnectionCallback(
       boost::bind(&TcpClient::newConnection, this, _1));
@@ -113,7 +113,7 @@ void TcpClient::stop() {
 void TcpClient::newConnection(int sockfd) {
   loop_->assertInLoopThread();
   InetAddress peerAddr(sockets::getPeerAddr(sockfd));
-  char buf[32];
+  char buf[64];
   snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_);
   ++nextConnId_;
   string connName = name_ + buf;
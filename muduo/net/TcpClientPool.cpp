@@ -0,0 +1,347 @@
+#include "TcpClientPool.h"
+
+#include "Atomic.h"
+#include "CountDownLatch.h"
+#include "EventLoop.h"
+#include "EventLoopThreadPool.h"
+#include "Logging.h"
+#include "TcpClient.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <sched.h>
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace {
+
+const int kVirtualNodes = 160; // 每个后端在哈希环上的点数
+
+// FNV-1a，再用MurmurHash3的fmix64打散
+uint64_t hashBytes(const char *data, size_t len) {
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < len; ++i) {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 1099511628211ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+std::atomic<int64_t> g_nextPoolId(1);
+
+// 调用线程上次查到的LoopSlots，0表示没有缓存
+__thread int64_t t_cachedPool = 0;
+__thread void *t_cachedLoopSlots = NULL;
+
+} // namespace
+
+// conn只在所属loop中修改（见publish()），raw是同一个指针。
+// 读者先在readers上登记再读raw，raw不为空才复制conn；
+// publish()先清空raw，等readers归零之后才修改conn
+struct TcpClientPool::Slot : boost::noncopyable {
+  Slot(EventLoop *l, int b)
+      : loop(l), backend(b), raw(NULL), readers(0), outstanding(0) {}
+
+  boost::scoped_ptr<TcpClient> client;
+  EventLoop *const loop;
+  const int backend;
+  TcpConnectionPtr conn;
+  std::atomic<TcpConnection *> raw;
+  std::atomic<int> readers; // 正在复制conn的线程数
+  std::atomic<int> outstanding;
+  char pad[kCacheLineSize];
+};
+
+// 属于同一个IO线程的连接，next只由这个线程修改
+struct TcpClientPool::LoopSlots : boost::noncopyable {
+  explicit LoopSlots(EventLoop *l) : loop(l), next(0) {}
+
+  EventLoop *const loop;
+  std::vector<int> slots;
+  unsigned next;
+  char pad[kCacheLineSize];
+};
+
+TcpClientPool::TcpClientPool(EventLoop *baseLoop,
+                             const std::vector<InetAddress> &backends,
+                             const string &name)
+    : id_(g_nextPoolId.fetch_add(1, std::memory_order_relaxed)),
+      baseLoop_(CHECK_NOTNULL(baseLoop)), backends_(backends), name_(name),
+      threadPool_(new EventLoopThreadPool(baseLoop)),
+      connectionsPerBackend_(1), policy_(kRoundRobin), started_(false),
+      connectionCallback_(defaultConnectionCallback),
+      messageCallback_(defaultMessageCallback), next_(0) {
+  assert(!backends_.empty());
+}
+
+TcpClientPool::~TcpClientPool() {
+  // TcpClient要在自己的loop里析构，不再回调本对象
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    Slot *slot = &slots_[i];
+    if (slot->loop->isInLoopThread()) {
+      destroySlot(slot, connectionCallback_);
+    } else {
+      CountDownLatch latch(1);
+      slot->loop->runInLoop(
+          boost::bind(&TcpClientPool::destroySlot, slot, connectionCallback_));
+      slot->loop->runInLoop(boost::bind(&CountDownLatch::countDown, &latch));
+      latch.wait();
+    }
+  }
+}
+
+void TcpClientPool::setThreadNum(int numThreads) {
+  assert(!started_);
+  threadPool_->setThreadNum(numThreads);
+}
+
+void TcpClientPool::start() {
+  assert(!started_);
+  baseLoop_->assertInLoopThread();
+  started_ = true;
+  threadPool_->start();
+
+  std::vector<EventLoop *> loops = threadPool_->getAllLoops();
+  for (size_t i = 0; i < loops.size(); ++i) {
+    loopSlots_.push_back(new LoopSlots(loops[i]));
+  }
+
+  backendSlots_.resize(backends_.size());
+  for (int i = 0; i < connectionsPerBackend_; ++i) {
+    for (size_t b = 0; b < backends_.size(); ++b) {
+      int index = static_cast<int>(slots_.size());
+      LoopSlots &ls = loopSlots_[index % loopSlots_.size()];
+      Slot *slot = new Slot(ls.loop, static_cast<int>(b));
+      slots_.push_back(slot);
+      ls.slots.push_back(index);
+      allSlots_.push_back(index);
+      backendSlots_[b].push_back(index);
+
+      char buf[32];
+      snprintf(buf, sizeof buf, "#%d", index);
+      slot->client.reset(new TcpClient(ls.loop, backends_[b], name_ + buf));
+      slot->client->setConnectionCallback(
+          boost::bind(&TcpClientPool::onConnection, this, slot, _1));
+      slot->client->setMessageCallback(messageCallback_);
+      slot->client->setWriteCompleteCallback(writeCompleteCallback_);
+      slot->client->enableRetry();
+      slot->client->connect();
+    }
+  }
+
+  for (size_t b = 0; b < backends_.size(); ++b) {
+    string key = backends_[b].toIpPort();
+    for (int v = 0; v < kVirtualNodes; ++v) {
+      char buf[32];
+      snprintf(buf, sizeof buf, "#%d", v);
+      string node = key + buf;
+      ring_.push_back(std::make_pair(hashBytes(node.data(), node.size()),
+                                     static_cast<int>(b)));
+    }
+  }
+  std::sort(ring_.begin(), ring_.end());
+}
+
+void TcpClientPool::onConnection(Slot *slot, const TcpConnectionPtr &conn) {
+  slot->loop->assertInLoopThread();
+  if (conn->connected()) {
+    slot->outstanding.store(0, std::memory_order_relaxed);
+    publish(slot, conn);
+  } else {
+    publish(slot, TcpConnectionPtr());
+  }
+  connectionCallback_(conn);
+}
+
+// 在slot->loop中调用。与take()配对：读者要么看到raw为空，
+// 要么它的登记被这里看到，等它复制完再改conn
+void TcpClientPool::publish(Slot *slot, const TcpConnectionPtr &conn) {
+  slot->raw.store(NULL, std::memory_order_seq_cst);
+  while (slot->readers.load(std::memory_order_seq_cst) != 0) {
+    ::sched_yield();
+  }
+  slot->conn = conn;
+  slot->raw.store(get_pointer(conn), std::memory_order_seq_cst);
+}
+
+void TcpClientPool::destroySlot(Slot *slot, const ConnectionCallback &cb) {
+  TcpConnectionPtr conn = slot->client->connection();
+  if (conn) {
+    conn->setConnectionCallback(cb);
+  }
+  publish(slot, TcpConnectionPtr());
+  slot->client->disconnect();
+  slot->client.reset();
+}
+
+// 不是池里的IO线程时为空。每个线程只查一次，之后用线程局部的缓存
+TcpClientPool::LoopSlots *TcpClientPool::ownLoopSlots() {
+  if (t_cachedPool == id_) {
+    return static_cast<LoopSlots *>(t_cachedLoopSlots);
+  }
+  LoopSlots *own = NULL;
+  EventLoop *loop = EventLoop::getEventLoopOfCurrentThread();
+  if (loop != NULL) {
+    for (size_t i = 0; i < loopSlots_.size(); ++i) {
+      if (loopSlots_[i].loop == loop) {
+        own = &loopSlots_[i];
+        break;
+      }
+    }
+  }
+  t_cachedPool = id_;
+  t_cachedLoopSlots = own;
+  return own;
+}
+
+// 连接可能刚好断开，这时返回空指针。复制conn只是一次引用计数加一
+TcpConnectionPtr TcpClientPool::take(int index, int *slot) {
+  Slot *s = &slots_[index];
+  TcpConnectionPtr conn;
+  s->readers.fetch_add(1, std::memory_order_seq_cst);
+  if (s->raw.load(std::memory_order_seq_cst) != NULL) {
+    conn = s->conn;
+  }
+  s->readers.fetch_sub(1, std::memory_order_release);
+  if (conn) {
+    s->outstanding.fetch_add(1, std::memory_order_relaxed);
+    if (slot != NULL) {
+      *slot = index;
+    }
+  }
+  return conn;
+}
+
+TcpConnectionPtr TcpClientPool::acquire(int *slot) {
+  assert(started_);
+  if (slot != NULL) {
+    *slot = -1;
+  }
+  LoopSlots *own = ownLoopSlots();
+  if (policy_ == kRoundRobin) {
+    return pickRoundRobin(own, slot);
+  }
+  TcpConnectionPtr conn;
+  if (own != NULL) {
+    conn = pickLeastOutstanding(own->slots, slot);
+  }
+  return conn ? conn : pickLeastOutstanding(allSlots_, slot);
+}
+
+TcpConnectionPtr TcpClientPool::pickRoundRobin(LoopSlots *own, int *slot) {
+  if (own != NULL) {
+    for (size_t i = 0; i < own->slots.size(); ++i) {
+      int index = own->slots[own->next++ % own->slots.size()];
+      if (slots_[index].raw.load(std::memory_order_acquire) != NULL) {
+        TcpConnectionPtr conn = take(index, slot);
+        if (conn) {
+          return conn;
+        }
+      }
+    }
+  }
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    int index = static_cast<int>(next_.fetch_add(1, std::memory_order_relaxed) %
+                                 slots_.size());
+    if (slots_[index].raw.load(std::memory_order_acquire) != NULL) {
+      TcpConnectionPtr conn = take(index, slot);
+      if (conn) {
+        return conn;
+      }
+    }
+  }
+  return TcpConnectionPtr();
+}
+
+TcpConnectionPtr
+TcpClientPool::pickLeastOutstanding(const std::vector<int> &candidates,
+                                    int *slot) {
+  int best = -1;
+  int least = 0;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const Slot &s = slots_[candidates[i]];
+    if (s.raw.load(std::memory_order_acquire) != NULL) {
+      int n = s.outstanding.load(std::memory_order_relaxed);
+      if (best < 0 || n < least) {
+        best = candidates[i];
+        least = n;
+      }
+    }
+  }
+  return best >= 0 ? take(best, slot) : TcpConnectionPtr();
+}
+
+// 后端的连接中优先选本线程的，再选未完成请求最少的
+TcpConnectionPtr TcpClientPool::pickBackend(int backend, LoopSlots *own,
+                                            int *slot) {
+  const std::vector<int> &candidates = backendSlots_[backend];
+  if (own != NULL) {
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      const Slot &s = slots_[candidates[i]];
+      if (s.loop == own->loop &&
+          s.raw.load(std::memory_order_acquire) != NULL) {
+        TcpConnectionPtr conn = take(candidates[i], slot);
+        if (conn) {
+          return conn;
+        }
+      }
+    }
+  }
+  return pickLeastOutstanding(candidates, slot);
+}
+
+TcpConnectionPtr TcpClientPool::acquire(const StringPiece &key, int *slot) {
+  assert(started_);
+  if (slot != NULL) {
+    *slot = -1;
+  }
+  LoopSlots *own = ownLoopSlots();
+  uint64_t h = hashBytes(key.data(), key.size());
+  std::vector<std::pair<uint64_t, int> >::const_iterator it = std::lower_bound(
+      ring_.begin(), ring_.end(), std::make_pair(h, 0));
+  // 沿着环找下一个可用的后端，已经试过的不再试
+  std::vector<bool> tried(backends_.size(), false);
+  for (size_t n = 0; n < ring_.size(); ++n, ++it) {
+    if (it == ring_.end()) {
+      it = ring_.begin();
+    }
+    if (!tried[it->second]) {
+      tried[it->second] = true;
+      TcpConnectionPtr conn = pickBackend(it->second, own, slot);
+      if (conn) {
+        return conn;
+      }
+    }
+  }
+  return TcpConnectionPtr();
+}
+
+void TcpClientPool::release(int slot) {
+  if (slot < 0) {
+    return;
+  }
+  assert(static_cast<size_t>(slot) < slots_.size());
+  std::atomic<int> &outstanding = slots_[slot].outstanding;
+  int n = outstanding.load(std::memory_order_relaxed);
+  while (n > 0 && !outstanding.compare_exchange_weak(
+                      n, n - 1, std::memory_order_relaxed)) {
+  }
+}
+
+int TcpClientPool::connectedCount() const {
+  int n = 0;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    if (slots_[i].raw.load(std::memory_order_relaxed) != NULL) {
+      ++n;
+    }
+  }
+  return n;
+}
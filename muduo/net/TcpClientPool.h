@@ -0,0 +1,114 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_TCPCLIENTPOOL_H
+#define MUDUO_NET_TCPCLIENTPOOL_H
+
+#include "InetAddress.h"
+#include "StringPiece.h"
+#include "TcpConnection.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace muduo {
+namespace net {
+
+class EventLoop;
+class EventLoopThreadPool;
+class TcpClient;
+
+///
+/// 到一组后端的连接池。每个后端保持N条连接（断开后自动重连），
+/// 分散在EventLoopThreadPool的各个IO线程上。
+///
+/// acquire()可以在任何线程调用，只用原子操作，不加锁（也不经过
+/// boost::atomic_load的spinlock池）：
+/// - 调用者本身是池里的某个IO线程时，优先选同一个loop上的连接，
+///   之后的send()不必跨线程；
+/// - 否则在所有连接中选择。
+/// 选择方式有轮转、最少未完成请求（需要配合release()），
+/// 以及按key的一致性哈希acquire(key)，同一个key总是落到同一个后端。
+///
+/// 连接建立或断开时，IO线程要等正在复制这个槽位连接的acquire()离开
+/// （只是一次引用计数加一）才能替换它。
+///
+class TcpClientPool : boost::noncopyable {
+public:
+  enum Policy { kRoundRobin, kLeastOutstanding };
+
+  TcpClientPool(EventLoop *baseLoop, const std::vector<InetAddress> &backends,
+                const string &name);
+  ~TcpClientPool(); // force out-line dtor, for scoped_ptr members.
+
+  /// 以下几个必须在start()之前调用
+  void setThreadNum(int numThreads);
+  void setConnectionsPerBackend(int n) { connectionsPerBackend_ = n; }
+  void setPolicy(Policy policy) { policy_ = policy; }
+  void setConnectionCallback(const ConnectionCallback &cb) {
+    connectionCallback_ = cb;
+  }
+  void setMessageCallback(const MessageCallback &cb) { messageCallback_ = cb; }
+  void setWriteCompleteCallback(const WriteCompleteCallback &cb) {
+    writeCompleteCallback_ = cb;
+  }
+
+  /// 在baseLoop线程中调用，启动IO线程并发起所有连接
+  void start();
+
+  /// Thread safe. 没有可用连接时返回空指针。
+  /// slot不为空时存入连接所在的槽位（没有连接时为-1），请求完成后交给release()
+  TcpConnectionPtr acquire(int *slot = NULL);
+  /// Thread safe. 一致性哈希，后端全部不可用时返回空指针
+  TcpConnectionPtr acquire(const StringPiece &key, int *slot = NULL);
+  /// Thread safe. 请求完成，kLeastOutstanding据此计数。
+  /// 连接在此期间重连过也没关系，槽位的计数在重连时清零
+  void release(int slot);
+
+  /// Thread safe. 当前已连接的连接数
+  int connectedCount() const;
+
+private:
+  struct Slot;
+  struct LoopSlots;
+
+  void onConnection(Slot *slot, const TcpConnectionPtr &conn);
+  LoopSlots *ownLoopSlots();
+  TcpConnectionPtr take(int index, int *slot);
+  TcpConnectionPtr pickRoundRobin(LoopSlots *own, int *slot);
+  TcpConnectionPtr pickLeastOutstanding(const std::vector<int> &candidates,
+                                        int *slot);
+  TcpConnectionPtr pickBackend(int backend, LoopSlots *own, int *slot);
+  static void publish(Slot *slot, const TcpConnectionPtr &conn);
+  static void destroySlot(Slot *slot, const ConnectionCallback &cb);
+
+  const int64_t id_; // 进程内唯一，用于缓存调用线程所属的LoopSlots
+  EventLoop *baseLoop_;
+  const std::vector<InetAddress> backends_;
+  const string name_;
+  boost::scoped_ptr<EventLoopThreadPool> threadPool_;
+  int connectionsPerBackend_;
+  Policy policy_;
+  bool started_;
+  ConnectionCallback connectionCallback_;
+  MessageCallback messageCallback_;
+  WriteCompleteCallback writeCompleteCallback_;
+
+  // start()之后只读
+  boost::ptr_vector<Slot> slots_;
+  boost::ptr_vector<LoopSlots> loopSlots_;
+  std::vector<int> allSlots_;
+  std::vector<std::vector<int> > backendSlots_;
+  std::vector<std::pair<uint64_t, int> > ring_; // 哈希值 -> 后端下标
+
+  std::atomic<unsigned> next_; // 不在池内IO线程时的轮转位置
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_TCPCLIENTPOOL_H
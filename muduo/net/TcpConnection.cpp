@@ -16,8 +16,11 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
 #include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
+#include <sys/uio.h>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -36,10 +39,31 @@ void muduo::net::defaultMessageCallback(const TcpConnectionPtr &, Buffer *buf,
 TcpConnection::TcpConnection(EventLoop *loop, const string &nameArg, int sockfd,
                              const InetAddress &localAddr,
                              const InetAddress &peerAddr)
-    : loop_(CHECK_NOTNULL(loop)), name_(nameArg), state_(kConnecting),
-      socket_(new Socket(sockfd)), channel_(new Channel(loop, sockfd)),
-      localAddr_(localAddr), peerAddr_(peerAddr),
-      highWaterMark_(64 * 1024 * 1024) {
+    : loop_(CHECK_NOTNULL(loop)), id_(0), name_(new string(nameArg)),
+      state_(kConnecting), socket_(new Socket(sockfd)),
+      channel_(new Channel(loop, sockfd)), localAddr_(localAddr),
+      peerAddr_(peerAddr), highWaterMark_(64 * 1024 * 1024), trackedBytes_(0),
+      payloadBytes_(0), readPauses_(0), pausedByPeers_(0),
+      backpressureHigh_(0), backpressureLow_(0), maxInputBuffer_(0),
+      outputFull_(false) {
+  init();
+}
+
+TcpConnection::TcpConnection(EventLoop *loop, int64_t id,
+                             const boost::shared_ptr<const string> &namePrefix,
+                             int sockfd, const InetAddress &localAddr,
+                             const InetAddress &peerAddr)
+    : loop_(CHECK_NOTNULL(loop)), id_(id), namePrefix_(namePrefix),
+      name_(NULL), state_(kConnecting), socket_(new Socket(sockfd)),
+      channel_(new Channel(loop, sockfd)), localAddr_(localAddr),
+      peerAddr_(peerAddr), highWaterMark_(64 * 1024 * 1024), trackedBytes_(0),
+      payloadBytes_(0), readPauses_(0), pausedByPeers_(0),
+      backpressureHigh_(0), backpressureLow_(0), maxInputBuffer_(0),
+      outputFull_(false) {
+  init();
+}
+
+void TcpConnection::init() {
   // 通道可读事件到来的时候，回调TcpConnection::handleRead，_1是事件发生时间
   channel_->setReadCallback(boost::bind(&TcpConnection::handleRead, this, _1));
   // 通道可写事件到来的时候，回调TcpConnection::handleWrite
@@ -48,14 +72,30 @@ TcpConnection::TcpConnection(EventLoop *loop, const string &nameArg, int sockfd,
   channel_->setCloseCallback(boost::bind(&TcpConnection::handleClose, this));
   // 发生错误，回调TcpConnection::handleError
   channel_->setErrorCallback(boost::bind(&TcpConnection::handleError, this));
-  LOG_DEBUG << "TcpConnection::ctor[" << name_ << "] at " << this
-            << " fd=" << sockfd;
+  LOG_DEBUG << "TcpConnection::ctor[" << name() << "] at " << this
+            << " fd=" << channel_->fd();
   socket_->setKeepAlive(true);
 }
 
 TcpConnection::~TcpConnection() {
-  LOG_DEBUG << "TcpConnection::dtor[" << name_ << "] at " << this
+  LOG_DEBUG << "TcpConnection::dtor[" << name() << "] at " << this
             << " fd=" << channel_->fd();
+  delete name_.load(std::memory_order_relaxed);
+}
+
+// 多个线程同时格式化时只有一个结果被采用
+const string &TcpConnection::formatName() const {
+  char buf[32];
+  snprintf(buf, sizeof buf, "%" PRId64, id_);
+  const string *formatted = new string(*namePrefix_ + buf);
+  const string *expected = NULL;
+  if (!name_.compare_exchange_strong(expected, formatted,
+                                     std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+    delete formatted;
+    return *expected;
+  }
+  return *formatted;
 }
 
 // 线程安全，可以跨线程调用
@@ -97,6 +137,18 @@ void TcpConnection::send(Buffer *buf) {
   }
 }
 
+// 线程安全，可以跨线程调用
+void TcpConnection::send(const SharedPayload &payload) {
+  if (state_ == kConnected) {
+    if (loop_->isInLoopThread()) {
+      sendPayloadInLoop(payload);
+    } else {
+      loop_->runInLoop(
+          boost::bind(&TcpConnection::sendPayloadInLoop, this, payload));
+    }
+  }
+}
+
 void TcpConnection::sendInLoop(const StringPiece &message) {
   sendInLoop(message.data(), message.size());
 }
@@ -117,7 +169,8 @@ void TcpConnection::sendInLoop(const void *data, size_t len) {
   }
   // if no thing in output queue, try writing directly
   // 通道没有关注可写事件并且发送缓冲区没有数据，直接write
-  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) {
+  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0 &&
+      chunks_.empty()) {
     nwrote = sockets::write(channel_->fd(), data, len);
     if (nwrote >= 0) {
       remaining = len - nwrote;
@@ -144,7 +197,7 @@ void TcpConnection::sendInLoop(const void *data, size_t len) {
   // buffer中）
   if (!error && remaining > 0) {
     LOG_TRACE << "I am going to write more data";
-    size_t oldLen = outputBuffer_.readableBytes();
+    size_t oldLen = outputBuffer_.readableBytes() + payloadBytes_;
     // 如果超过highWaterMark_（高水位标），回调highWaterMarkCallback_
     if (oldLen + remaining >= highWaterMark_ && oldLen < highWaterMark_ &&
         highWaterMarkCallback_) {
@@ -152,10 +205,170 @@ void TcpConnection::sendInLoop(const void *data, size_t len) {
                                      oldLen + remaining));
     }
     outputBuffer_.append(static_cast<const char *>(data) + nwrote, remaining);
+    if (!chunks_.empty()) {
+      trackOutputBuffer();
+    }
     if (!channel_->isWriting()) {
       channel_->enableWriting(); // 关注POLLOUT事件
     }
+    updateOutputBackpressure();
+  }
+}
+
+void TcpConnection::sendPayloadInLoop(const SharedPayload &payload) {
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected) {
+    LOG_WARN << "disconnected, give up writing";
+    return;
+  }
+  size_t len = payload.size();
+  size_t nwrote = 0;
+  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0 &&
+      chunks_.empty()) {
+    ssize_t n = sockets::write(channel_->fd(), payload.data(), len);
+    if (n >= 0) {
+      nwrote = static_cast<size_t>(n);
+      if (nwrote == len && writeCompleteCallback_) {
+        loop_->queueInLoop(
+            boost::bind(writeCompleteCallback_, shared_from_this()));
+      }
+    } else if (errno != EWOULDBLOCK) {
+      LOG_SYSERR << "TcpConnection::sendPayloadInLoop";
+      if (errno == EPIPE) {
+        return;
+      }
+    }
+  }
+
+  if (nwrote < len) {
+    size_t remaining = len - nwrote;
+    size_t oldLen = outputBuffer_.readableBytes() + payloadBytes_;
+    if (oldLen + remaining >= highWaterMark_ && oldLen < highWaterMark_ &&
+        highWaterMarkCallback_) {
+      loop_->queueInLoop(boost::bind(highWaterMarkCallback_, shared_from_this(),
+                                     oldLen + remaining));
+    }
+    // outputBuffer_里已有的数据排在前面
+    trackOutputBuffer();
+    chunks_.push_back(OutputChunk(payload, nwrote));
+    payloadBytes_ += remaining;
+    if (!channel_->isWriting()) {
+      channel_->enableWriting();
+    }
+    updateOutputBackpressure();
+  }
+}
+
+// 把outputBuffer_中还没记入chunks_的字节（send()或者调用者直接追加的）
+// 排到队尾
+void TcpConnection::trackOutputBuffer() {
+  size_t untracked = outputBuffer_.readableBytes() - trackedBytes_;
+  if (untracked == 0) {
+    return;
+  }
+  if (!chunks_.empty() && chunks_.back().payload.empty()) {
+    chunks_.back().len += untracked;
+  } else {
+    chunks_.push_back(OutputChunk(untracked));
+  }
+  trackedBytes_ += untracked;
+}
+
+// 按chunks_的顺序writev()，返回写出的字节数
+ssize_t TcpConnection::writeChunks() {
+  const int kMaxIovecs = 16;
+  struct iovec iov[kMaxIovecs];
+  int count = 0;
+  size_t bufferOffset = 0;
+  for (std::deque<OutputChunk>::const_iterator it = chunks_.begin();
+       it != chunks_.end() && count < kMaxIovecs; ++it, ++count) {
+    if (it->payload.empty()) {
+      iov[count].iov_base = const_cast<char *>(outputBuffer_.peek()) + bufferOffset;
+      iov[count].iov_len = it->len;
+      bufferOffset += it->len;
+    } else {
+      iov[count].iov_base = const_cast<char *>(it->payload.data()) + it->offset;
+      iov[count].iov_len = it->payload.size() - it->offset;
+    }
   }
+
+  ssize_t n = sockets::writev(channel_->fd(), iov, count);
+  size_t left = n > 0 ? static_cast<size_t>(n) : 0;
+  while (left > 0) {
+    OutputChunk &chunk = chunks_.front();
+    if (chunk.payload.empty()) {
+      size_t take = std::min(left, chunk.len);
+      outputBuffer_.retrieve(take);
+      trackedBytes_ -= take;
+      chunk.len -= take;
+      left -= take;
+      if (chunk.len == 0) {
+        chunks_.pop_front();
+      }
+    } else {
+      size_t take = std::min(left, chunk.payload.size() - chunk.offset);
+      chunk.offset += take;
+      payloadBytes_ -= take;
+      left -= take;
+      if (chunk.offset == chunk.payload.size()) {
+        chunks_.pop_front(); // 释放对payload的引用
+      }
+    }
+  }
+  // payload都写完了，剩下的都在outputBuffer_里，顺序不变
+  if (payloadBytes_ == 0) {
+    chunks_.clear();
+    trackedBytes_ = 0;
+  }
+  return n;
+}
+
+void TcpConnection::flushOutput() {
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected) {
+    LOG_WARN << "disconnected, give up writing";
+    outputBuffer_.retrieveAll();
+    chunks_.clear();
+    trackedBytes_ = 0;
+    payloadBytes_ = 0;
+    return;
+  }
+  if (!chunks_.empty()) {
+    trackOutputBuffer();
+    updateOutputBackpressure();
+    return;
+  }
+  // 已经在等待POLLOUT，新数据排在后面由handleWrite()发送
+  if (channel_->isWriting() || outputBuffer_.readableBytes() == 0) {
+    updateOutputBackpressure();
+    return;
+  }
+
+  ssize_t nwrote = sockets::write(channel_->fd(), outputBuffer_.peek(),
+                                  outputBuffer_.readableBytes());
+  if (nwrote >= 0) {
+    outputBuffer_.retrieve(nwrote);
+    if (outputBuffer_.readableBytes() == 0) {
+      if (writeCompleteCallback_) {
+        loop_->queueInLoop(
+            boost::bind(writeCompleteCallback_, shared_from_this()));
+      }
+      return;
+    }
+  } else if (errno != EWOULDBLOCK) {
+    LOG_SYSERR << "TcpConnection::flushOutput";
+    if (errno == EPIPE) {
+      return;
+    }
+  }
+
+  size_t remaining = outputBuffer_.readableBytes();
+  if (remaining >= highWaterMark_ && highWaterMarkCallback_) {
+    loop_->queueInLoop(
+        boost::bind(highWaterMarkCallback_, shared_from_this(), remaining));
+  }
+  channel_->enableWriting();
+  updateOutputBackpressure();
 }
 
 void TcpConnection::shutdown() {
@@ -179,6 +392,109 @@ void TcpConnection::shutdownInLoop() {
 
 void TcpConnection::setTcpNoDelay(bool on) { socket_->setTcpNoDelay(on); }
 
+void TcpConnection::stopRead() {
+  loop_->runInLoop(boost::bind(&TcpConnection::pauseReadInLoop,
+                               shared_from_this(), kStoppedByUser, true));
+}
+
+void TcpConnection::startRead() {
+  loop_->runInLoop(boost::bind(&TcpConnection::pauseReadInLoop,
+                               shared_from_this(), kStoppedByUser | kInputFull,
+                               false));
+}
+
+void TcpConnection::pauseReadInLoop(int reasons, bool paused) {
+  loop_->assertInLoopThread();
+  if (paused) {
+    readPauses_ |= reasons;
+  } else {
+    readPauses_ &= ~reasons;
+  }
+  updateReading();
+}
+
+// 下游连接发不出去或者又发得出去了，可能有几个下游
+void TcpConnection::pausedByPeerInLoop(bool paused) {
+  loop_->assertInLoopThread();
+  pausedByPeers_ += paused ? 1 : -1;
+  assert(pausedByPeers_ >= 0);
+  updateReading();
+}
+
+// 没有暂停的原因才关注POLLIN
+void TcpConnection::updateReading() {
+  if (state_ != kConnected && state_ != kDisconnecting) {
+    return;
+  }
+  if (isReading() && !channel_->isReading()) {
+    LOG_TRACE << name() << " resume reading";
+    channel_->enableReading();
+  } else if (!isReading() && channel_->isReading()) {
+    LOG_TRACE << name() << " pause reading, reasons = " << readPauses_
+              << " peers = " << pausedByPeers_;
+    channel_->disableReading();
+  }
+}
+
+void TcpConnection::setReadBackpressure(size_t highMark, size_t lowMark) {
+  setReadBackpressure(highMark, lowMark, shared_from_this());
+}
+
+void TcpConnection::setReadBackpressure(size_t highMark, size_t lowMark,
+                                        const TcpConnectionPtr &source) {
+  assert(highMark == 0 || lowMark < highMark);
+  loop_->runInLoop(boost::bind(&TcpConnection::setReadBackpressureInLoop,
+                               shared_from_this(), highMark, lowMark,
+                               boost::weak_ptr<TcpConnection>(source)));
+}
+
+void TcpConnection::coupleReadBackpressure(const TcpConnectionPtr &a,
+                                           const TcpConnectionPtr &b,
+                                           size_t highMark, size_t lowMark) {
+  a->setReadBackpressure(highMark, lowMark, b);
+  b->setReadBackpressure(highMark, lowMark, a);
+}
+
+void TcpConnection::setReadBackpressureInLoop(
+    size_t highMark, size_t lowMark,
+    const boost::weak_ptr<TcpConnection> &source) {
+  loop_->assertInLoopThread();
+  // 先放开原来的source，再按新的水位重新判断
+  if (outputFull_) {
+    outputFull_ = false;
+    pauseSource(false);
+  }
+  backpressureHigh_ = highMark;
+  backpressureLow_ = lowMark;
+  backpressureSource_ = source;
+  updateOutputBackpressure();
+}
+
+// 待发送的数据每次增减之后调用，在高低水位之间不改变状态
+void TcpConnection::updateOutputBackpressure() {
+  if (backpressureHigh_ == 0) {
+    return;
+  }
+  size_t pending = outputBuffer_.readableBytes() + payloadBytes_;
+  if (!outputFull_ && pending >= backpressureHigh_) {
+    outputFull_ = true;
+    pauseSource(true);
+  } else if (outputFull_ && pending <= backpressureLow_) {
+    outputFull_ = false;
+    pauseSource(false);
+  }
+}
+
+void TcpConnection::pauseSource(bool paused) {
+  TcpConnectionPtr source(backpressureSource_.lock());
+  if (source.get() == this) {
+    pauseReadInLoop(kOutputFull, paused);
+  } else if (source) {
+    source->getLoop()->runInLoop(
+        boost::bind(&TcpConnection::pausedByPeerInLoop, source, paused));
+  }
+}
+
 void TcpConnection::connectEstablished() {
   loop_->assertInLoopThread();
   assert(state_ == kConnecting);
@@ -186,7 +502,7 @@ void TcpConnection::connectEstablished() {
   LOG_TRACE << "[3] usecount=" << shared_from_this().use_count();
   // enable_shared_from_this是一个以其派生类为模板类型参数的基类模板，继承它，派生类的this指针就能变成一个shared_ptr。
   channel_->tie(shared_from_this());
-  channel_->enableReading(); // TcpConnection所对应的通道加入到Poller关注
+  updateReading(); // 通道加入到Poller关注，除非已经stopRead()
 
   connectionCallback_(shared_from_this());
   LOG_TRACE << "[4] usecount=" << shared_from_this().use_count();
@@ -200,6 +516,11 @@ void TcpConnection::connectDestroyed() {
 
     connectionCallback_(shared_from_this());
   }
+  // 不再发送，放开被暂停的source
+  if (outputFull_) {
+    outputFull_ = false;
+    pauseSource(false);
+  }
   channel_->remove();
 }
 
@@ -228,6 +549,11 @@ void TcpConnection::handleRead(Timestamp receiveTime) {
   ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
   if (n > 0) {
     messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    // 应用层没有消费掉，不再读进来
+    if (maxInputBuffer_ > 0 &&
+        inputBuffer_.readableBytes() >= maxInputBuffer_) {
+      pauseReadInLoop(kInputFull, true);
+    }
   } else if (n == 0) {
     handleClose();
   } else {
@@ -241,11 +567,20 @@ void TcpConnection::handleRead(Timestamp receiveTime) {
 void TcpConnection::handleWrite() {
   loop_->assertInLoopThread();
   if (channel_->isWriting()) {
-    ssize_t n = sockets::write(channel_->fd(), outputBuffer_.peek(),
-                               outputBuffer_.readableBytes());
+    ssize_t n;
+    if (chunks_.empty()) {
+      n = sockets::write(channel_->fd(), outputBuffer_.peek(),
+                         outputBuffer_.readableBytes());
+      if (n > 0) {
+        outputBuffer_.retrieve(n);
+      }
+    } else {
+      n = writeChunks();
+    }
     if (n > 0) {
-      outputBuffer_.retrieve(n);
-      if (outputBuffer_.readableBytes() == 0) // 发送缓冲区已清空
+      updateOutputBackpressure();
+      // 发送缓冲区已清空
+      if (outputBuffer_.readableBytes() == 0 && chunks_.empty())
       {
         channel_->disableWriting(); // 停止关注POLLOUT事件，以免出现busy loop
         if (writeCompleteCallback_) // 回调writeCompleteCallback_
@@ -292,6 +627,6 @@ void TcpConnection::handleClose() {
 
 void TcpConnection::handleError() {
   int err = sockets::getSocketError(channel_->fd());
-  LOG_ERROR << "TcpConnection::handleError [" << name_
+  LOG_ERROR << "TcpConnection::handleError [" << name()
             << "] - SO_ERROR = " << err << " " << strerror_tl(err);
 }
@@ -15,6 +15,7 @@
 #include "Callbacks.h"
 #include "InetAddress.h"
 #include "Mutex.h"
+#include "SharedPayload.h"
 #include "StringPiece.h"
 #include "Types.h"
 
@@ -23,6 +24,10 @@
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <atomic>
+#include <deque>
 
 namespace muduo {
 namespace net {
@@ -43,10 +48,20 @@ public:
   /// User should not create this object.
   TcpConnection(EventLoop *loop, const string &name, int sockfd,
                 const InetAddress &localAddr, const InetAddress &peerAddr);
+  /// TcpServer用：名字是namePrefix加上id，第一次调用name()时才格式化
+  TcpConnection(EventLoop *loop, int64_t id,
+                const boost::shared_ptr<const string> &namePrefix, int sockfd,
+                const InetAddress &localAddr, const InetAddress &peerAddr);
   ~TcpConnection();
 
   EventLoop *getLoop() const { return loop_; }
-  const string &name() const { return name_; }
+  /// 在所属TcpServer内唯一，从1开始；用名字构造的连接为0
+  int64_t id() const { return id_; }
+  /// Thread safe.
+  const string &name() const {
+    const string *name = name_.load(std::memory_order_acquire);
+    return name != NULL ? *name : formatName();
+  }
   const InetAddress &localAddress() { return localAddr_; }
   const InetAddress &peerAddress() { return peerAddr_; }
   bool connected() const { return state_ == kConnected; }
@@ -56,6 +71,8 @@ public:
   void send(const StringPiece &message);
   // void send(Buffer&& message); // C++11
   void send(Buffer *message); // this one will swap data without copying
+  // 没写完的部分只保存引用，不复制。广播时对所有连接用同一个payload
+  void send(const SharedPayload &payload);
   void shutdown();            // NOT thread safe, no simultaneous calling
   void setTcpNoDelay(bool on);
 
@@ -81,8 +98,40 @@ public:
     highWaterMark_ = highWaterMark;
   }
 
+  /// Thread safe. 暂停之后内核接收缓冲区满了，对端就被TCP流量控制挡住。
+  /// 暂停期间不关注任何事件时也察觉不到对端关闭
+  void stopRead();
+  /// Thread safe. 也解除setMaxInputBuffer()造成的暂停
+  void startRead();
+  /// Loop thread only. 没有任何原因暂停读
+  bool isReading() const { return readPauses_ == 0 && pausedByPeers_ == 0; }
+
+  /// Thread safe. 自动背压：待发送的数据达到highMark时暂停读，
+  /// 降到lowMark以下再恢复。highMark为0表示关闭。
+  /// 这个重载暂停本连接的读，适合echo之类读到什么就写回去的服务
+  void setReadBackpressure(size_t highMark, size_t lowMark);
+  /// Thread safe. 写到本连接的数据是从source读来的（代理的一个方向），
+  /// 发不出去时暂停source的读。只保存source的weak_ptr，可以在不同EventLoop
+  void setReadBackpressure(size_t highMark, size_t lowMark,
+                           const TcpConnectionPtr &source);
+  /// 代理的两个连接互相背压：任何一边发不出去就暂停另一边的读
+  static void coupleReadBackpressure(const TcpConnectionPtr &a,
+                                     const TcpConnectionPtr &b,
+                                     size_t highMark, size_t lowMark);
+
+  /// inputBuffer()在messageCallback之后仍有maxBytes以上时暂停读，
+  /// 应用层消费之后调用startRead()恢复。0表示不限
+  void setMaxInputBuffer(size_t maxBytes) { maxInputBuffer_ = maxBytes; }
+
   Buffer *inputBuffer() { return &inputBuffer_; }
 
+  /// Loop thread only. Encoders may append to the output buffer in place
+  /// and then call flushOutput(), saving the copy made by send().
+  Buffer *outputBuffer() { return &outputBuffer_; }
+  /// Loop thread only. Writes what outputBuffer() holds if nothing is pending,
+  /// otherwise it goes out with the pending data on POLLOUT.
+  void flushOutput();
+
   /// Internal use only.
   void setCloseCallback(const CloseCallback &cb) { closeCallback_ = cb; }
 
@@ -93,17 +142,33 @@ public:
 
 private:
   enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
+  // 暂停读的原因，可以同时有几个
+  enum ReadPauseE { kStoppedByUser = 1, kOutputFull = 2, kInputFull = 4 };
+  void init();
   void handleRead(Timestamp receiveTime);
   void handleWrite();
   void handleClose();
   void handleError();
   void sendInLoop(const StringPiece &message);
   void sendInLoop(const void *message, size_t len);
+  void sendPayloadInLoop(const SharedPayload &payload);
+  void trackOutputBuffer();
+  ssize_t writeChunks();
   void shutdownInLoop();
+  void pauseReadInLoop(int reasons, bool paused);
+  void pausedByPeerInLoop(bool paused);
+  void updateReading();
+  void setReadBackpressureInLoop(size_t highMark, size_t lowMark,
+                                 const boost::weak_ptr<TcpConnection> &source);
+  void updateOutputBackpressure();
+  void pauseSource(bool paused);
   void setState(StateE s) { state_ = s; }
+  const string &formatName() const;
 
   EventLoop *loop_; // 所属EventLoop
-  string name_;     // 连接名
+  const int64_t id_;
+  boost::shared_ptr<const string> namePrefix_; // 同一个TcpServer的连接共用
+  mutable std::atomic<const string *> name_;   // 连接名，NULL表示还没格式化
   StateE state_;    // FIXME: use atomic variable
   // we don't expose those classes to client.
   boost::scoped_ptr<Socket> socket_;
@@ -121,7 +186,31 @@ private:
   Buffer inputBuffer_;                          // 应用层接收缓冲区
   // FIXME: use list<Buffer> as output buffer.
   Buffer outputBuffer_; // 应用层发送缓冲区
+
+  // 有SharedPayload在排队时，发送顺序由chunks_记录：payload为空的一项
+  // 表示outputBuffer_中接下来的len字节，否则是payload从offset开始的部分。
+  // 没有payload排队时chunks_为空，只用outputBuffer_
+  struct OutputChunk {
+    explicit OutputChunk(size_t bytes) : offset(0), len(bytes) {}
+    OutputChunk(const SharedPayload &p, size_t off)
+        : payload(p), offset(off), len(0) {}
+
+    SharedPayload payload;
+    size_t offset;
+    size_t len;
+  };
+  std::deque<OutputChunk> chunks_;
+  size_t trackedBytes_; // outputBuffer_中已经记入chunks_的字节数
+  size_t payloadBytes_; // chunks_中payload还没写出的字节数
   boost::any context_;  // 绑定一个未知类型的上下文对象
+
+  int readPauses_;          // ReadPauseE的组合
+  int pausedByPeers_;       // 有几个下游连接发不出去
+  size_t backpressureHigh_; // 0表示不自动背压
+  size_t backpressureLow_;
+  size_t maxInputBuffer_;
+  bool outputFull_; // 已经因为发不出去暂停了source的读
+  boost::weak_ptr<TcpConnection> backpressureSource_; // 可以是自己
 };
 
 // typedef boost::shared_ptr<TcpConnection> TcpConnectionPtr;
@@ -9,6 +9,7 @@
 #include "TcpServer.h"
 
 #include "Acceptor.h"
+#include "CountDownLatch.h"
 #include "EventLoop.h"
 #include "EventLoopThreadPool.h"
 #include "Logging.h"
@@ -16,7 +17,7 @@
 
 #include <boost/bind.hpp>
 
-#include <stdio.h> // snprintf
+#include <algorithm>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -28,7 +29,13 @@ TcpServer::TcpServer(EventLoop *loop, const InetAddress &listenAddr,
       threadPool_(new EventLoopThreadPool(loop)),
       connectionCallback_(defaultConnectionCallback),
       messageCallback_(defaultMessageCallback), started_(false),
-      nextConnId_(1) {
+      connNamePrefix_(new string(nameArg + ":" + hostport_ + "#")),
+      nextConnId_(1), nextLoop_(0), maxConnections_(0),
+      maxConnectionsPerIp_(0), maxAcceptRate_(0), acceptBurst_(0),
+      overloadPolicy_(kPauseAccepting), acceptTokens_(0),
+      pausedForLimit_(false), pausedForRate_(false), connectionCount_(0),
+      acceptPaused_(false), rejectedByLimit_(0), rejectedByPeer_(0),
+      rejectedByRate_(0), acceptPauses_(0), self_(new TcpServer *(this)) {
   // Acceptor::handleRead函数中会回调用TcpServer::newConnection
   // _1对应的是socket文件描述符，_2对应的是对等方的地址(InetAddress)
   acceptor_->setNewConnectionCallback(
@@ -38,15 +45,22 @@ TcpServer::TcpServer(EventLoop *loop, const InetAddress &listenAddr,
 TcpServer::~TcpServer() {
   loop_->assertInLoopThread();
   LOG_TRACE << "TcpServer::~TcpServer [" << name_ << "] destructing";
+  loop_->cancel(resumeTimer_);
 
-  for (ConnectionMap::iterator it(connections_.begin());
-       it != connections_.end(); ++it) {
-    TcpConnectionPtr conn = it->second;
-    it->second.reset(); // 释放当前所控制的对象，引用计数减一
-    conn->getLoop()->runInLoop(
-        boost::bind(&TcpConnection::connectDestroyed, conn));
-    conn.reset(); // 可以不调用
+  // 连接表只能在各自的IO线程中访问，等它们都清理完
+  for (size_t i = 0; i < registries_.size(); ++i) {
+    LoopConnections *registry = &registries_[i];
+    if (registry->loop == loop_) {
+      destroyConnections(registry, NULL);
+    } else {
+      CountDownLatch latch(1);
+      registry->loop->runInLoop(
+          boost::bind(&TcpServer::destroyConnections, registry, &latch));
+      latch.wait();
+    }
   }
+  // 所有连接都已销毁，IO线程不会再读self_
+  self_.reset();
 }
 
 void TcpServer::setThreadNum(int numThreads) {
@@ -54,12 +68,38 @@ void TcpServer::setThreadNum(int numThreads) {
   threadPool_->setThreadNum(numThreads);
 }
 
+std::vector<EventLoopMetrics> TcpServer::loopMetrics() const {
+  return threadPool_->metrics();
+}
+
+void TcpServer::setMaxAcceptRate(double perSecond, int burst) {
+  assert(!started_);
+  maxAcceptRate_ = perSecond;
+  acceptBurst_ = burst > 0 ? burst : std::max(perSecond, 1.0);
+  acceptTokens_ = acceptBurst_;
+  lastRefill_ = Timestamp::now();
+}
+
+TcpServer::AdmissionStats TcpServer::admissionStats() const {
+  AdmissionStats stats;
+  stats.connections = connectionCount_.load(std::memory_order_relaxed);
+  stats.rejectedByLimit = rejectedByLimit_.load(std::memory_order_relaxed);
+  stats.rejectedByPeer = rejectedByPeer_.load(std::memory_order_relaxed);
+  stats.rejectedByRate = rejectedByRate_.load(std::memory_order_relaxed);
+  stats.acceptPauses = acceptPauses_.load(std::memory_order_relaxed);
+  return stats;
+}
+
 // 该函数多次调用是无害的
 // 该函数可以跨线程调用
 void TcpServer::start() {
   if (!started_) {
     started_ = true;
     threadPool_->start(threadInitCallback_);
+    std::vector<EventLoop *> loops = threadPool_->getAllLoops();
+    for (size_t i = 0; i < loops.size(); ++i) {
+      registries_.push_back(new LoopConnections(loops[i]));
+    }
   }
 
   if (!acceptor_->listenning()) {
@@ -73,80 +113,201 @@ void TcpServer::start() {
  */
 void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr) {
   loop_->assertInLoopThread();
+  if (!admit(peerAddr)) {
+    // 不进入TIME_WAIT，被拒绝的连接不占用本机资源
+    sockets::abortiveClose(sockfd);
+    return;
+  }
   // 按照轮叫的方式选择一个EventLoop
-  EventLoop *ioLoop = threadPool_->getNextLoop();
-  char buf[32];
-  snprintf(buf, sizeof buf, ":%s#%d", hostport_.c_str(), nextConnId_);
-  ++nextConnId_;
-  string connName = name_ + buf;
-
-  LOG_INFO << "TcpServer::newConnection [" << name_ << "] - new connection ["
-           << connName << "] from " << peerAddr.toIpPort();
+  LoopConnections *registry = &registries_[nextLoop_];
+  if (++nextLoop_ >= registries_.size()) {
+    nextLoop_ = 0;
+  }
+  EventLoop *ioLoop = registry->loop;
+  int64_t connId = nextConnId_++;
+
+  LOG_INFO << "TcpServer::newConnection [" << name_ << "] - new connection #"
+           << connId << " from " << peerAddr.toIpPort();
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
   // FIXME use make_shared if necessary
-  /*TcpConnectionPtr conn(new TcpConnection(loop_,
-                                          connName,
-                                          sockfd,
-                                          localAddr,
-                                          peerAddr));*/
-
-  TcpConnectionPtr conn(
-      new TcpConnection(ioLoop, connName, sockfd, localAddr, peerAddr));
-
-  LOG_TRACE << "[1] usecount=" << conn.use_count();
-  connections_[connName] = conn;
-  LOG_TRACE << "[2] usecount=" << conn.use_count();
+  // 连接名到第一次用到时才格式化
+  TcpConnectionPtr conn(new TcpConnection(ioLoop, connId, connNamePrefix_,
+                                          sockfd, localAddr, peerAddr));
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
   conn->setWriteCompleteCallback(writeCompleteCallback_);
-
+  // 关闭在IO线程中处理，不再经过base loop
+  // ~TcpServer等所有连接销毁之后才返回，这里可以绑定this
   conn->setCloseCallback(
-      boost::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
+      boost::bind(&TcpServer::removeConnection, this, registry, _1));
 
-  // conn->connectEstablished();
-  ioLoop->runInLoop(boost::bind(&TcpConnection::connectEstablished, conn));
-  LOG_TRACE << "[5] usecount=" << conn.use_count();
+  ioLoop->runInLoop(boost::bind(&TcpServer::addConnection, registry, conn));
 }
 
-void TcpServer::removeConnection(const TcpConnectionPtr &conn) {
-  /*loop_->assertInLoopThread();
-  LOG_INFO << "TcpServer::removeConnectionInLoop [" << name_
-       << "] - connection " << conn->name();
-
+// 依次检查accept速率、总连接数、同一对端的连接数，通过时计入连接数。
+// 过载时拒绝的连接可能很多，只计数，不逐个打WARN日志
+// 先查总数和单IP的上限，最后才取令牌：被上限拒绝的连接不消耗令牌，
+// 一个IP超限不会压低别人的准入速率。
+// 只在loop_中调用，计数在检查之后只会被releaseAdmission()减少
+bool TcpServer::admit(const InetAddress &peerAddr) {
+  if (maxConnections_ > 0 && connectionCount_.load() >= maxConnections_) {
+    ++rejectedByLimit_;
+    LOG_DEBUG << "TcpServer::admit [" << name_ << "] - " << maxConnections_
+              << " connections reached, " << peerAddr.toIpPort() << " reset";
+    return false;
+  }
+  bool perIp = maxConnectionsPerIp_ > 0 && peerAddr.family() == AF_INET;
+  if (perIp) {
+    MutexLockGuard lock(peerMutex_);
+    std::unordered_map<uint32_t, int>::const_iterator it =
+        connectionsPerIp_.find(peerAddr.ipNetEndian());
+    if (it != connectionsPerIp_.end() && it->second >= maxConnectionsPerIp_) {
+      ++rejectedByPeer_;
+      LOG_DEBUG << "TcpServer::admit [" << name_ << "] - "
+                << maxConnectionsPerIp_ << " connections from "
+                << peerAddr.toIp() << ", reset";
+      return false;
+    }
+  }
+  if (maxAcceptRate_ > 0 && !takeAcceptToken()) {
+    ++rejectedByRate_;
+    LOG_DEBUG << "TcpServer::admit [" << name_ << "] - accept rate exceeded, "
+              << peerAddr.toIpPort() << " reset";
+    return false;
+  }
+  if (perIp) {
+    MutexLockGuard lock(peerMutex_);
+    ++connectionsPerIp_[peerAddr.ipNetEndian()];
+  }
 
-  LOG_TRACE << "[8] usecount=" << conn.use_count();
-  size_t n = connections_.erase(conn->name());
-  LOG_TRACE << "[9] usecount=" << conn.use_count();
+  int64_t connections = ++connectionCount_;
+  if (overloadPolicy_ == kPauseAccepting && maxConnections_ > 0 &&
+      connections >= maxConnections_) {
+    pauseForLimit();
+  }
+  return true;
+}
 
-  (void)n;
-  assert(n == 1);
+// 令牌桶。kPauseAccepting时在令牌用完之后暂停accept，等到有下一个令牌
+bool TcpServer::takeAcceptToken() {
+  Timestamp now(Timestamp::now());
+  acceptTokens_ = std::min(acceptBurst_,
+                           acceptTokens_ +
+                               timeDifference(now, lastRefill_) * maxAcceptRate_);
+  lastRefill_ = now;
+  if (acceptTokens_ < 1) {
+    return false;
+  }
+  acceptTokens_ -= 1;
+  if (overloadPolicy_ == kPauseAccepting && acceptTokens_ < 1 &&
+      !pausedForRate_) {
+    pausedForRate_ = true;
+    ++acceptPauses_;
+    acceptor_->pause();
+    resumeTimer_ =
+        loop_->runAfter((1 - acceptTokens_) / maxAcceptRate_,
+                        boost::bind(&TcpServer::resumeAfterRate, this));
+  }
+  return true;
+}
 
-  loop_->queueInLoop(
-  boost::bind(&TcpConnection::connectDestroyed, conn));
-  LOG_TRACE << "[10] usecount=" << conn.use_count();
-  */
+void TcpServer::resumeAfterRate() {
+  loop_->assertInLoopThread();
+  pausedForRate_ = false;
+  if (!pausedForLimit_) {
+    acceptor_->resume();
+  }
+}
 
-  // FIXME: unsafe
-  loop_->runInLoop(boost::bind(&TcpServer::removeConnectionInLoop, this, conn));
+void TcpServer::pauseForLimit() {
+  if (pausedForLimit_) {
+    return;
+  }
+  pausedForLimit_ = true;
+  ++acceptPauses_;
+  acceptor_->pause();
+  LOG_WARN << "TcpServer::pauseForLimit [" << name_ << "] - "
+           << maxConnections_ << " connections reached, accepting paused";
+  // 与releaseAdmission()配对：先置标志再读连接数，两边至少有一方看到对方
+  acceptPaused_.store(true);
+  if (connectionCount_.load() < maxConnections_) {
+    resumeAfterLimit();
+  }
 }
 
-void TcpServer::removeConnectionInLoop(const TcpConnectionPtr &conn) {
+void TcpServer::resumeAfterLimit() {
   loop_->assertInLoopThread();
-  LOG_INFO << "TcpServer::removeConnectionInLoop [" << name_
-           << "] - connection " << conn->name();
+  if (!pausedForLimit_ || connectionCount_.load() >= maxConnections_) {
+    return;
+  }
+  pausedForLimit_ = false;
+  acceptPaused_.store(false);
+  if (!pausedForRate_) {
+    acceptor_->resume();
+  }
+  LOG_INFO << "TcpServer::resumeAfterLimit [" << name_
+           << "] - accepting resumed";
+}
 
-  LOG_TRACE << "[8] usecount=" << conn.use_count();
-  size_t n = connections_.erase(conn->name());
-  LOG_TRACE << "[9] usecount=" << conn.use_count();
+// IO线程中调用
+void TcpServer::releaseAdmission(const TcpConnectionPtr &conn) {
+  if (maxConnectionsPerIp_ > 0 && conn->peerAddress().family() == AF_INET) {
+    MutexLockGuard lock(peerMutex_);
+    std::unordered_map<uint32_t, int>::iterator it =
+        connectionsPerIp_.find(conn->peerAddress().ipNetEndian());
+    assert(it != connectionsPerIp_.end());
+    if (--it->second == 0) {
+      connectionsPerIp_.erase(it);
+    }
+  }
+  --connectionCount_;
+  if (acceptPaused_.load()) {
+    loop_->runInLoop(boost::bind(&TcpServer::resumeAfterLimitIfAlive,
+                                 boost::weak_ptr<TcpServer *>(self_)));
+  }
+}
 
+void TcpServer::resumeAfterLimitIfAlive(
+    const boost::weak_ptr<TcpServer *> &self) {
+  boost::shared_ptr<TcpServer *> server(self.lock());
+  if (server) {
+    (*server)->resumeAfterLimit();
+  }
+}
+
+void TcpServer::addConnection(LoopConnections *registry,
+                              const TcpConnectionPtr &conn) {
+  registry->loop->assertInLoopThread();
+  registry->connections[conn->id()] = conn;
+  conn->connectEstablished();
+}
+
+void TcpServer::removeConnection(LoopConnections *registry,
+                                 const TcpConnectionPtr &conn) {
+  registry->loop->assertInLoopThread();
+  LOG_INFO << "TcpServer::removeConnection - connection #" << conn->id();
+
+  size_t n = registry->connections.erase(conn->id());
   (void)n;
   assert(n == 1);
+  releaseAdmission(conn);
 
-  EventLoop *ioLoop = conn->getLoop();
-  ioLoop->queueInLoop(boost::bind(&TcpConnection::connectDestroyed, conn));
+  // 正在handleClose()中，Channel要等这一轮事件处理完再移除
+  registry->loop->queueInLoop(
+      boost::bind(&TcpConnection::connectDestroyed, conn));
+}
 
-  // loop_->queueInLoop(
-  //    boost::bind(&TcpConnection::connectDestroyed, conn));
-  LOG_TRACE << "[10] usecount=" << conn.use_count();
-}
\ No newline at end of file
+void TcpServer::destroyConnections(LoopConnections *registry,
+                                   CountDownLatch *latch) {
+  registry->loop->assertInLoopThread();
+  ConnectionMap connections;
+  connections.swap(registry->connections);
+  for (ConnectionMap::iterator it = connections.begin();
+       it != connections.end(); ++it) {
+    it->second->connectDestroyed();
+  }
+  if (latch) {
+    latch->countDown();
+  }
+}
@@ -11,14 +11,24 @@
 #ifndef MUDUO_NET_TCPSERVER_H
 #define MUDUO_NET_TCPSERVER_H
 
+#include "EventLoopMetrics.h"
+#include "Mutex.h"
 #include "TcpConnection.h"
+#include "TimerId.h"
 #include "Types.h"
 
 #include <boost/noncopyable.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/scoped_ptr.hpp>
-#include <map>
+#include <boost/weak_ptr.hpp>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 
 namespace muduo {
+
+class CountDownLatch;
+
 namespace net {
 
 class Acceptor;
@@ -33,6 +43,21 @@ class TcpServer : boost::noncopyable {
 public:
   typedef boost::function<void(EventLoop *)> ThreadInitCallback;
 
+  /// 连接数或accept速率达到上限时的处理方式
+  enum OverloadPolicy {
+    kPauseAccepting, // 暂停accept，新连接留在内核的backlog里，默认
+    kResetConnection // 照常accept，然后立即RST
+  };
+
+  /// 准入控制的统计，见admissionStats()
+  struct AdmissionStats {
+    int64_t connections;     // 当前连接数
+    int64_t rejectedByLimit; // 以下是因各项限制被RST的连接数
+    int64_t rejectedByPeer;
+    int64_t rejectedByRate;
+    int64_t acceptPauses; // 暂停accept的次数
+  };
+
   // TcpServer(EventLoop* loop, const InetAddress& listenAddr);
   TcpServer(EventLoop *loop, const InetAddress &listenAddr,
             const string &nameArg);
@@ -62,6 +87,30 @@ public:
   /// Thread safe.
   void start();
 
+  /// Runtime statistics of each I/O loop, see EventLoop::metrics().
+  /// Thread safe after start().
+  std::vector<EventLoopMetrics> loopMetrics() const;
+
+  /// 准入控制，0表示不限制（默认）。Must be called before @c start
+  /// 总连接数的上限
+  void setMaxConnections(int n) {
+    assert(!started_);
+    maxConnections_ = n;
+  }
+  /// 同一对端IPv4地址的连接数上限，超过的总是RST
+  void setMaxConnectionsPerIp(int n) {
+    assert(!started_);
+    maxConnectionsPerIp_ = n;
+  }
+  /// 每秒accept的连接数，允许burst个的突发，burst为0时取一秒的量
+  void setMaxAcceptRate(double perSecond, int burst = 0);
+  void setOverloadPolicy(OverloadPolicy policy) { overloadPolicy_ = policy; }
+
+  /// Thread safe.
+  int64_t connectionCount() const { return connectionCount_.load(); }
+  /// Thread safe.
+  AdmissionStats admissionStats() const;
+
   /// Set connection callback.
   /// Not thread safe.
   // 设置连接到来或者连接关闭回调函数
@@ -81,14 +130,33 @@ public:
   }
 
 private:
+  typedef std::unordered_map<int64_t, TcpConnectionPtr> ConnectionMap;
+
+  // 每个IO loop一份连接表，只在这个loop线程中访问。
+  // 连接的建立只需一次跨线程调用，关闭完全在IO线程中完成
+  struct LoopConnections {
+    explicit LoopConnections(EventLoop *l) : loop(l) {}
+
+    EventLoop *loop;
+    ConnectionMap connections;
+  };
+
   /// Not thread safe, but in loop
   void newConnection(int sockfd, const InetAddress &peerAddr);
-  /// Thread safe.
-  void removeConnection(const TcpConnectionPtr &conn);
-  /// Not thread safe, but in loop
-  void removeConnectionInLoop(const TcpConnectionPtr &conn);
-
-  typedef std::map<string, TcpConnectionPtr> ConnectionMap;
+  bool admit(const InetAddress &peerAddr);
+  bool takeAcceptToken();
+  void pauseForLimit();
+  void resumeAfterLimit();
+  static void resumeAfterLimitIfAlive(const boost::weak_ptr<TcpServer *> &self);
+  void resumeAfterRate();
+  /// 以下在连接所属的IO线程中调用
+  static void addConnection(LoopConnections *registry,
+                            const TcpConnectionPtr &conn);
+  void removeConnection(LoopConnections *registry,
+                        const TcpConnectionPtr &conn);
+  static void destroyConnections(LoopConnections *registry,
+                                 CountDownLatch *latch);
+  void releaseAdmission(const TcpConnectionPtr &conn);
 
   EventLoop *loop_;                      // the acceptor loop
   const string hostport_;                // 服务端口
@@ -102,9 +170,37 @@ private:
   // IO线程池中的线程在进入事件循环前，会回调用此函数
   ThreadInitCallback threadInitCallback_;
   bool started_;
+  // 连接名的前缀"name:hostport#"，连接只保存引用
+  boost::shared_ptr<const string> connNamePrefix_;
+  // start()之后不再改变，每个IO loop一项
+  boost::ptr_vector<LoopConnections> registries_;
   // always in loop thread
-  int nextConnId_;            // 下一个连接ID
-  ConnectionMap connections_; // 连接列表
+  int64_t nextConnId_; // 下一个连接ID
+  size_t nextLoop_;    // 轮叫，下一个连接交给registries_[nextLoop_]
+
+  // 准入控制，以下参数start()之后不再改变
+  int maxConnections_;
+  int maxConnectionsPerIp_;
+  double maxAcceptRate_;
+  double acceptBurst_;
+  OverloadPolicy overloadPolicy_;
+  // 令牌桶和暂停状态，always in loop thread
+  double acceptTokens_;
+  Timestamp lastRefill_;
+  bool pausedForLimit_;
+  bool pausedForRate_;
+  TimerId resumeTimer_;
+  // 连接在IO线程中关闭，以下跨线程访问
+  std::atomic<int64_t> connectionCount_;
+  std::atomic<bool> acceptPaused_; // pausedForLimit_，IO线程据此唤醒base loop
+  MutexLock peerMutex_; // 保护connectionsPerIp_
+  std::unordered_map<uint32_t, int> connectionsPerIp_; // 网络字节序的IP
+  std::atomic<int64_t> rejectedByLimit_;
+  std::atomic<int64_t> rejectedByPeer_;
+  std::atomic<int64_t> rejectedByRate_;
+  std::atomic<int64_t> acceptPauses_;
+  // IO线程排进base loop的函数可能在析构之后才执行，用它判断server是否还在
+  boost::shared_ptr<TcpServer *> self_;
 };
 
 } // namespace net
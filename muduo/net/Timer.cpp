@@ -12,7 +12,7 @@ using namespace muduo;
 using namespace muduo::net;
 
 //默认初始化为0
-AtomicInt64 Timer::s_numCreated_;
+CacheLinePadded<AtomicInt64> Timer::s_numCreated_;
 
 /**
  * 如果是重复的累加的，加入累加的时间重新设置到期时间，否则设置为失效时间
@@ -26,7 +26,8 @@ class Timer : boost::noncopyable {
 public:
   Timer(const TimerCallback &cb, Timestamp when, double interval)
       : callback_(cb), expiration_(when), interval_(interval),
-        repeat_(interval > 0.0), sequence_(s_numCreated_.incrementAndGet()) {}
+        repeat_(interval > 0.0), sequence_(
+            s_numCreated_.value.incrementAndGet(std::memory_order_relaxed)) {}
 
   void run() const { callback_(); }
 
@@ -39,7 +40,7 @@ public:
 
   void restart(Timestamp now);
 
-  static int64_t numCreated() { return s_numCreated_.get(); }
+  static int64_t numCreated() { return s_numCreated_.value.get(); }
 
 private:
   const TimerCallback callback_; // 定时器回调函数
@@ -48,7 +49,9 @@ private:
   const bool repeat_;      // 是否重复
   const int64_t sequence_; // 定时器序号
 
-  static AtomicInt64 s_numCreated_; // 定时器计数，当前已经创建的定时器数量
+  // 定时器计数，当前已经创建的定时器数量。
+  // 各IO线程都会创建定时器，单独占一个cache line；序号只要求唯一，用relaxed即可
+  static CacheLinePadded<AtomicInt64> s_numCreated_;
 };
 } // namespace net
 } // namespace muduo
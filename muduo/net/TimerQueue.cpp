@@ -196,6 +196,8 @@ void TimerQueue::handleRead() {
 
   // 不是一次性定时器，需要重启
   reset(expired, now);
+  loop_->recordTimerTime(Timestamp::now().microSecondsSinceEpoch() -
+                         now.microSecondsSinceEpoch());
 }
 
 /**
@@ -0,0 +1,73 @@
+#include "UdpServer.h"
+
+#include "CountDownLatch.h"
+#include "EventLoop.h"
+#include "EventLoopThreadPool.h"
+#include "Logging.h"
+
+#include <boost/bind.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+UdpServer::UdpServer(EventLoop *loop, const InetAddress &listenAddr,
+                     const string &nameArg)
+    : loop_(CHECK_NOTNULL(loop)), listenAddr_(listenAddr), name_(nameArg),
+      threadPool_(new EventLoopThreadPool(loop)),
+      maxDatagramSize_(UdpSocket::kDefaultMaxDatagramSize), started_(false) {}
+
+UdpServer::~UdpServer() {
+  // 套接字要在自己的loop里析构
+  for (size_t i = 0; i < sockets_.size(); ++i) {
+    EventLoop *ioLoop = sockets_[i]->getLoop();
+    if (ioLoop->isInLoopThread()) {
+      destroySocket(&sockets_[i]);
+    } else {
+      CountDownLatch latch(1);
+      ioLoop->runInLoop(boost::bind(&UdpServer::destroySocket, &sockets_[i]));
+      ioLoop->runInLoop(boost::bind(&CountDownLatch::countDown, &latch));
+      latch.wait();
+    }
+  }
+}
+
+void UdpServer::setThreadNum(int numThreads) {
+  assert(!started_);
+  assert(0 <= numThreads);
+  threadPool_->setThreadNum(numThreads);
+}
+
+void UdpServer::start() {
+  assert(!started_);
+  loop_->assertInLoopThread();
+  started_ = true;
+  threadPool_->start();
+
+  std::vector<EventLoop *> loops = threadPool_->getAllLoops();
+  sockets_.resize(loops.size());
+  for (size_t i = 0; i < loops.size(); ++i) {
+    if (loops[i]->isInLoopThread()) {
+      createSocket(loops[i], &sockets_[i]);
+    } else {
+      CountDownLatch latch(1);
+      loops[i]->runInLoop(
+          boost::bind(&UdpServer::createSocket, this, loops[i], &sockets_[i]));
+      loops[i]->runInLoop(boost::bind(&CountDownLatch::countDown, &latch));
+      latch.wait();
+    }
+  }
+  LOG_INFO << "UdpServer [" << name_ << "] listening on "
+           << listenAddr_.toIpPort() << " with " << sockets_.size()
+           << " sockets";
+}
+
+void UdpServer::createSocket(EventLoop *ioLoop, UdpSocketPtr *socket) {
+  ioLoop->assertInLoopThread();
+  socket->reset(new UdpSocket(ioLoop, listenAddr_.family(), maxDatagramSize_));
+  (*socket)->setReusePort(true);
+  (*socket)->bindAddress(listenAddr_);
+  (*socket)->setMessageCallback(messageCallback_);
+  (*socket)->startReading();
+}
+
+void UdpServer::destroySocket(UdpSocketPtr *socket) { socket->reset(); }
@@ -0,0 +1,66 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPSERVER_H
+#define MUDUO_NET_UDPSERVER_H
+
+#include "InetAddress.h"
+#include "Types.h"
+#include "UdpSocket.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <vector>
+
+namespace muduo {
+namespace net {
+
+class EventLoop;
+class EventLoopThreadPool;
+
+///
+/// UDP服务器。每个IO线程（没有IO线程时是baseLoop）各有一个绑定在同一
+/// 地址上的SO_REUSEPORT套接字，内核按四元组哈希把数据报分给它们，
+/// 同一个对端的数据报总是由同一个线程处理，不需要跨线程转发。
+///
+/// 回调在收到数据报的IO线程中执行，应答用回调参数里的UdpSocket发送。
+///
+class UdpServer : boost::noncopyable {
+public:
+  UdpServer(EventLoop *loop, const InetAddress &listenAddr,
+            const string &nameArg);
+  ~UdpServer(); // force out-line dtor, for scoped_ptr members.
+
+  const string &name() const { return name_; }
+
+  /// 以下几个必须在start()之前调用
+  void setThreadNum(int numThreads);
+  void setMessageCallback(const UdpMessageCallback &cb) {
+    messageCallback_ = cb;
+  }
+  void setMaxDatagramSize(size_t size) { maxDatagramSize_ = size; }
+
+  /// 在baseLoop线程中调用，返回时所有套接字都已绑定
+  void start();
+
+  /// start()之后不再改变，每个IO线程一个
+  const std::vector<UdpSocketPtr> &sockets() const { return sockets_; }
+
+private:
+  void createSocket(EventLoop *ioLoop, UdpSocketPtr *socket);
+  static void destroySocket(UdpSocketPtr *socket);
+
+  EventLoop *loop_;
+  const InetAddress listenAddr_;
+  const string name_;
+  boost::scoped_ptr<EventLoopThreadPool> threadPool_;
+  UdpMessageCallback messageCallback_;
+  size_t maxDatagramSize_;
+  bool started_;
+  std::vector<UdpSocketPtr> sockets_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_UDPSERVER_H
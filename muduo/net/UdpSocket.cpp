@@ -0,0 +1,314 @@
+#include "UdpSocket.h"
+
+#include "Channel.h"
+#include "EventLoop.h"
+#include "Logging.h"
+#include "Socket.h"
+#include "SocketsOps.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+#include <strings.h> // bzero
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int UdpSocket::kBatchSize;
+const size_t UdpSocket::kDefaultMaxDatagramSize;
+
+namespace {
+
+// 每次可读事件最多recvmmsg()几次，不饿死其他fd
+const int kMaxReadRounds = 8;
+const size_t kMaxGsoSegments = 64; // 较老的内核每条消息最多64段
+const size_t kMaxGsoBytes = 65507; // IPv4下UDP载荷的上限
+
+// CMSG_*宏里有C风格的转换
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+const size_t kControlSize = CMSG_SPACE(sizeof(uint16_t));
+
+void setSegmentSize(struct msghdr *msg, char *control, uint16_t segmentSize) {
+  msg->msg_control = control;
+  msg->msg_controllen = kControlSize;
+  struct cmsghdr *cm = CMSG_FIRSTHDR(msg);
+  cm->cmsg_level = SOL_UDP;
+  cm->cmsg_type = UDP_SEGMENT;
+  cm->cmsg_len = CMSG_LEN(sizeof segmentSize);
+  memcpy(CMSG_DATA(cm), &segmentSize, sizeof segmentSize);
+}
+#pragma GCC diagnostic error "-Wold-style-cast"
+
+} // namespace
+
+UdpSocket::UdpSocket(EventLoop *loop, sa_family_t family,
+                     size_t maxDatagramSize)
+    : loop_(CHECK_NOTNULL(loop)), maxDatagramSize_(maxDatagramSize),
+      socket_(new Socket(sockets::createUdpNonblockingOrDie(family))),
+      channel_(new Channel(loop, socket_->fd())), channelAdded_(false),
+      connected_(false), gso_(family == AF_INET), flushQueued_(false),
+      maxPendingPackets_(64 * 1024), recvBuffer_(kBatchSize * maxDatagramSize),
+      recvAddrs_(kBatchSize), recvIovecs_(kBatchSize), recvMsgs_(kBatchSize),
+      packets_(kBatchSize), sendHead_(0), sendIovecs_(kBatchSize),
+      sendMsgs_(kBatchSize), sendControl_(kBatchSize * kControlSize),
+      packetsReceived_(0), packetsSent_(0), packetsDropped_(0),
+      packetsTruncated_(0) {
+  assert(maxDatagramSize_ > 0);
+  channel_->setReadCallback(boost::bind(&UdpSocket::handleRead, this, _1));
+  channel_->setWriteCallback(boost::bind(&UdpSocket::handleWrite, this));
+  channel_->setErrorCallback(boost::bind(&UdpSocket::handleError, this));
+  for (int i = 0; i < kBatchSize; ++i) {
+    recvIovecs_[i].iov_base = &recvBuffer_[i * maxDatagramSize_];
+    recvIovecs_[i].iov_len = maxDatagramSize_;
+    struct msghdr &hdr = recvMsgs_[i].msg_hdr;
+    hdr.msg_name = &recvAddrs_[i];
+    hdr.msg_iov = &recvIovecs_[i];
+    hdr.msg_iovlen = 1;
+    packets_[i].peer = &recvAddrs_[i];
+  }
+}
+
+UdpSocket::~UdpSocket() {
+  if (channelAdded_) {
+    loop_->assertInLoopThread();
+    channel_->disableAll();
+    channel_->remove();
+  }
+}
+
+int UdpSocket::fd() const { return socket_->fd(); }
+
+InetAddress UdpSocket::localAddress() const {
+  return InetAddress(sockets::getLocalAddr(socket_->fd()));
+}
+
+void UdpSocket::setReusePort(bool on) { socket_->setReusePort(on); }
+
+void UdpSocket::bindAddress(const InetAddress &addr) {
+  socket_->bindAddress(addr);
+}
+
+bool UdpSocket::connect(const InetAddress &peer) {
+  if (sockets::connect(socket_->fd(), peer.getSockAddr(), peer.sockAddrLen()) <
+      0) {
+    LOG_SYSERR << "UdpSocket::connect " << peer.toIpPort();
+    return false;
+  }
+  connected_ = true;
+  return true;
+}
+
+void UdpSocket::startReading() {
+  loop_->assertInLoopThread();
+  channel_->tie(shared_from_this());
+  channelAdded_ = true;
+  channel_->enableReading();
+}
+
+void UdpSocket::handleRead(Timestamp receiveTime) {
+  loop_->assertInLoopThread();
+  UdpSocketPtr guardThis(shared_from_this());
+  for (int round = 0; round < kMaxReadRounds; ++round) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      recvMsgs_[i].msg_hdr.msg_namelen = sizeof recvAddrs_[i];
+      recvMsgs_[i].msg_hdr.msg_flags = 0;
+    }
+    int n = ::recvmmsg(socket_->fd(), &recvMsgs_[0], kBatchSize, 0, NULL);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        LOG_SYSERR << "UdpSocket::handleRead";
+      }
+      break;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      UdpPacket &packet = packets_[i];
+      packet.data =
+          StringPiece(static_cast<const char *>(recvIovecs_[i].iov_base),
+                      static_cast<int>(recvMsgs_[i].msg_len));
+      packet.truncated = (recvMsgs_[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+      if (packet.truncated) {
+        ++packetsTruncated_;
+      }
+    }
+    packetsReceived_ += n;
+    if (messageCallback_) {
+      messageCallback_(guardThis, &packets_[0], n, receiveTime);
+    }
+    if (n < kBatchSize) {
+      break;
+    }
+  }
+  // 回调里的应答一起发出
+  flush();
+}
+
+void UdpSocket::handleWrite() {
+  loop_->assertInLoopThread();
+  flush();
+}
+
+// 对端不可达等ICMP错误，读出SO_ERROR以免POLLERR一直触发
+void UdpSocket::handleError() {
+  int err = sockets::getSocketError(socket_->fd());
+  LOG_ERROR << "UdpSocket::handleError - SO_ERROR = " << err << " "
+            << strerror_tl(err);
+}
+
+void UdpSocket::send(const InetAddress &peer, const StringPiece &data) {
+  if (loop_->isInLoopThread()) {
+    sendInLoop(&peer, data);
+  } else {
+    loop_->runInLoop(boost::bind(&UdpSocket::sendToInLoop, shared_from_this(),
+                                 peer, data.as_string()));
+  }
+}
+
+void UdpSocket::send(const StringPiece &data) {
+  if (loop_->isInLoopThread()) {
+    sendInLoop(NULL, data);
+  } else {
+    loop_->runInLoop(boost::bind(&UdpSocket::sendConnectedInLoop,
+                                 shared_from_this(), data.as_string()));
+  }
+}
+
+void UdpSocket::sendToInLoop(const InetAddress &peer, const string &data) {
+  sendInLoop(&peer, data);
+}
+
+void UdpSocket::sendConnectedInLoop(const string &data) {
+  sendInLoop(NULL, data);
+}
+
+void UdpSocket::sendInLoop(const InetAddress *peer, const StringPiece &data) {
+  loop_->assertInLoopThread();
+  assert(peer != NULL || connected_);
+  if (pending_.size() - sendHead_ >= maxPendingPackets_) {
+    ++packetsDropped_;
+    return;
+  }
+
+  pending_.push_back(PendingPacket());
+  PendingPacket &packet = pending_.back();
+  packet.offset = sendBuffer_.readableBytes();
+  packet.len = data.size();
+  packet.peerLen = 0;
+  if (peer != NULL) {
+    packet.peerLen = peer->sockAddrLen();
+    memcpy(&packet.peer, peer->getSockAddr(), packet.peerLen);
+  }
+  sendBuffer_.append(data.data(), data.size());
+
+  // 等POLLOUT时由handleWrite()发送
+  if (!flushQueued_ && !channel_->isWriting()) {
+    flushQueued_ = true;
+    loop_->queueInLoop(boost::bind(&UdpSocket::flush, shared_from_this()));
+  }
+}
+
+bool UdpSocket::samePeer(const PendingPacket &a,
+                         const PendingPacket &b) const {
+  return a.peerLen == b.peerLen && memcmp(&a.peer, &b.peer, a.peerLen) == 0;
+}
+
+// 同一对端、同样长度的连续数据报，只有最后一个可以更短。
+// 它们在sendBuffer_中本来就是连续的
+size_t UdpSocket::coalesce(size_t first, size_t *segmentSize) const {
+  const PendingPacket &head = pending_[first];
+  *segmentSize = head.len;
+  size_t n = 1;
+  size_t total = head.len;
+  while (head.len > 0 && first + n < pending_.size() && n < kMaxGsoSegments) {
+    const PendingPacket &next = pending_[first + n];
+    if (next.len == 0 || next.len > head.len ||
+        total + next.len > kMaxGsoBytes || !samePeer(head, next)) {
+      break;
+    }
+    total += next.len;
+    ++n;
+    if (next.len < head.len) {
+      break;
+    }
+  }
+  return n;
+}
+
+void UdpSocket::flush() {
+  loop_->assertInLoopThread();
+  flushQueued_ = false;
+  while (sendHead_ < pending_.size()) {
+    size_t packetsInMsg[kBatchSize];
+    int count = 0;
+    size_t next = sendHead_;
+    while (count < kBatchSize && next < pending_.size()) {
+      size_t segmentSize = 0;
+      size_t n = gso_ ? coalesce(next, &segmentSize) : 1;
+      PendingPacket &head = pending_[next];
+      const PendingPacket &last = pending_[next + n - 1];
+
+      struct iovec &iov = sendIovecs_[count];
+      iov.iov_base = const_cast<char *>(sendBuffer_.peek()) + head.offset;
+      iov.iov_len = last.offset + last.len - head.offset;
+      struct msghdr &hdr = sendMsgs_[count].msg_hdr;
+      bzero(&hdr, sizeof hdr);
+      hdr.msg_name = head.peerLen > 0 ? &head.peer : NULL;
+      hdr.msg_namelen = head.peerLen;
+      hdr.msg_iov = &iov;
+      hdr.msg_iovlen = 1;
+      if (n > 1) {
+        setSegmentSize(&hdr, &sendControl_[count * kControlSize],
+                       static_cast<uint16_t>(segmentSize));
+      }
+      packetsInMsg[count++] = n;
+      next += n;
+    }
+
+    int sent = ::sendmmsg(socket_->fd(), &sendMsgs_[0], count, 0);
+    if (sent < 0) {
+      int savedErrno = errno;
+      if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+        channelAdded_ = true;
+        channel_->enableWriting();
+        return;
+      } else if (savedErrno == EINTR) {
+        continue;
+      } else if (packetsInMsg[0] > 1 &&
+                 (savedErrno == EIO || savedErrno == EINVAL ||
+                  savedErrno == ENOPROTOOPT || savedErrno == EOPNOTSUPP)) {
+        // 内核或网卡不支持UDP GSO，以后逐个发送
+        LOG_WARN << "UdpSocket::flush - UDP GSO unavailable, disabled";
+        gso_ = false;
+        continue;
+      }
+      // 只丢弃出错的这一条，其余的继续发
+      errno = savedErrno;
+      LOG_SYSERR << "UdpSocket::flush";
+      packetsDropped_ += packetsInMsg[0];
+      sendHead_ += packetsInMsg[0];
+      continue;
+    }
+    for (int i = 0; i < sent; ++i) {
+      packetsSent_ += packetsInMsg[i];
+      sendHead_ += packetsInMsg[i];
+    }
+  }
+
+  pending_.clear();
+  sendHead_ = 0;
+  sendBuffer_.retrieveAll();
+  if (channel_->isWriting()) {
+    channel_->disableWriting();
+  }
+}
@@ -0,0 +1,154 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_UDPSOCKET_H
+#define MUDUO_NET_UDPSOCKET_H
+
+#include "Buffer.h"
+#include "InetAddress.h"
+#include "StringPiece.h"
+#include "Timestamp.h"
+
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <sys/socket.h>
+#include <vector>
+
+namespace muduo {
+namespace net {
+
+class Channel;
+class EventLoop;
+class Socket;
+class UdpSocket;
+
+/// 收到的一个数据报。data指向UdpSocket内部的缓冲区，只在回调期间有效
+struct UdpPacket {
+  StringPiece data;
+  const struct sockaddr_storage *peer;
+  bool truncated; // 比maxDatagramSize长，多余部分已丢弃
+
+  InetAddress peerAddress() const { return InetAddress(*peer); }
+};
+
+typedef boost::shared_ptr<UdpSocket> UdpSocketPtr;
+// 一次recvmmsg()收到的一批数据报
+typedef boost::function<void(const UdpSocketPtr &, const UdpPacket *packets,
+                             int count, Timestamp)>
+    UdpMessageCallback;
+
+///
+/// 接入EventLoop的非阻塞UDP套接字。
+///
+/// 读：可读时用recvmmsg()一次收kBatchSize个数据报到预先分配的缓冲区，
+/// 整批交给回调，不逐个分配内存。
+///
+/// 写：send()只是把数据报排进发送队列，在本轮事件处理结束时（或本次
+/// 读回调返回后）用sendmmsg()一次发出。发往同一对端、长度相同的连续
+/// 数据报合并成一条带UDP_SEGMENT的消息，由内核（或网卡）分段（GSO）；
+/// 内核不支持时自动退回普通sendmmsg()。内核缓冲区满时等POLLOUT，
+/// 队列超过maxPendingPackets()时丢弃新数据报。
+///
+/// 必须由shared_ptr持有，在所属loop线程中startReading()和析构。
+/// send()可以跨线程调用。
+///
+class UdpSocket : boost::noncopyable,
+                  public boost::enable_shared_from_this<UdpSocket> {
+public:
+  static const int kBatchSize = 64;
+  static const size_t kDefaultMaxDatagramSize = 2048;
+
+  UdpSocket(EventLoop *loop, sa_family_t family = AF_INET,
+            size_t maxDatagramSize = kDefaultMaxDatagramSize);
+  ~UdpSocket(); // force out-line dtor, for scoped_ptr members.
+
+  EventLoop *getLoop() const { return loop_; }
+  int fd() const;
+  InetAddress localAddress() const;
+
+  /// 以下几个在startReading()之前调用
+  void setReusePort(bool on);
+  void bindAddress(const InetAddress &addr); // abort if address in use
+  /// 指定默认对端，之后可以用send(data)，并只收这个对端的数据报
+  bool connect(const InetAddress &peer);
+  void setMessageCallback(const UdpMessageCallback &cb) {
+    messageCallback_ = cb;
+  }
+  void setMaxPendingPackets(size_t n) { maxPendingPackets_ = n; }
+  size_t maxPendingPackets() const { return maxPendingPackets_; }
+  void setGso(bool on) { gso_ = on; }
+  bool gso() const { return gso_; }
+
+  /// 在loop线程中调用，开始关注可读事件
+  void startReading();
+
+  /// Thread safe.
+  void send(const InetAddress &peer, const StringPiece &data);
+  /// Thread safe. 发往connect()指定的对端
+  void send(const StringPiece &data);
+  /// 在loop线程中调用，立即发出队列里的数据报
+  void flush();
+
+  /// 以下统计只在loop线程中修改
+  int64_t packetsReceived() const { return packetsReceived_; }
+  int64_t packetsSent() const { return packetsSent_; }
+  int64_t packetsDropped() const { return packetsDropped_; }
+  int64_t packetsTruncated() const { return packetsTruncated_; }
+
+private:
+  struct PendingPacket {
+    size_t offset; // 在sendBuffer_中相对peek()的位置
+    size_t len;
+    socklen_t peerLen; // 0表示发往connect()的对端
+    struct sockaddr_storage peer;
+  };
+
+  void handleRead(Timestamp receiveTime);
+  void handleWrite();
+  void handleError();
+  void sendInLoop(const InetAddress *peer, const StringPiece &data);
+  void sendToInLoop(const InetAddress &peer, const string &data);
+  void sendConnectedInLoop(const string &data);
+  // 从pending_[first]开始能合并成一条GSO消息的数据报个数
+  size_t coalesce(size_t first, size_t *segmentSize) const;
+  bool samePeer(const PendingPacket &a, const PendingPacket &b) const;
+
+  EventLoop *loop_;
+  const size_t maxDatagramSize_;
+  boost::scoped_ptr<Socket> socket_;
+  boost::scoped_ptr<Channel> channel_;
+  UdpMessageCallback messageCallback_;
+  bool channelAdded_; // 已经加入Poller，析构时要移除
+  bool connected_;
+  bool gso_;
+  bool flushQueued_;
+  size_t maxPendingPackets_;
+
+  // 接收，分配一次反复使用
+  std::vector<char> recvBuffer_;
+  std::vector<struct sockaddr_storage> recvAddrs_;
+  std::vector<struct iovec> recvIovecs_;
+  std::vector<struct mmsghdr> recvMsgs_;
+  std::vector<UdpPacket> packets_;
+
+  // 发送队列，pending_[sendHead_]之前的已经发出
+  Buffer sendBuffer_;
+  std::vector<PendingPacket> pending_;
+  size_t sendHead_;
+  std::vector<struct iovec> sendIovecs_;
+  std::vector<struct mmsghdr> sendMsgs_;
+  std::vector<char> sendControl_;
+
+  int64_t packetsReceived_;
+  int64_t packetsSent_;
+  int64_t packetsDropped_;
+  int64_t packetsTruncated_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_UDPSOCKET_H
@@ -0,0 +1,166 @@
+#include "HttpContext.h"
+
+#include "Buffer.h"
+#include "CharSearch.h"
+
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace {
+
+const char kHeaderEnd[] = "\r\n\r\n";
+
+StringPiece makePiece(const char *begin, const char *end) {
+  return StringPiece(begin, static_cast<int>(end - begin));
+}
+
+StringPiece trim(const char *begin, const char *end) {
+  while (begin < end && (*begin == ' ' || *begin == '\t')) {
+    ++begin;
+  }
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) {
+    --end;
+  }
+  return makePiece(begin, end);
+}
+
+// 只接受不超过kMaxBodySize的十进制数
+bool parseContentLength(const StringPiece &value, size_t *length) {
+  if (value.empty() || value.size() > 9) {
+    return false;
+  }
+  size_t n = 0;
+  for (int i = 0; i < value.size(); ++i) {
+    if (value[i] < '0' || value[i] > '9') {
+      return false;
+    }
+    n = n * 10 + (value[i] - '0');
+  }
+  *length = n;
+  return n <= HttpContext::kMaxBodySize;
+}
+
+} // namespace
+
+HttpContext::ParseResult HttpContext::parse(Buffer *buf,
+                                            Timestamp receiveTime) {
+  const char *begin = buf->peek();
+  const char *end = begin + buf->readableBytes();
+
+  if (headerLength_ == 0) {
+    // 上次扫描的末尾3个字节可能是标记的前半部分
+    const char *start = begin + (scanned_ > 3 ? scanned_ - 3 : 0);
+    const char *found = static_cast<const char *>(
+        ::memmem(start, end - start, kHeaderEnd, 4));
+    if (found == NULL) {
+      scanned_ = end - begin;
+      return scanned_ > kMaxHeaderSize ? kError : kIncomplete;
+    }
+    headerLength_ = found + 4 - begin;
+    if (headerLength_ > kMaxHeaderSize) {
+      return kError;
+    }
+  }
+
+  // body没有到齐时缓冲区可能被搬动，所以每次都重新切分头部，
+  // 只有body跨越多次读取的请求才需要重复切分
+  request_.reset();
+  if (!parseHeader(begin, begin + headerLength_)) {
+    return kError;
+  }
+
+  // 不支持chunked请求体
+  if (!request_.getHeader("Transfer-Encoding").empty()) {
+    return kError;
+  }
+  size_t contentLength = 0;
+  StringPiece value = request_.getHeader("Content-Length");
+  if (!value.empty() && !parseContentLength(value, &contentLength)) {
+    return kError;
+  }
+  if (static_cast<size_t>(end - begin) < headerLength_ + contentLength) {
+    return kIncomplete;
+  }
+
+  request_.body_ = StringPiece(begin + headerLength_,
+                               static_cast<int>(contentLength));
+  request_.receiveTime_ = receiveTime;
+  requestLength_ = headerLength_ + contentLength;
+  return kComplete;
+}
+
+// [begin, end)是完整的头部，以空行结束
+bool HttpContext::parseHeader(const char *begin, const char *end) {
+  const char *crlf = muduo::detail::findCRLF(begin, end);
+  if (crlf == NULL || !parseRequestLine(begin, crlf)) {
+    return false;
+  }
+
+  const char *line = crlf + 2;
+  while ((crlf = muduo::detail::findCRLF(line, end)) != NULL &&
+         crlf != line) {
+    const char *colon =
+        static_cast<const char *>(::memchr(line, ':', crlf - line));
+    if (colon == NULL || colon == line) {
+      return false;
+    }
+    StringPiece name = makePiece(line, colon);
+    for (int i = 0; i < name.size(); ++i) {
+      if (name[i] == ' ' || name[i] == '\t') {
+        return false;
+      }
+    }
+    request_.headers_.push_back(
+        HttpRequest::Header(name, trim(colon + 1, crlf)));
+    line = crlf + 2;
+  }
+  return crlf == line;
+}
+
+bool HttpContext::parseRequestLine(const char *begin, const char *end) {
+  const char *space =
+      static_cast<const char *>(::memchr(begin, ' ', end - begin));
+  if (space == NULL) {
+    return false;
+  }
+  StringPiece method = makePiece(begin, space);
+  if (method == "GET") {
+    request_.method_ = HttpRequest::kGet;
+  } else if (method == "POST") {
+    request_.method_ = HttpRequest::kPost;
+  } else if (method == "HEAD") {
+    request_.method_ = HttpRequest::kHead;
+  } else if (method == "PUT") {
+    request_.method_ = HttpRequest::kPut;
+  } else if (method == "DELETE") {
+    request_.method_ = HttpRequest::kDelete;
+  } else {
+    return false;
+  }
+
+  const char *target = space + 1;
+  space = static_cast<const char *>(::memchr(target, ' ', end - target));
+  if (space == NULL || space == target) {
+    return false;
+  }
+  const char *question =
+      static_cast<const char *>(::memchr(target, '?', space - target));
+  if (question) {
+    request_.path_ = makePiece(target, question);
+    request_.query_ = makePiece(question + 1, space);
+  } else {
+    request_.path_ = makePiece(target, space);
+  }
+
+  StringPiece version = makePiece(space + 1, end);
+  if (version == "HTTP/1.1") {
+    request_.version_ = HttpRequest::kHttp11;
+  } else if (version == "HTTP/1.0") {
+    request_.version_ = HttpRequest::kHttp10;
+  } else {
+    return false;
+  }
+  return true;
+}
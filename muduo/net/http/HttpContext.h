@@ -0,0 +1,60 @@
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_HTTP_HTTPCONTEXT_H
+#define MUDUO_NET_HTTP_HTTPCONTEXT_H
+
+#include "HttpRequest.h"
+#include "copyable.h"
+
+#include <stddef.h>
+
+namespace muduo {
+namespace net {
+
+class Buffer;
+
+///
+/// 每个连接一个，放在TcpConnection的context里，增量解析请求。
+///
+/// parse()每次从buf->peek()开始解析一个请求：
+/// - 头部没有收全时记住已经扫描过的长度，下次从那里继续找"\r\n\r\n"；
+/// - 头部收全后一次性切分出请求行和各个字段，全部是指向buf的StringPiece；
+/// - 有Content-Length时等待整个body到齐。
+/// 完成后调用者处理request()，然后buf->retrieve(requestLength())并reset()，
+/// 缓冲区里剩下的是下一个（流水线）请求。
+///
+class HttpContext : public muduo::copyable {
+public:
+  enum ParseResult { kIncomplete, kComplete, kError };
+
+  static const size_t kMaxHeaderSize = 64 * 1024;
+  static const size_t kMaxBodySize = 16 * 1024 * 1024;
+
+  HttpContext() : scanned_(0), headerLength_(0), requestLength_(0) {}
+
+  ParseResult parse(Buffer *buf, Timestamp receiveTime);
+
+  const HttpRequest &request() const { return request_; }
+  size_t requestLength() const { return requestLength_; }
+
+  void reset() {
+    scanned_ = 0;
+    headerLength_ = 0;
+    requestLength_ = 0;
+    request_.reset();
+  }
+
+private:
+  bool parseHeader(const char *begin, const char *end);
+  bool parseRequestLine(const char *begin, const char *end);
+
+  size_t scanned_;      // 已经确认不含头部结束标记的字节数
+  size_t headerLength_; // 头部（含空行）长度，0表示还没找到
+  size_t requestLength_;
+  HttpRequest request_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_HTTP_HTTPCONTEXT_H
@@ -0,0 +1,49 @@
+#include "HttpRequest.h"
+
+#include <strings.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace {
+
+bool equalsIgnoreCase(const StringPiece &a, const StringPiece &b) {
+  return a.size() == b.size() &&
+         ::strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+} // namespace
+
+const char *HttpRequest::methodString() const {
+  switch (method_) {
+  case kGet:
+    return "GET";
+  case kPost:
+    return "POST";
+  case kHead:
+    return "HEAD";
+  case kPut:
+    return "PUT";
+  case kDelete:
+    return "DELETE";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+StringPiece HttpRequest::getHeader(const StringPiece &field) const {
+  for (size_t i = 0; i < headers_.size(); ++i) {
+    if (equalsIgnoreCase(headers_[i].first, field)) {
+      return headers_[i].second;
+    }
+  }
+  return StringPiece();
+}
+
+bool HttpRequest::keepAlive() const {
+  StringPiece connection = getHeader("Connection");
+  if (version_ == kHttp11) {
+    return !equalsIgnoreCase(connection, "close");
+  }
+  return equalsIgnoreCase(connection, "keep-alive");
+}
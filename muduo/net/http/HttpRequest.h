@@ -0,0 +1,73 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_HTTP_HTTPREQUEST_H
+#define MUDUO_NET_HTTP_HTTPREQUEST_H
+
+#include "StringPiece.h"
+#include "Timestamp.h"
+#include "copyable.h"
+
+#include <utility>
+#include <vector>
+
+namespace muduo {
+namespace net {
+
+///
+/// 解析好的HTTP请求。
+///
+/// 所有StringPiece都直接指向连接的输入缓冲区，不复制，
+/// 只在HttpServer的回调期间有效；需要保留时自行as_string()。
+///
+class HttpRequest : public muduo::copyable {
+public:
+  enum Method { kInvalid, kGet, kPost, kHead, kPut, kDelete };
+  enum Version { kUnknown, kHttp10, kHttp11 };
+  typedef std::pair<StringPiece, StringPiece> Header;
+
+  HttpRequest() : method_(kInvalid), version_(kUnknown) {}
+
+  Method method() const { return method_; }
+  const char *methodString() const;
+  Version version() const { return version_; }
+
+  StringPiece path() const { return path_; }
+  // '?'之后的部分，不含'?'
+  StringPiece query() const { return query_; }
+
+  // 字段名不区分大小写，没有时返回空
+  StringPiece getHeader(const StringPiece &field) const;
+  const std::vector<Header> &headers() const { return headers_; }
+
+  StringPiece body() const { return body_; }
+  Timestamp receiveTime() const { return receiveTime_; }
+
+  // HTTP/1.1默认保持连接，除非Connection: close；HTTP/1.0相反
+  bool keepAlive() const;
+
+private:
+  friend class HttpContext;
+
+  // 清空内容，保留headers_的容量，下一个请求不再分配内存
+  void reset() {
+    method_ = kInvalid;
+    version_ = kUnknown;
+    path_.clear();
+    query_.clear();
+    headers_.clear();
+    body_.clear();
+  }
+
+  Method method_;
+  Version version_;
+  StringPiece path_;
+  StringPiece query_;
+  std::vector<Header> headers_;
+  StringPiece body_;
+  Timestamp receiveTime_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_HTTP_HTTPREQUEST_H
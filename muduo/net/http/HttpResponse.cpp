@@ -0,0 +1,29 @@
+#include "HttpResponse.h"
+
+#include "Buffer.h"
+
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+void HttpResponse::appendToBuffer(Buffer *output, bool headOnly) const {
+  char buf[64];
+  snprintf(buf, sizeof buf, "HTTP/1.1 %d ", statusCode_);
+  output->append(buf);
+  output->append(statusMessage_);
+  output->append("\r\n");
+
+  if (closeConnection_) {
+    output->append("Connection: close\r\n");
+  } else {
+    output->append("Connection: Keep-Alive\r\n");
+  }
+  snprintf(buf, sizeof buf, "Content-Length: %zu\r\n", body_.size());
+  output->append(buf);
+  output->append(headers_);
+  output->append("\r\n");
+  if (!headOnly) {
+    output->append(body_);
+  }
+}
@@ -0,0 +1,72 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_HTTP_HTTPRESPONSE_H
+#define MUDUO_NET_HTTP_HTTPRESPONSE_H
+
+#include "StringPiece.h"
+#include "Types.h"
+#include "copyable.h"
+
+namespace muduo {
+namespace net {
+
+class Buffer;
+
+///
+/// HTTP响应，由HttpServer直接编码进连接的输出缓冲区。
+///
+class HttpResponse : public muduo::copyable {
+public:
+  enum HttpStatusCode {
+    kUnknown,
+    k200Ok = 200,
+    k204NoContent = 204,
+    k301MovedPermanently = 301,
+    k400BadRequest = 400,
+    k404NotFound = 404,
+    k413PayloadTooLarge = 413,
+    k500InternalServerError = 500,
+  };
+
+  explicit HttpResponse(bool close)
+      : statusCode_(kUnknown), closeConnection_(close) {}
+
+  void setStatusCode(HttpStatusCode code) { statusCode_ = code; }
+  void setStatusMessage(const string &message) { statusMessage_ = message; }
+
+  void setCloseConnection(bool on) { closeConnection_ = on; }
+  bool closeConnection() const { return closeConnection_; }
+
+  void setContentType(const StringPiece &contentType) {
+    addHeader("Content-Type", contentType);
+  }
+
+  // 字段直接拼接成一个字符串，不检查重复
+  void addHeader(const StringPiece &field, const StringPiece &value) {
+    headers_.append(field.data(), field.size());
+    headers_.append(": ", 2);
+    headers_.append(value.data(), value.size());
+    headers_.append("\r\n", 2);
+  }
+
+  void setBody(const string &body) { body_ = body; }
+  void setBody(const StringPiece &body) {
+    body_.assign(body.data(), body.size());
+  }
+
+  // 追加状态行、头部和body；headOnly时（HEAD请求）不写body，
+  // Content-Length仍然是body的长度
+  void appendToBuffer(Buffer *output, bool headOnly = false) const;
+
+private:
+  HttpStatusCode statusCode_;
+  string statusMessage_;
+  bool closeConnection_;
+  string headers_;
+  string body_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_HTTP_HTTPRESPONSE_H
@@ -0,0 +1,92 @@
+#include "HttpServer.h"
+
+#include "HttpContext.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "Logging.h"
+
+#include <boost/bind.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace muduo {
+namespace net {
+namespace detail {
+
+void defaultHttpCallback(const HttpRequest &, HttpResponse *resp) {
+  resp->setStatusCode(HttpResponse::k404NotFound);
+  resp->setStatusMessage("Not Found");
+  resp->setCloseConnection(true);
+}
+
+} // namespace detail
+} // namespace net
+} // namespace muduo
+
+HttpServer::HttpServer(EventLoop *loop, const InetAddress &listenAddr,
+                       const string &name)
+    : server_(loop, listenAddr, name),
+      httpCallback_(detail::defaultHttpCallback) {
+  server_.setConnectionCallback(
+      boost::bind(&HttpServer::onConnection, this, _1));
+  server_.setMessageCallback(
+      boost::bind(&HttpServer::onMessage, this, _1, _2, _3));
+}
+
+void HttpServer::start() {
+  LOG_WARN << "HttpServer[" << server_.name() << "] starts listenning on "
+           << server_.hostport();
+  server_.start();
+}
+
+void HttpServer::onConnection(const TcpConnectionPtr &conn) {
+  if (conn->connected()) {
+    conn->setContext(HttpContext());
+  }
+}
+
+void HttpServer::onMessage(const TcpConnectionPtr &conn, Buffer *buf,
+                           Timestamp receiveTime) {
+  // 已经决定关闭连接，之后的请求不再处理
+  if (!conn->connected()) {
+    buf->retrieveAll();
+    return;
+  }
+
+  HttpContext *context =
+      boost::any_cast<HttpContext>(conn->getMutableContext());
+  Buffer *output = conn->outputBuffer();
+  bool close = false;
+  for (;;) {
+    HttpContext::ParseResult result = context->parse(buf, receiveTime);
+    if (result == HttpContext::kIncomplete) {
+      break;
+    }
+    if (result == HttpContext::kError) {
+      output->append("HTTP/1.1 400 Bad Request\r\n"
+                     "Connection: close\r\n"
+                     "Content-Length: 0\r\n\r\n");
+      close = true;
+      break;
+    }
+
+    const HttpRequest &req = context->request();
+    HttpResponse response(!req.keepAlive());
+    httpCallback_(req, &response);
+    response.appendToBuffer(output, req.method() == HttpRequest::kHead);
+    buf->retrieve(context->requestLength());
+    context->reset();
+    if (response.closeConnection()) {
+      close = true;
+      break;
+    }
+  }
+
+  // 这一批请求的响应一次写出
+  conn->flushOutput();
+  if (close) {
+    buf->retrieveAll();
+    conn->shutdown();
+  }
+}
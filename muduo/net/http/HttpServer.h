@@ -0,0 +1,50 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_HTTP_HTTPSERVER_H
+#define MUDUO_NET_HTTP_HTTPSERVER_H
+
+#include "TcpServer.h"
+
+#include <boost/noncopyable.hpp>
+
+namespace muduo {
+namespace net {
+
+class HttpRequest;
+class HttpResponse;
+
+///
+/// 简单的嵌入式HTTP/1.1服务器，用来对外报告程序的状态，
+/// 不是完整的HTTP服务器。
+///
+/// 支持keep-alive和流水线：一次读到的多个请求依次处理，
+/// 响应直接编码进连接的输出缓冲区，处理完这一批后只write()一次。
+///
+class HttpServer : boost::noncopyable {
+public:
+  typedef boost::function<void(const HttpRequest &, HttpResponse *)>
+      HttpCallback;
+
+  HttpServer(EventLoop *loop, const InetAddress &listenAddr,
+             const string &name);
+
+  /// Not thread safe, callback be registered before calling start().
+  void setHttpCallback(const HttpCallback &cb) { httpCallback_ = cb; }
+
+  void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
+
+  void start();
+
+private:
+  void onConnection(const TcpConnectionPtr &conn);
+  void onMessage(const TcpConnectionPtr &conn, Buffer *buf,
+                 Timestamp receiveTime);
+
+  TcpServer server_;
+  HttpCallback httpCallback_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_HTTP_HTTPSERVER_H
@@ -0,0 +1,159 @@
+#include "RpcClient.h"
+
+#include "EventLoop.h"
+#include "Logging.h"
+
+#include <boost/bind.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+RpcClient::RpcClient(EventLoop *loop, const InetAddress &serverAddr,
+                     const string &name)
+    : loop_(loop), client_(loop, serverAddr, name),
+      codec_(boost::bind(&RpcClient::onFrame, this, _1, _2, _3),
+             RpcCodec::kHeaderLen),
+      nextCallId_(1), flushQueued_(false), self_(new RpcClient *(this)) {
+  client_.setConnectionCallback(
+      boost::bind(&RpcClient::onConnection, this, _1));
+  client_.setMessageCallback(
+      boost::bind(&LengthHeaderCodec::onMessage, &codec_, _1, _2, _3));
+}
+
+RpcClient::~RpcClient() {
+  loop_->assertInLoopThread();
+  self_.reset();
+  // 回调里再调用call()会立即以kRpcDisconnected完成
+  connection_.reset();
+  failAll(kRpcDisconnected);
+}
+
+void RpcClient::call(const StringPiece &method, const StringPiece &request,
+                     const RpcCallback &done, double timeout) {
+  if (loop_->isInLoopThread()) {
+    startCall(method, request, done, timeout);
+  } else {
+    loop_->runInLoop(boost::bind(&RpcClient::callInLoop,
+                                 boost::weak_ptr<RpcClient *>(self_),
+                                 method.as_string(), request.as_string(), done,
+                                 timeout));
+  }
+}
+
+void RpcClient::callInLoop(const boost::weak_ptr<RpcClient *> &self,
+                           const string &method, const string &request,
+                           const RpcCallback &done, double timeout) {
+  boost::shared_ptr<RpcClient *> client(self.lock());
+  if (client) {
+    (*client)->startCall(method, request, done, timeout);
+  } else {
+    done(kRpcDisconnected, StringPiece());
+  }
+}
+
+// 在IO线程里直接编码进输出缓冲区，不复制request
+void RpcClient::startCall(const StringPiece &method,
+                          const StringPiece &request, const RpcCallback &done,
+                          double timeout) {
+  loop_->assertInLoopThread();
+  if (!connected()) {
+    done(kRpcDisconnected, StringPiece());
+    return;
+  }
+
+  uint64_t callId = nextCallId_++;
+  Call &call = calls_[callId];
+  call.done = done;
+  call.hasTimer = timeout > 0;
+  if (call.hasTimer) {
+    call.timer = loop_->runAfter(
+        timeout, boost::bind(&RpcClient::onTimeout, this, callId));
+  }
+
+  RpcCodec::encodeRequest(connection_->outputBuffer(), callId, method,
+                          request);
+  // 同一轮里的调用合并到一次write
+  if (!flushQueued_) {
+    flushQueued_ = true;
+    loop_->queueInLoop(boost::bind(&RpcClient::flushIfAlive,
+                                   boost::weak_ptr<RpcClient *>(self_)));
+  }
+}
+
+void RpcClient::flushIfAlive(const boost::weak_ptr<RpcClient *> &self) {
+  boost::shared_ptr<RpcClient *> client(self.lock());
+  if (client) {
+    (*client)->flush();
+  }
+}
+
+void RpcClient::flush() {
+  flushQueued_ = false;
+  // 收到坏响应之后连接已经在关闭，没发出去的调用断开时一起失败
+  if (connected()) {
+    connection_->flushOutput();
+  }
+}
+
+void RpcClient::onConnection(const TcpConnectionPtr &conn) {
+  if (conn->connected()) {
+    conn->setTcpNoDelay(true);
+    connection_ = conn;
+  } else {
+    connection_.reset();
+    failAll(kRpcDisconnected);
+  }
+  if (connectionCallback_) {
+    connectionCallback_(conn);
+  }
+}
+
+void RpcClient::onFrame(const TcpConnectionPtr &conn, const StringPiece &frame,
+                        Timestamp) {
+  // 这一批里前面有坏帧，连接已经在关闭
+  if (!conn->connected()) {
+    return;
+  }
+  RpcCodec::Message response;
+  if (!RpcCodec::decode(frame, &response) ||
+      response.type != RpcCodec::kResponse) {
+    LOG_ERROR << "RpcClient::onFrame - bad response from " << conn->name();
+    conn->shutdown();
+    return;
+  }
+
+  CallMap::iterator it = calls_.find(response.callId);
+  if (it == calls_.end()) {
+    // 已经超时
+    LOG_DEBUG << "RpcClient::onFrame - unknown call " << response.callId;
+    return;
+  }
+  RpcCallback done;
+  done.swap(it->second.done);
+  if (it->second.hasTimer) {
+    loop_->cancel(it->second.timer);
+  }
+  calls_.erase(it);
+  done(response.status, response.payload);
+}
+
+void RpcClient::onTimeout(uint64_t callId) {
+  CallMap::iterator it = calls_.find(callId);
+  if (it != calls_.end()) {
+    RpcCallback done;
+    done.swap(it->second.done);
+    calls_.erase(it);
+    done(kRpcTimeout, StringPiece());
+  }
+}
+
+void RpcClient::failAll(RpcStatus status) {
+  CallMap calls;
+  calls.swap(calls_);
+  for (CallMap::iterator it = calls.begin(); it != calls.end(); ++it) {
+    if (it->second.hasTimer) {
+      loop_->cancel(it->second.timer);
+    }
+    it->second.done(status, StringPiece());
+  }
+}
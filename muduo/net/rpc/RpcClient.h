@@ -0,0 +1,95 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_RPC_RPCCLIENT_H
+#define MUDUO_NET_RPC_RPCCLIENT_H
+
+#include "LengthHeaderCodec.h"
+#include "RpcCodec.h"
+#include "TcpClient.h"
+#include "TimerId.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <map>
+
+namespace muduo {
+namespace net {
+
+///
+/// RPC客户端，一条连接上同时进行任意多个调用。
+///
+/// 每个调用分配一个64位callId，响应按callId匹配，可以乱序完成。
+/// 同一轮事件循环里发出的调用编码进输出缓冲区后合并成一次写。
+/// 超时由所在EventLoop的定时器驱动。
+///
+/// 除call()之外的成员函数都应当在IO线程中调用，对象也在IO线程中析构。
+/// 析构时还没有完成的调用以kRpcDisconnected完成。
+///
+class RpcClient : boost::noncopyable {
+public:
+  /// 在IO线程中调用。response只在回调期间有效；
+  /// 失败时status说明原因，kRpcMethodFailed时response是服务端的错误信息。
+  typedef boost::function<void(RpcStatus status, const StringPiece &response)>
+      RpcCallback;
+
+  RpcClient(EventLoop *loop, const InetAddress &serverAddr,
+            const string &name);
+  ~RpcClient();
+
+  void connect() { client_.connect(); }
+  void disconnect() { client_.disconnect(); }
+  void enableRetry() { client_.enableRetry(); }
+
+  void setConnectionCallback(const ConnectionCallback &cb) {
+    connectionCallback_ = cb;
+  }
+
+  bool connected() const { return connection_ && connection_->connected(); }
+
+  /// Thread safe.
+  /// timeout秒内没有收到响应时以kRpcTimeout完成，0表示不限时间。
+  /// 没有连接或者连接断开时以kRpcDisconnected完成。
+  void call(const StringPiece &method, const StringPiece &request,
+            const RpcCallback &done, double timeout = 0);
+
+  // 已经发出还没有完成的调用个数
+  size_t pendingCalls() const { return calls_.size(); }
+
+private:
+  struct Call {
+    RpcCallback done;
+    TimerId timer;
+    bool hasTimer;
+  };
+  typedef std::map<uint64_t, Call> CallMap;
+
+  static void callInLoop(const boost::weak_ptr<RpcClient *> &self,
+                         const string &method, const string &request,
+                         const RpcCallback &done, double timeout);
+  void startCall(const StringPiece &method, const StringPiece &request,
+                 const RpcCallback &done, double timeout);
+  void onConnection(const TcpConnectionPtr &conn);
+  void onFrame(const TcpConnectionPtr &conn, const StringPiece &frame,
+               Timestamp receiveTime);
+  void onTimeout(uint64_t callId);
+  static void flushIfAlive(const boost::weak_ptr<RpcClient *> &self);
+  void flush();
+  void failAll(RpcStatus status);
+
+  EventLoop *loop_;
+  TcpClient client_;
+  LengthHeaderCodec codec_;
+  ConnectionCallback connectionCallback_;
+  TcpConnectionPtr connection_;
+  uint64_t nextCallId_;
+  CallMap calls_;
+  bool flushQueued_;
+  // 排进loop的函数可能在析构之后才执行，用它判断client是否还在
+  boost::shared_ptr<RpcClient *> self_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_RPC_RPCCLIENT_H
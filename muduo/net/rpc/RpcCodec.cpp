@@ -0,0 +1,98 @@
+#include "RpcCodec.h"
+
+#include "Buffer.h"
+#include "Endian.h"
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace {
+
+const size_t kFixedLen = 1 + sizeof(uint64_t) + 1;
+
+void appendFixed(Buffer *output, size_t frameLen, char type, uint64_t callId,
+                 uint8_t last) {
+  char fixed[RpcCodec::kHeaderLen + kFixedLen];
+  uint32_t be32 = sockets::hostToNetwork32(static_cast<uint32_t>(frameLen));
+  uint64_t be64 = sockets::hostToNetwork64(callId);
+  ::memcpy(fixed, &be32, sizeof be32);
+  fixed[4] = type;
+  ::memcpy(fixed + 5, &be64, sizeof be64);
+  fixed[13] = static_cast<char>(last);
+  output->append(fixed, sizeof fixed);
+}
+
+} // namespace
+
+const char *muduo::net::rpcStatusName(RpcStatus status) {
+  switch (status) {
+  case kRpcOk:
+    return "OK";
+  case kRpcNoSuchMethod:
+    return "NoSuchMethod";
+  case kRpcMethodFailed:
+    return "MethodFailed";
+  case kRpcTimeout:
+    return "Timeout";
+  case kRpcDisconnected:
+    return "Disconnected";
+  case kRpcBadResponse:
+    return "BadResponse";
+  }
+  return "Unknown";
+}
+
+void RpcCodec::encodeRequest(Buffer *output, uint64_t callId,
+                             const StringPiece &method,
+                             const StringPiece &payload) {
+  assert(static_cast<size_t>(method.size()) <= kMaxMethodLen);
+  size_t frameLen = kFixedLen + method.size() + payload.size();
+  output->ensureWritableBytes(kHeaderLen + frameLen);
+  appendFixed(output, frameLen, kRequest, callId,
+              static_cast<uint8_t>(method.size()));
+  output->append(method);
+  output->append(payload);
+}
+
+void RpcCodec::encodeResponse(Buffer *output, uint64_t callId,
+                              RpcStatus status, const StringPiece &payload) {
+  size_t frameLen = kFixedLen + payload.size();
+  output->ensureWritableBytes(kHeaderLen + frameLen);
+  appendFixed(output, frameLen, kResponse, callId,
+              static_cast<uint8_t>(status));
+  output->append(payload);
+}
+
+bool RpcCodec::decode(const StringPiece &frame, Message *message) {
+  if (static_cast<size_t>(frame.size()) < kFixedLen) {
+    return false;
+  }
+  const char *p = frame.data();
+  const char *end = p + frame.size();
+  uint64_t be64 = 0;
+  ::memcpy(&be64, p + 1, sizeof be64);
+  message->callId = sockets::networkToHost64(be64);
+  uint8_t last = static_cast<uint8_t>(p[9]);
+  p += kFixedLen;
+
+  if (frame[0] == kRequest) {
+    if (end - p < last) {
+      return false;
+    }
+    message->type = kRequest;
+    message->method = StringPiece(p, last);
+    message->status = kRpcOk;
+    p += last;
+  } else if (frame[0] == kResponse) {
+    if (last > kRpcMethodFailed) {
+      return false;
+    }
+    message->type = kResponse;
+    message->method.clear();
+    message->status = static_cast<RpcStatus>(last);
+  } else {
+    return false;
+  }
+  message->payload = StringPiece(p, static_cast<int>(end - p));
+  return true;
+}
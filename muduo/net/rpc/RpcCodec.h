@@ -0,0 +1,66 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_RPC_RPCCODEC_H
+#define MUDUO_NET_RPC_RPCCODEC_H
+
+#include "StringPiece.h"
+
+#include <stdint.h>
+
+namespace muduo {
+namespace net {
+
+class Buffer;
+
+enum RpcStatus {
+  kRpcOk,
+  kRpcNoSuchMethod,
+  kRpcMethodFailed, // 方法返回false，响应内容是错误信息
+  kRpcTimeout,      // 以下由客户端本地产生
+  kRpcDisconnected,
+  kRpcBadResponse,
+};
+
+const char *rpcStatusName(RpcStatus status);
+
+///
+/// RPC的帧格式，外层由LengthHeaderCodec加4字节长度：
+///
+/// @code
+/// 请求  | 'Q' | callId (8) | methodLen (1) | method | payload |
+/// 响应  | 'R' | callId (8) | status (1)    | payload          |
+/// @endcode
+///
+/// 整数都是网络字节序。callId由客户端分配，服务端原样带回，
+/// 一个连接上可以有任意多个未完成的调用，响应可以乱序返回。
+///
+class RpcCodec {
+public:
+  static const int kHeaderLen = 4; // LengthHeaderCodec的长度头
+  static const size_t kMaxMethodLen = 255;
+
+  enum Type { kRequest = 'Q', kResponse = 'R' };
+
+  struct Message {
+    Type type;
+    uint64_t callId;
+    StringPiece method; // 只用于请求
+    RpcStatus status;   // 只用于响应
+    StringPiece payload;
+  };
+
+  // 直接追加到output，包括长度头
+  static void encodeRequest(Buffer *output, uint64_t callId,
+                            const StringPiece &method,
+                            const StringPiece &payload);
+  static void encodeResponse(Buffer *output, uint64_t callId,
+                             RpcStatus status, const StringPiece &payload);
+
+  // frame是去掉长度头之后的内容，格式不对时返回false
+  static bool decode(const StringPiece &frame, Message *message);
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_RPC_RPCCODEC_H
@@ -0,0 +1,98 @@
+#include "RpcServer.h"
+
+#include "EventLoop.h"
+#include "Logging.h"
+#include "ThreadPool.h"
+
+#include <boost/bind.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+RpcServer::RpcServer(EventLoop *loop, const InetAddress &listenAddr,
+                     const string &name)
+    : server_(loop, listenAddr, name),
+      codec_(boost::bind(&RpcServer::onFrame, this, _1, _2, _3),
+             RpcCodec::kHeaderLen),
+      workerThreads_(1) {
+  server_.setMessageCallback(
+      boost::bind(&RpcServer::onMessage, this, _1, _2, _3));
+}
+
+RpcServer::~RpcServer() {}
+
+void RpcServer::registerMethod(const string &name, const Method &method,
+                               Dispatch dispatch) {
+  assert(name.size() <= RpcCodec::kMaxMethodLen);
+  MethodEntry &entry = methods_[name];
+  entry.method = method;
+  entry.dispatch = dispatch;
+}
+
+void RpcServer::start() {
+  for (MethodMap::const_iterator it = methods_.begin(); it != methods_.end();
+       ++it) {
+    if (it->second.dispatch == kInPool && !pool_) {
+      pool_.reset(new ThreadPool(server_.name() + "Worker"));
+      pool_->start(workerThreads_);
+    }
+  }
+  server_.start();
+}
+
+void RpcServer::onMessage(const TcpConnectionPtr &conn, Buffer *buf,
+                          Timestamp receiveTime) {
+  codec_.onMessage(conn, buf, receiveTime);
+  // 这一批请求里在IO线程中完成的响应一次写出
+  conn->flushOutput();
+}
+
+void RpcServer::onFrame(const TcpConnectionPtr &conn, const StringPiece &frame,
+                        Timestamp) {
+  // 这一批里前面有坏帧，连接已经在关闭，后面的帧不再处理
+  if (!conn->connected()) {
+    return;
+  }
+  RpcCodec::Message request;
+  if (!RpcCodec::decode(frame, &request) ||
+      request.type != RpcCodec::kRequest) {
+    LOG_ERROR << "RpcServer::onFrame - bad request from " << conn->name();
+    // 先写出前面请求的响应，shutdown()等输出缓冲区写完再关闭写端
+    conn->flushOutput();
+    conn->shutdown();
+    return;
+  }
+
+  Buffer *output = conn->outputBuffer();
+  MethodMap::const_iterator it = methods_.find(request.method.as_string());
+  if (it == methods_.end()) {
+    RpcCodec::encodeResponse(output, request.callId, kRpcNoSuchMethod,
+                             request.method);
+  } else if (it->second.dispatch == kInPool) {
+    pool_->run(boost::bind(&RpcServer::runInPool, this, conn, &it->second,
+                           request.callId, request.payload.as_string()));
+  } else {
+    string response;
+    bool ok = it->second.method(request.payload, &response);
+    RpcCodec::encodeResponse(output, request.callId,
+                             ok ? kRpcOk : kRpcMethodFailed, response);
+  }
+}
+
+void RpcServer::runInPool(const TcpConnectionPtr &conn,
+                          const MethodEntry *entry, uint64_t callId,
+                          const string &request) {
+  string response;
+  bool ok = entry->method(request, &response);
+  conn->getLoop()->runInLoop(boost::bind(&RpcServer::sendResponse, this, conn,
+                                         callId, ok ? kRpcOk : kRpcMethodFailed,
+                                         response));
+}
+
+void RpcServer::sendResponse(const TcpConnectionPtr &conn, uint64_t callId,
+                             RpcStatus status, const string &response) {
+  if (conn->connected()) {
+    RpcCodec::encodeResponse(conn->outputBuffer(), callId, status, response);
+    conn->flushOutput();
+  }
+}
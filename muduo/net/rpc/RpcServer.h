@@ -0,0 +1,78 @@
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_RPC_RPCSERVER_H
+#define MUDUO_NET_RPC_RPCSERVER_H
+
+#include "LengthHeaderCodec.h"
+#include "RpcCodec.h"
+#include "TcpServer.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <map>
+
+namespace muduo {
+
+class ThreadPool;
+
+namespace net {
+
+///
+/// RPC服务端，按方法名分发请求，帧格式见RpcCodec。
+///
+/// 每个方法可以选择在IO线程里直接执行（适合很快的方法），或者交给
+/// 工作线程池执行（可能阻塞或耗时的方法）。IO线程里执行的方法，
+/// 一批请求的响应编码进输出缓冲区后一次写出。
+///
+class RpcServer : boost::noncopyable {
+public:
+  /// 返回false表示失败，调用方收到kRpcMethodFailed，*response是错误信息。
+  /// 在IO线程中执行时request指向输入缓冲区，只在调用期间有效。
+  typedef boost::function<bool(const StringPiece &request, string *response)>
+      Method;
+
+  enum Dispatch { kInLoop, kInPool };
+
+  RpcServer(EventLoop *loop, const InetAddress &listenAddr,
+            const string &name);
+  ~RpcServer(); // force out-line dtor, for scoped_ptr members.
+
+  /// IO线程数，见TcpServer::setThreadNum()。必须在start()之前调用
+  void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
+  /// kInPool方法使用的工作线程数，默认1。必须在start()之前调用
+  void setWorkerThreadNum(int numThreads) { workerThreads_ = numThreads; }
+
+  /// 必须在start()之前调用
+  void registerMethod(const string &name, const Method &method,
+                      Dispatch dispatch = kInLoop);
+
+  void start();
+
+private:
+  struct MethodEntry {
+    Method method;
+    Dispatch dispatch;
+  };
+  typedef std::map<string, MethodEntry> MethodMap;
+
+  void onMessage(const TcpConnectionPtr &conn, Buffer *buf,
+                 Timestamp receiveTime);
+  void onFrame(const TcpConnectionPtr &conn, const StringPiece &frame,
+               Timestamp receiveTime);
+  void runInPool(const TcpConnectionPtr &conn, const MethodEntry *entry,
+                 uint64_t callId, const string &request);
+  void sendResponse(const TcpConnectionPtr &conn, uint64_t callId,
+                    RpcStatus status, const string &response);
+
+  TcpServer server_;
+  LengthHeaderCodec codec_;
+  MethodMap methods_;
+  boost::scoped_ptr<ThreadPool> pool_;
+  int workerThreads_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif // MUDUO_NET_RPC_RPCSERVER_H